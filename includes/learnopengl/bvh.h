@@ -0,0 +1,497 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/entity.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// axis aligned box given by its corners, the form the tree merges and compares
+struct BVHBox
+{
+    glm::vec3 min{ 0.f };
+    glm::vec3 max{ 0.f };
+
+    BVHBox() = default;
+
+    BVHBox(const glm::vec3& inMin, const glm::vec3& inMax) : min{ inMin }, max{ inMax }
+    {}
+
+    // the world box of an entity, see Entity::getGlobalAABB
+    static BVHBox fromAABB(const AABB& box)
+    {
+        return BVHBox(box.center - box.extents, box.center + box.extents);
+    }
+
+    BVHBox merged(const BVHBox& other) const
+    {
+        return BVHBox(glm::min(min, other.min), glm::max(max, other.max));
+    }
+
+    BVHBox expanded(const glm::vec3& margin) const
+    {
+        return BVHBox(min - margin, max + margin);
+    }
+
+    bool contains(const BVHBox& other) const
+    {
+        return glm::all(glm::lessThanEqual(min, other.min)) && glm::all(glm::lessThanEqual(other.max, max));
+    }
+
+    glm::vec3 center() const
+    {
+        return (min + max) * 0.5f;
+    }
+
+    glm::vec3 extents() const
+    {
+        return (max - min) * 0.5f;
+    }
+
+    // the cost of a node for the insertion heuristic, proportional to the chance a random ray hits it
+    float surfaceArea() const
+    {
+        const glm::vec3 size = max - min;
+        return 2.f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    bool overlapsSphere(const glm::vec3& sphereCenter, float radius) const
+    {
+        const glm::vec3 offset = glm::clamp(sphereCenter, min, max) - sphereCenter;
+        return glm::dot(offset, offset) <= radius * radius;
+    }
+
+    // slab test, distance is where the ray enters the box (0 when it starts inside)
+    bool intersectsRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, float& distance) const
+    {
+        const glm::vec3 t1 = (min - origin) * inverseDirection;
+        const glm::vec3 t2 = (max - origin) * inverseDirection;
+        const glm::vec3 tMin = glm::min(t1, t2);
+        const glm::vec3 tMax = glm::max(t1, t2);
+        const float enter = std::max(std::max(std::max(tMin.x, tMin.y), tMin.z), 0.f);
+        const float exit = std::min(std::min(std::min(tMax.x, tMax.y), tMax.z), maxDistance);
+        distance = enter;
+        return enter <= exit;
+    }
+};
+
+// what the tree did since the last reset
+struct BVHStats
+{
+    unsigned int nodesVisited = 0; // nodes whose box a query looked at
+    unsigned int reinserts = 0;    // updates that left their fat box and moved in the tree
+
+    void reset()
+    {
+        *this = BVHStats();
+    }
+
+    void print(std::ostream& out, const char* label) const
+    {
+        out << label << ": " << nodesVisited << " nodes visited, " << reinserts << " reinserts" << std::endl;
+    }
+};
+
+// A dynamic bounding volume hierarchy over world boxes, for culling and proximity queries without scanning
+// every entity. Every leaf keeps the box it was given and a fat box, the same box grown by margin of its
+// size on every side; internal nodes bound their children's fat boxes. Moving an entity only touches the tree
+// once its box leaves the fat box, then the leaf is taken out, put back next to the sibling that grows the
+// tree the least, and the boxes and heights above it are refit on the way up. Tree rotations on that path keep
+// the heights of any two siblings within one of each other, so queries stay logarithmic whatever the order of
+// the inserts.
+//
+// The proxy returned by insert() names a leaf until it is removed, the user data is reported by the queries.
+class DynamicBVH
+{
+public:
+    static constexpr int32_t NULL_NODE = -1;
+
+    BVHStats stats;
+
+    explicit DynamicBVH(float margin = 0.1f) : margin(margin)
+    {}
+
+    int32_t insert(const BVHBox& box, uint32_t userData)
+    {
+        const int32_t leaf = allocateNode();
+        Node& node = nodes[leaf];
+        node.box = fatten(box);
+        node.tight = box;
+        node.userData = userData;
+        node.height = 0;
+        insertLeaf(leaf);
+        proxies++;
+        return leaf;
+    }
+
+    void remove(int32_t proxy)
+    {
+        removeLeaf(proxy);
+        freeNode(proxy);
+        proxies--;
+    }
+
+    // gives a proxy its new box, returns whether the tree had to change
+    bool update(int32_t proxy, const BVHBox& box)
+    {
+        Node& node = nodes[proxy];
+        node.tight = box;
+        if (node.box.contains(box))
+            return false;
+        removeLeaf(proxy);
+        nodes[proxy].box = fatten(box);
+        insertLeaf(proxy);
+        stats.reinserts++;
+        return true;
+    }
+
+    uint32_t getUserData(int32_t proxy) const
+    {
+        return nodes[proxy].userData;
+    }
+
+    const BVHBox& getBox(int32_t proxy) const
+    {
+        return nodes[proxy].tight;
+    }
+
+    size_t size() const
+    {
+        return proxies;
+    }
+
+    int height() const
+    {
+        return root == NULL_NODE ? 0 : nodes[root].height;
+    }
+
+    // calls visit(userData) for every box on the frustum, the test of AABB::isOnFrustum. A node on the inner
+    // side of a plane skips that plane for its whole subtree, a node inside all six reports its leaves untested.
+    template <typename Visit>
+    void queryFrustum(const Frustum& frustum, Visit&& visit)
+    {
+        const Plane* planes[6] = { &frustum.leftFace, &frustum.rightFace, &frustum.topFace,
+                                   &frustum.bottomFace, &frustum.nearFace, &frustum.farFace };
+        if (root == NULL_NODE)
+            return;
+        planeStack.clear();
+        planeStack.emplace_back(root, 0x3Fu);
+        while (!planeStack.empty())
+        {
+            const int32_t index = planeStack.back().first;
+            unsigned int activePlanes = planeStack.back().second;
+            planeStack.pop_back();
+            const Node& node = nodes[index];
+            stats.nodesVisited++;
+            if (activePlanes == 0)
+            {
+                visitLeaves(index, visit);
+                continue;
+            }
+
+            const BVHBox& box = node.isLeaf() ? node.tight : node.box;
+            const glm::vec3 center = box.center();
+            const glm::vec3 extents = box.extents();
+            bool outside = false;
+            for (int i = 0; i < 6 && !outside; i++)
+            {
+                if (!(activePlanes & (1u << i)))
+                    continue;
+                const Plane& plane = *planes[i];
+                const float r = glm::dot(extents, glm::abs(plane.normal));
+                const float distance = plane.getSignedDistanceToPlane(center);
+                if (distance < -r)
+                    outside = true;
+                else if (distance >= r)
+                    activePlanes &= ~(1u << i);
+            }
+            if (outside)
+                continue;
+            if (node.isLeaf())
+                visit(node.userData);
+            else
+            {
+                planeStack.emplace_back(node.child1, activePlanes);
+                planeStack.emplace_back(node.child2, activePlanes);
+            }
+        }
+    }
+
+    // calls visit(userData) for every box touching the sphere
+    template <typename Visit>
+    void querySphere(const glm::vec3& center, float radius, Visit&& visit)
+    {
+        if (root == NULL_NODE)
+            return;
+        stack.clear();
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+            stats.nodesVisited++;
+            if (!(node.isLeaf() ? node.tight : node.box).overlapsSphere(center, radius))
+                continue;
+            if (node.isLeaf())
+                visit(node.userData);
+            else
+            {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+
+    // calls visit(userData, distance) for the boxes the ray enters within maxDistance, distance along
+    // direction (which needn't be normalized). visit returns the new maxDistance: the distance it was given
+    // keeps only closer boxes, maxDistance keeps all of them and 0 stops the query.
+    template <typename Visit>
+    void raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Visit&& visit)
+    {
+        if (root == NULL_NODE)
+            return;
+        const glm::vec3 inverseDirection = 1.f / direction;
+        stack.clear();
+        stack.push_back(root);
+        while (!stack.empty() && maxDistance > 0.f)
+        {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+            stats.nodesVisited++;
+            float distance = 0.f;
+            if (!(node.isLeaf() ? node.tight : node.box).intersectsRay(origin, inverseDirection, maxDistance, distance))
+                continue;
+            if (node.isLeaf())
+                maxDistance = std::min(maxDistance, static_cast<float>(visit(node.userData, distance)));
+            else
+            {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+
+private:
+    struct Node
+    {
+        BVHBox box;           // fat box of a leaf, union of the children otherwise
+        BVHBox tight;         // box given to insert() or update(), leaves only
+        int32_t parent = NULL_NODE; // next free node while on the free list
+        int32_t child1 = NULL_NODE;
+        int32_t child2 = NULL_NODE;
+        int32_t height = 0;   // 0 for leaves, -1 for free nodes
+        uint32_t userData = 0;
+
+        bool isLeaf() const
+        {
+            return child1 == NULL_NODE;
+        }
+    };
+
+    std::vector<Node> nodes;
+    int32_t root = NULL_NODE;
+    int32_t freeList = NULL_NODE;
+    size_t proxies = 0;
+    float margin;
+
+    // kept between queries so they don't allocate
+    std::vector<int32_t> stack;
+    std::vector<std::pair<int32_t, unsigned int>> planeStack;
+
+    BVHBox fatten(const BVHBox& box) const
+    {
+        return box.expanded((box.max - box.min) * margin);
+    }
+
+    int32_t allocateNode()
+    {
+        if (freeList == NULL_NODE)
+        {
+            nodes.emplace_back();
+            return static_cast<int32_t>(nodes.size() - 1);
+        }
+        const int32_t index = freeList;
+        freeList = nodes[index].parent;
+        nodes[index] = Node();
+        return index;
+    }
+
+    void freeNode(int32_t index)
+    {
+        nodes[index].parent = freeList;
+        nodes[index].height = -1;
+        freeList = index;
+    }
+
+    template <typename Visit>
+    void visitLeaves(int32_t index, Visit& visit)
+    {
+        const size_t bottom = stack.size();
+        stack.push_back(index);
+        while (stack.size() > bottom)
+        {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+            if (node.isLeaf())
+                visit(node.userData);
+            else
+            {
+                stack.push_back(node.child1);
+                stack.push_back(node.child2);
+            }
+        }
+    }
+
+    void insertLeaf(int32_t leaf)
+    {
+        if (root == NULL_NODE)
+        {
+            root = leaf;
+            nodes[leaf].parent = NULL_NODE;
+            return;
+        }
+
+        // walk down to the sibling whose union with the leaf adds the least surface area to the tree
+        const BVHBox leafBox = nodes[leaf].box;
+        int32_t index = root;
+        while (!nodes[index].isLeaf())
+        {
+            const Node& node = nodes[index];
+            const float area = node.box.surfaceArea();
+            const float combinedArea = node.box.merged(leafBox).surfaceArea();
+            // a new parent here costs its area, going further down makes this node grow anyway
+            const float cost = 2.f * combinedArea;
+            const float inheritedCost = 2.f * (combinedArea - area);
+            const float cost1 = descendCost(node.child1, leafBox) + inheritedCost;
+            const float cost2 = descendCost(node.child2, leafBox) + inheritedCost;
+            if (cost < cost1 && cost < cost2)
+                break;
+            index = cost1 < cost2 ? node.child1 : node.child2;
+        }
+
+        const int32_t sibling = index;
+        const int32_t oldParent = nodes[sibling].parent;
+        const int32_t newParent = allocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].box = leafBox.merged(nodes[sibling].box);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+        if (oldParent == NULL_NODE)
+            root = newParent;
+        else if (nodes[oldParent].child1 == sibling)
+            nodes[oldParent].child1 = newParent;
+        else
+            nodes[oldParent].child2 = newParent;
+
+        refitUpwards(nodes[leaf].parent);
+    }
+
+    float descendCost(int32_t child, const BVHBox& leafBox) const
+    {
+        const BVHBox merged = leafBox.merged(nodes[child].box);
+        if (nodes[child].isLeaf())
+            return merged.surfaceArea();
+        return merged.surfaceArea() - nodes[child].box.surfaceArea();
+    }
+
+    void removeLeaf(int32_t leaf)
+    {
+        if (leaf == root)
+        {
+            root = NULL_NODE;
+            return;
+        }
+        const int32_t parent = nodes[leaf].parent;
+        const int32_t grandParent = nodes[parent].parent;
+        const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+        freeNode(parent);
+        if (grandParent == NULL_NODE)
+        {
+            root = sibling;
+            nodes[sibling].parent = NULL_NODE;
+            return;
+        }
+        if (nodes[grandParent].child1 == parent)
+            nodes[grandParent].child1 = sibling;
+        else
+            nodes[grandParent].child2 = sibling;
+        nodes[sibling].parent = grandParent;
+        refitUpwards(grandParent);
+    }
+
+    // rebalances and recomputes box and height of index and every node above it
+    void refitUpwards(int32_t index)
+    {
+        while (index != NULL_NODE)
+        {
+            index = balance(index);
+            Node& node = nodes[index];
+            node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+            node.box = nodes[node.child1].box.merged(nodes[node.child2].box);
+            index = node.parent;
+        }
+    }
+
+    // if one child of a is two levels taller than the other, rotates it up in place of a; returns the node
+    // now at a's place
+    int32_t balance(int32_t a)
+    {
+        Node& nodeA = nodes[a];
+        if (nodeA.isLeaf() || nodeA.height < 2)
+            return a;
+        const int32_t b = nodeA.child1;
+        const int32_t c = nodeA.child2;
+        const int32_t difference = nodes[c].height - nodes[b].height;
+        if (difference > 1)
+            return rotateUp(a, c, b, false);
+        if (difference < -1)
+            return rotateUp(a, b, c, true);
+        return a;
+    }
+
+    // child takes a's place, a keeps other and the shorter child of child, child keeps a and its taller child
+    int32_t rotateUp(int32_t a, int32_t child, int32_t other, bool childIsFirst)
+    {
+        Node& nodeA = nodes[a];
+        Node& nodeChild = nodes[child];
+        const int32_t f = nodeChild.child1;
+        const int32_t g = nodeChild.child2;
+        const bool fTaller = nodes[f].height > nodes[g].height;
+        const int32_t taller = fTaller ? f : g;
+        const int32_t shorter = fTaller ? g : f;
+
+        nodeChild.child1 = a;
+        nodeChild.parent = nodeA.parent;
+        nodeA.parent = child;
+        if (nodeChild.parent == NULL_NODE)
+            root = child;
+        else if (nodes[nodeChild.parent].child1 == a)
+            nodes[nodeChild.parent].child1 = child;
+        else
+            nodes[nodeChild.parent].child2 = child;
+
+        nodeChild.child2 = taller;
+        if (childIsFirst)
+            nodeA.child1 = shorter;
+        else
+            nodeA.child2 = shorter;
+        nodes[shorter].parent = a;
+
+        nodeA.box = nodes[other].box.merged(nodes[shorter].box);
+        nodeA.height = 1 + std::max(nodes[other].height, nodes[shorter].height);
+        nodeChild.box = nodeA.box.merged(nodes[taller].box);
+        nodeChild.height = 1 + std::max(nodeA.height, nodes[taller].height);
+        return child;
+    }
+};
+#endif
@@ -0,0 +1,486 @@
+#ifndef ECS_H
+#define ECS_H
+
+#include <learnopengl/job_system.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// bytes of one chunk, the rows of an archetype are packed into as many as it needs
+#define ECS_CHUNK_BYTES (16 * 1024)
+// component types a program can register, one bit each in a ComponentMask
+#define ECS_MAX_COMPONENTS 64
+
+typedef uint64_t ComponentMask;
+
+// names an entity of a World; the generation tells a destroyed entity from a newer one reusing its index
+struct EntityId
+{
+    uint32_t index = ~0u;
+    uint32_t generation = 0;
+
+    bool operator==(const EntityId& other) const
+    {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!=(const EntityId& other) const
+    {
+        return !(*this == other);
+    }
+};
+
+// Components are plain structs: rows are moved between chunks with memcpy and never constructed or destroyed,
+// so they must be trivially copyable. Each type gets a small id the first time it's used.
+class ComponentRegistry
+{
+public:
+    struct Info
+    {
+        size_t size = 0;
+        size_t alignment = 0;
+    };
+
+    template <typename T>
+    static unsigned int id()
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "ECS components are copied with memcpy");
+        static const unsigned int value = add(sizeof(T), alignof(T));
+        return value;
+    }
+
+    template <typename T>
+    static ComponentMask bit()
+    {
+        return ComponentMask(1) << id<T>();
+    }
+
+    static Info info(unsigned int component)
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        return infos()[component];
+    }
+
+private:
+    static unsigned int add(size_t size, size_t alignment)
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        if (infos().size() == ECS_MAX_COMPONENTS)
+        {
+            std::cout << "ERROR::ECS:: more than " << ECS_MAX_COMPONENTS << " component types" << std::endl;
+            std::abort();
+        }
+        infos().push_back({ size, alignment });
+        return static_cast<unsigned int>(infos().size() - 1);
+    }
+
+    static std::vector<Info>& infos()
+    {
+        static std::vector<Info> registered;
+        return registered;
+    }
+
+    static std::mutex& mutex()
+    {
+        static std::mutex lock;
+        return lock;
+    }
+};
+
+// All entities with exactly the same set of components. Their rows live in chunks of ECS_CHUNK_BYTES, where
+// every component has its own contiguous array, followed by the ids of the entities, so a system reading two
+// components walks two arrays front to back. Rows are kept packed: removing one moves the last row of the
+// last chunk into the hole, so every chunk but the last is full.
+class Archetype
+{
+public:
+    const ComponentMask mask;
+    size_t capacity = 0; // rows per chunk
+
+    explicit Archetype(ComponentMask mask) : mask(mask)
+    {
+        std::fill(std::begin(columnOf), std::end(columnOf), -1);
+        size_t rowBytes = sizeof(EntityId);
+        for (unsigned int component = 0; component < ECS_MAX_COMPONENTS; component++)
+        {
+            if (!(mask & (ComponentMask(1) << component)))
+                continue;
+            columnOf[component] = static_cast<int>(columns.size());
+            const ComponentRegistry::Info info = ComponentRegistry::info(component);
+            columns.push_back({ component, info.size, info.alignment, 0 });
+            rowBytes += info.size;
+        }
+        // room for aligning every array, then as many rows as fit
+        size_t padding = alignof(EntityId);
+        for (const Column& column : columns)
+            padding += column.alignment;
+        capacity = std::max<size_t>(1, (ECS_CHUNK_BYTES - padding) / rowBytes);
+        size_t offset = 0;
+        for (Column& column : columns)
+        {
+            offset = (offset + column.alignment - 1) / column.alignment * column.alignment;
+            column.offset = offset;
+            offset += column.size * capacity;
+        }
+        entityOffset = (offset + alignof(EntityId) - 1) / alignof(EntityId) * alignof(EntityId);
+        chunkBytes = std::max<size_t>(ECS_CHUNK_BYTES, entityOffset + sizeof(EntityId) * capacity);
+    }
+
+    size_t size() const
+    {
+        return rows;
+    }
+
+    size_t chunkCount() const
+    {
+        return chunks.size();
+    }
+
+    // rows used in a chunk
+    size_t chunkSize(size_t chunk) const
+    {
+        return chunk + 1 < chunks.size() ? capacity : rows - chunk * capacity;
+    }
+
+    bool hasComponent(unsigned int component) const
+    {
+        return columnOf[component] >= 0;
+    }
+
+    void* column(size_t chunk, unsigned int component)
+    {
+        return chunks[chunk].get() + columns[columnOf[component]].offset;
+    }
+
+    template <typename T>
+    T* column(size_t chunk)
+    {
+        return static_cast<T*>(column(chunk, ComponentRegistry::id<T>()));
+    }
+
+    EntityId* entities(size_t chunk)
+    {
+        return reinterpret_cast<EntityId*>(chunks[chunk].get() + entityOffset);
+    }
+
+    void* component(size_t row, unsigned int component)
+    {
+        return static_cast<unsigned char*>(column(row / capacity, component)) + (row % capacity) * columns[columnOf[component]].size;
+    }
+
+    // appends an uninitialized row for entity, returns its index
+    size_t addRow(EntityId entity)
+    {
+        if (rows == chunks.size() * capacity)
+            chunks.emplace_back(new unsigned char[chunkBytes]);
+        const size_t row = rows++;
+        entities(row / capacity)[row % capacity] = entity;
+        return row;
+    }
+
+    // copies the components both archetypes have from row of source into row of this one
+    void copyRow(size_t row, Archetype& source, size_t sourceRow)
+    {
+        for (const Column& column : columns)
+        {
+            if (source.hasComponent(column.component))
+                std::memcpy(component(row, column.component), source.component(sourceRow, column.component), column.size);
+        }
+    }
+
+    // removes row by moving the last row into it, returns the entity that moved there (an invalid id if none did)
+    EntityId removeRow(size_t row)
+    {
+        const size_t last = rows - 1;
+        EntityId moved;
+        if (row != last)
+        {
+            for (const Column& column : columns)
+                std::memcpy(component(row, column.component), component(last, column.component), column.size);
+            moved = entities(last / capacity)[last % capacity];
+            entities(row / capacity)[row % capacity] = moved;
+        }
+        rows--;
+        if (rows <= (chunks.size() - 1) * capacity)
+            chunks.pop_back();
+        return moved;
+    }
+
+private:
+    struct Column
+    {
+        unsigned int component;
+        size_t size;
+        size_t alignment;
+        size_t offset;
+    };
+
+    std::vector<Column> columns;
+    int columnOf[ECS_MAX_COMPONENTS];
+    size_t entityOffset = 0;
+    size_t chunkBytes = 0;
+    std::vector<std::unique_ptr<unsigned char[]>> chunks;
+    size_t rows = 0;
+};
+
+// one chunk of an archetype as seen by a system
+struct ChunkView
+{
+    Archetype* archetype = nullptr;
+    size_t chunk = 0;
+    size_t count = 0;
+
+    template <typename T>
+    T* column() const
+    {
+        return archetype->column<T>(chunk);
+    }
+
+    EntityId* entities() const
+    {
+        return archetype->entities(chunk);
+    }
+};
+
+// Entities are ids into archetypes, components are looked up by type. Systems don't visit entities one by one,
+// they ask for the chunks of every archetype holding the components they need and loop over the arrays.
+// Structural changes (create, destroy, add, remove) move rows around, they must not happen while a system
+// walks the chunks: collect the ids and apply them afterwards.
+class World
+{
+public:
+    World() = default;
+    World(const World&) = delete;
+    World& operator=(const World&) = delete;
+
+    template <typename... Components>
+    EntityId create(const Components&... components)
+    {
+        const EntityId entity = allocateId();
+        Archetype& archetype = archetypeFor(maskOf<Components...>());
+        const size_t row = archetype.addRow(entity);
+        int expand[] = { 0, (write(archetype, row, components), 0)... };
+        (void)expand;
+        records[entity.index].archetype = &archetype;
+        records[entity.index].row = row;
+        return entity;
+    }
+
+    void destroy(EntityId entity)
+    {
+        if (!isAlive(entity))
+            return;
+        Record& record = records[entity.index];
+        const EntityId moved = record.archetype->removeRow(record.row);
+        if (moved.index != ~0u)
+            records[moved.index].row = record.row;
+        record.archetype = nullptr;
+        record.generation++;
+        freeIndices.push_back(entity.index);
+        alive--;
+    }
+
+    bool isAlive(EntityId entity) const
+    {
+        return entity.index < records.size() && records[entity.index].generation == entity.generation &&
+            records[entity.index].archetype != nullptr;
+    }
+
+    // the component of a live entity, nullptr if it doesn't have one
+    template <typename T>
+    T* get(EntityId entity)
+    {
+        if (!isAlive(entity))
+            return nullptr;
+        const Record& record = records[entity.index];
+        const unsigned int component = ComponentRegistry::id<T>();
+        if (!record.archetype->hasComponent(component))
+            return nullptr;
+        return static_cast<T*>(record.archetype->component(record.row, component));
+    }
+
+    template <typename T>
+    bool has(EntityId entity) const
+    {
+        return isAlive(entity) && records[entity.index].archetype->hasComponent(ComponentRegistry::id<T>());
+    }
+
+    // adds or overwrites a component, the entity moves to the archetype with it
+    template <typename T>
+    void add(EntityId entity, const T& value)
+    {
+        if (!isAlive(entity))
+            return;
+        if (T* existing = get<T>(entity))
+        {
+            *existing = value;
+            return;
+        }
+        move(entity, records[entity.index].archetype->mask | ComponentRegistry::bit<T>());
+        write(*records[entity.index].archetype, records[entity.index].row, value);
+    }
+
+    template <typename T>
+    void remove(EntityId entity)
+    {
+        if (has<T>(entity))
+            move(entity, records[entity.index].archetype->mask & ~ComponentRegistry::bit<T>());
+    }
+
+    // live entities
+    size_t size() const
+    {
+        return alive;
+    }
+
+    size_t archetypeCount() const
+    {
+        return archetypes.size();
+    }
+
+    // replaces views with the chunks of every archetype that has all of Components, in a fixed order
+    template <typename... Components>
+    void chunks(std::vector<ChunkView>& views)
+    {
+        const ComponentMask required = maskOf<Components...>();
+        views.clear();
+        for (const std::unique_ptr<Archetype>& archetype : archetypes)
+        {
+            if ((archetype->mask & required) != required)
+                continue;
+            for (size_t chunk = 0; chunk < archetype->chunkCount(); chunk++)
+                views.push_back({ archetype.get(), chunk, archetype->chunkSize(chunk) });
+        }
+    }
+
+    // entities having all of Components
+    template <typename... Components>
+    size_t count() const
+    {
+        const ComponentMask required = maskOf<Components...>();
+        size_t total = 0;
+        for (const std::unique_ptr<Archetype>& archetype : archetypes)
+        {
+            if ((archetype->mask & required) == required)
+                total += archetype->size();
+        }
+        return total;
+    }
+
+    // calls body(count, ids, arrays...) for every chunk holding all of Components, spread over jobs when given.
+    // Chunks of one call never overlap, a body only has to be safe against other chunks of itself.
+    template <typename... Components, typename Body>
+    void each(JobSystem* jobs, Body&& body)
+    {
+        std::vector<ChunkView>& views = scratchViews();
+        chunks<Components...>(views);
+        viewDepth++;
+        const auto range = [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; i++)
+                body(views[i].count, views[i].entities(), views[i].template column<Components>()...);
+        };
+        if (jobs)
+            jobs->parallelFor(views.size(), 1, range);
+        else
+            range(0, views.size());
+        viewDepth--;
+    }
+
+    template <typename... Components, typename Body>
+    void each(Body&& body)
+    {
+        each<Components...>(nullptr, std::forward<Body>(body));
+    }
+
+private:
+    struct Record
+    {
+        Archetype* archetype = nullptr;
+        size_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    std::vector<Record> records;
+    std::vector<uint32_t> freeIndices;
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<ComponentMask, Archetype*> archetypeByMask;
+    std::vector<std::vector<ChunkView>> viewPool; // one list per nested each()
+    size_t viewDepth = 0;
+    size_t alive = 0;
+
+    template <typename... Components>
+    static ComponentMask maskOf()
+    {
+        ComponentMask mask = 0;
+        int expand[] = { 0, (mask |= ComponentRegistry::bit<Components>(), 0)... };
+        (void)expand;
+        return mask;
+    }
+
+    template <typename T>
+    static void write(Archetype& archetype, size_t row, const T& value)
+    {
+        std::memcpy(archetype.component(row, ComponentRegistry::id<T>()), &value, sizeof(T));
+    }
+
+    EntityId allocateId()
+    {
+        EntityId entity;
+        if (!freeIndices.empty())
+        {
+            entity.index = freeIndices.back();
+            freeIndices.pop_back();
+        }
+        else
+        {
+            entity.index = static_cast<uint32_t>(records.size());
+            records.emplace_back();
+        }
+        entity.generation = records[entity.index].generation;
+        alive++;
+        return entity;
+    }
+
+    Archetype& archetypeFor(ComponentMask mask)
+    {
+        auto found = archetypeByMask.find(mask);
+        if (found != archetypeByMask.end())
+            return *found->second;
+        archetypes.push_back(std::make_unique<Archetype>(mask));
+        archetypeByMask[mask] = archetypes.back().get();
+        return *archetypes.back();
+    }
+
+    // moves the row of entity to the archetype of mask, keeping the components both have
+    void move(EntityId entity, ComponentMask mask)
+    {
+        Record& record = records[entity.index];
+        Archetype& source = *record.archetype;
+        Archetype& target = archetypeFor(mask);
+        const size_t row = target.addRow(entity);
+        target.copyRow(row, source, record.row);
+        const EntityId moved = source.removeRow(record.row);
+        if (moved.index != ~0u)
+            records[moved.index].row = record.row;
+        record.archetype = &target;
+        record.row = row;
+    }
+
+    // each() can be called from inside the body of another, every depth gets its own list
+    std::vector<ChunkView>& scratchViews()
+    {
+        if (viewPool.size() <= viewDepth)
+            viewPool.emplace_back();
+        return viewPool[viewDepth];
+    }
+};
+#endif
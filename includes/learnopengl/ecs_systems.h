@@ -0,0 +1,328 @@
+#ifndef ECS_SYSTEMS_H
+#define ECS_SYSTEMS_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/ecs.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/job_system.h>
+#include <learnopengl/render_queue.h>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// The components and systems the ECS demos share. Transforms are flat: an entity's world matrix is built from
+// its own LocalTransform only, there is no parent component. Every system walks the chunks of the archetypes
+// holding what it reads and writes, and takes an optional JobSystem to spread the chunks over.
+
+// components
+// ----------
+struct LocalTransform
+{
+    glm::vec3 position{ 0.0f };
+    glm::quat rotation{ 1.0f, 0.0f, 0.0f, 0.0f };
+    glm::vec3 scale{ 1.0f };
+};
+
+struct WorldTransform
+{
+    glm::mat4 matrix{ 1.0f };
+};
+
+// box in model space, usually a Model's bounds
+struct LocalBounds
+{
+    glm::vec3 center{ 0.0f };
+    glm::vec3 extents{ 0.0f };
+};
+
+// box in world space around the transformed LocalBounds
+struct WorldBounds
+{
+    glm::vec3 center{ 0.0f };
+    glm::vec3 extents{ 0.0f };
+};
+
+struct Visibility
+{
+    bool visible = true;
+    unsigned char cullPlane = 0; // plane that rejected the box last frame, tested first
+};
+
+// turns the rotation around axis, starting from base
+struct Spin
+{
+    glm::vec3 axis{ 0.0f, 1.0f, 0.0f };
+    float degreesPerSecond = 0.0f;
+    glm::quat base{ 1.0f, 0.0f, 0.0f, 0.0f };
+};
+
+// bounces the height between baseHeight and baseHeight + amplitude
+struct Bob
+{
+    float baseHeight = 0.0f;
+    float amplitude = 0.0f;
+    float frequency = 1.0f;
+    float phase = 0.0f;
+};
+
+// What to draw for an entity: a Model, or count vertices of a vertex array when model is null. Instanced
+// renderables sharing a model, shader and texture are drawn with one instanced draw per mesh, tinted by color.
+struct Renderable
+{
+    Model* model = nullptr;
+    Shader* shader = nullptr;
+    unsigned int texture = 0;
+    unsigned int VAO = 0;
+    int count = 0;
+    glm::vec4 color{ 1.0f };
+    bool instanced = false;
+};
+
+namespace EcsSystems
+{
+    // spins and bobs at time seconds
+    inline void animate(World& world, float time, JobSystem* jobs = nullptr)
+    {
+        world.each<LocalTransform, Spin>(jobs, [time](size_t count, const EntityId*, LocalTransform* locals, const Spin* spins)
+        {
+            for (size_t i = 0; i < count; i++)
+                locals[i].rotation = glm::angleAxis(glm::radians(spins[i].degreesPerSecond * time), spins[i].axis) * spins[i].base;
+        });
+        world.each<LocalTransform, Bob>(jobs, [time](size_t count, const EntityId*, LocalTransform* locals, const Bob* bobs)
+        {
+            for (size_t i = 0; i < count; i++)
+                locals[i].position.y = bobs[i].baseHeight + std::fabs(std::sin(time * bobs[i].frequency + bobs[i].phase)) * bobs[i].amplitude;
+        });
+    }
+
+    // translation * rotation * scale, written into the columns directly
+    inline void updateTransforms(World& world, JobSystem* jobs = nullptr)
+    {
+        world.each<LocalTransform, WorldTransform>(jobs, [](size_t count, const EntityId*, const LocalTransform* locals, WorldTransform* worlds)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const glm::mat3 rotation = glm::mat3_cast(locals[i].rotation);
+                glm::mat4& matrix = worlds[i].matrix;
+                matrix[0] = glm::vec4(rotation[0] * locals[i].scale.x, 0.0f);
+                matrix[1] = glm::vec4(rotation[1] * locals[i].scale.y, 0.0f);
+                matrix[2] = glm::vec4(rotation[2] * locals[i].scale.z, 0.0f);
+                matrix[3] = glm::vec4(locals[i].position, 1.0f);
+            }
+        });
+    }
+
+    // the world box of a transformed box reaches |M| * extents from the transformed center
+    inline void updateBounds(World& world, JobSystem* jobs = nullptr)
+    {
+        world.each<WorldTransform, LocalBounds, WorldBounds>(jobs, [](size_t count, const EntityId*, const WorldTransform* worlds,
+                                                                      const LocalBounds* locals, WorldBounds* bounds)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const glm::mat4& matrix = worlds[i].matrix;
+                bounds[i].center = glm::vec3(matrix * glm::vec4(locals[i].center, 1.0f));
+                const glm::mat3 absolute(glm::abs(glm::vec3(matrix[0])), glm::abs(glm::vec3(matrix[1])), glm::abs(glm::vec3(matrix[2])));
+                bounds[i].extents = absolute * locals[i].extents;
+            }
+        });
+    }
+}
+
+// Sets Visibility from the world boxes with the coherent test of AABB, the plane that rejected a box last frame
+// is tested first. The counters of every chunk are kept apart and summed after the loop.
+class CullingSystem
+{
+public:
+    CullingStats stats;
+
+    void run(World& world, const Frustum& frustum, JobSystem* jobs = nullptr)
+    {
+        world.chunks<WorldBounds, Visibility>(views);
+        chunkStats.assign(views.size(), CullingStats());
+        currentFrustum = &frustum;
+        const auto cullChunks = [this](size_t first, size_t last)
+        {
+            for (size_t chunk = first; chunk < last; chunk++)
+                cullChunk(chunk);
+        };
+        if (jobs)
+            jobs->parallelFor(views.size(), 1, cullChunks);
+        else
+            cullChunks(0, views.size());
+
+        stats.reset();
+        for (const CullingStats& chunk : chunkStats)
+            stats.add(chunk);
+    }
+
+private:
+    std::vector<ChunkView> views;
+    std::vector<CullingStats> chunkStats;
+    const Frustum* currentFrustum = nullptr;
+
+    void cullChunk(size_t index)
+    {
+        const ChunkView& view = views[index];
+        const WorldBounds* bounds = view.column<WorldBounds>();
+        Visibility* visibility = view.column<Visibility>();
+        CullingStats& counters = chunkStats[index];
+        for (size_t i = 0; i < view.count; i++)
+        {
+            counters.entities++;
+            unsigned int planes = BoundingVolume::allPlanes;
+            const AABB box(bounds[i].center, bounds[i].extents.x, bounds[i].extents.y, bounds[i].extents.z);
+            visibility[i].visible = box.isOnFrustum(*currentFrustum, planes, visibility[i].cullPlane, counters);
+        }
+    }
+};
+
+// Turns the visible renderables into draws. extract collects them chunk by chunk on the jobs and merges the
+// chunks in order on the calling thread: instanced renderables become the instances of one batch per model,
+// shader and texture, the others single draws. It makes no GL calls, submit uploads the batches and queues
+// everything on the GL thread.
+class RenderExtraction
+{
+public:
+    struct Draw
+    {
+        const Renderable* renderable = nullptr;
+        glm::mat4 matrix{ 1.0f };
+    };
+
+    struct Batch
+    {
+        Model* model = nullptr;
+        Shader* shader = nullptr;
+        unsigned int texture = 0;
+        std::vector<InstanceData> instances;
+    };
+
+    // the last extraction
+    std::vector<Draw> draws;      // not instanced
+    std::vector<Batch> batches;   // kept between frames, a batch with no instances isn't drawn
+
+    void extract(World& world, JobSystem* jobs = nullptr)
+    {
+        world.chunks<WorldTransform, Renderable, Visibility>(views);
+        chunkDraws.resize(views.size());
+        const auto extractChunks = [this](size_t first, size_t last)
+        {
+            for (size_t chunk = first; chunk < last; chunk++)
+                extractChunk(chunk);
+        };
+        if (jobs)
+            jobs->parallelFor(views.size(), 1, extractChunks);
+        else
+            extractChunks(0, views.size());
+
+        draws.clear();
+        for (Batch& batch : batches)
+            batch.instances.clear();
+        for (size_t chunk = 0; chunk < views.size(); chunk++)
+        {
+            for (const Draw& draw : chunkDraws[chunk])
+            {
+                if (!draw.renderable->instanced)
+                {
+                    draws.push_back(draw);
+                    continue;
+                }
+                InstanceData instance;
+                instance.model = draw.matrix;
+                instance.color = draw.renderable->color;
+                batchFor(*draw.renderable).instances.push_back(instance);
+            }
+        }
+    }
+
+    // draws and instances of the last extraction
+    size_t drawCount() const
+    {
+        size_t count = draws.size();
+        for (const Batch& batch : batches)
+            count += batch.instances.size();
+        return count;
+    }
+
+    void submit(RenderQueue& queue)
+    {
+        while (buffers.size() < batches.size())
+            buffers.push_back(std::make_unique<InstanceBuffer>());
+        for (size_t i = 0; i < batches.size(); i++)
+        {
+            const Batch& batch = batches[i];
+            if (batch.instances.empty())
+                continue;
+            buffers[i]->upload(batch.instances);
+            DrawPacket packet;
+            packet.texture = batch.texture;
+            packet.instances = buffers[i].get();
+            batch.model->Submit(queue, *batch.shader, packet);
+        }
+        for (const Draw& draw : draws)
+        {
+            const Renderable& renderable = *draw.renderable;
+            DrawPacket packet;
+            packet.shader = renderable.shader;
+            packet.texture = renderable.texture;
+            packet.model = draw.matrix;
+            if (renderable.model)
+            {
+                renderable.model->Submit(queue, *renderable.shader, packet);
+                continue;
+            }
+            packet.VAO = renderable.VAO;
+            packet.count = renderable.count;
+            queue.submit(packet);
+        }
+    }
+
+    // the upload counters of every batch
+    void printUploadStats(std::ostream& out, const char* label)
+    {
+        for (std::unique_ptr<InstanceBuffer>& buffer : buffers)
+        {
+            buffer->stream.stats.print(out, label);
+            buffer->stream.stats.reset();
+        }
+    }
+
+private:
+    std::vector<ChunkView> views;
+    std::vector<std::vector<Draw>> chunkDraws;
+    std::vector<std::unique_ptr<InstanceBuffer>> buffers; // one per batch, created by submit on the GL thread
+
+    // the Renderable pointers stay valid until the next structural change of the world
+    void extractChunk(size_t index)
+    {
+        const ChunkView& view = views[index];
+        const WorldTransform* worlds = view.column<WorldTransform>();
+        const Renderable* renderables = view.column<Renderable>();
+        const Visibility* visibility = view.column<Visibility>();
+        std::vector<Draw>& out = chunkDraws[index];
+        out.clear();
+        for (size_t i = 0; i < view.count; i++)
+        {
+            if (visibility[i].visible)
+                out.push_back({ &renderables[i], worlds[i].matrix });
+        }
+    }
+
+    Batch& batchFor(const Renderable& renderable)
+    {
+        for (Batch& batch : batches)
+        {
+            if (batch.model == renderable.model && batch.shader == renderable.shader && batch.texture == renderable.texture)
+                return batch;
+        }
+        batches.push_back({ renderable.model, renderable.shader, renderable.texture, {} });
+        return batches.back();
+    }
+};
+#endif
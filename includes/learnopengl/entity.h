@@ -2,48 +2,84 @@
 #define ENTITY_H
 
 #include <glm/glm.hpp> //glm::mat4
+#include <glm/gtc/quaternion.hpp> //glm::quat
 #include <list> //std::list
 #include <array> //std::array
 #include <memory> //std::unique_ptr
+#include <ostream> //std::ostream
+
+#include <learnopengl/indirect_renderer.h>
+#include <learnopengl/lod.h>
 
 class Transform
 {
 protected:
 	//Local space information
 	glm::vec3 m_pos = { 0.0f, 0.0f, 0.0f };
-	glm::vec3 m_eulerRot = { 0.0f, 0.0f, 0.0f }; //In degrees
+	glm::quat m_rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 m_eulerRot = { 0.0f, 0.0f, 0.0f }; //In degrees, the same rotation as m_rotation
 	glm::vec3 m_scale = { 1.0f, 1.0f, 1.0f };
 
 	//Global space information concatenate in matrix
 	glm::mat4 m_modelMatrix = glm::mat4(1.0f);
+	//Length of its first three columns, computed with it
+	glm::vec3 m_globalScale = { 1.0f, 1.0f, 1.0f };
 
 	//Dirty flag
 	bool m_isDirty = true;
 
 protected:
-	glm::mat4 getLocalModelMatrix()
+	glm::mat4 getLocalModelMatrix() const
+	{
+		// translation * rotation * scale (also know as TRS matrix), written into the columns directly
+		const glm::mat3 rotationMatrix = glm::mat3_cast(m_rotation);
+		glm::mat4 local(1.0f);
+		local[0] = glm::vec4(rotationMatrix[0] * m_scale.x, 0.0f);
+		local[1] = glm::vec4(rotationMatrix[1] * m_scale.y, 0.0f);
+		local[2] = glm::vec4(rotationMatrix[2] * m_scale.z, 0.0f);
+		local[3] = glm::vec4(m_pos, 1.0f);
+		return local;
+	}
+
+	void updateGlobalScale()
 	{
-		const glm::mat4 transformX = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		const glm::mat4 transformY = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		const glm::mat4 transformZ = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.z), glm::vec3(0.0f, 0.0f, 1.0f));
+		m_globalScale = { glm::length(glm::vec3(m_modelMatrix[0])), glm::length(glm::vec3(m_modelMatrix[1])), glm::length(glm::vec3(m_modelMatrix[2])) };
+	}
 
-		// Y * X * Z
-		const glm::mat4 rotationMatrix = transformY * transformX * transformZ;
+	// Y * X * Z, the order the euler angles have always been applied in
+	static glm::quat eulerToQuat(const glm::vec3& eulerDegrees)
+	{
+		const glm::vec3 angles = glm::radians(eulerDegrees);
+		return glm::angleAxis(angles.y, glm::vec3(0.0f, 1.0f, 0.0f)) *
+			glm::angleAxis(angles.x, glm::vec3(1.0f, 0.0f, 0.0f)) *
+			glm::angleAxis(angles.z, glm::vec3(0.0f, 0.0f, 1.0f));
+	}
 
-		// translation * rotation * scale (also know as TRS matrix)
-		return glm::translate(glm::mat4(1.0f), m_pos) * rotationMatrix * glm::scale(glm::mat4(1.0f), m_scale);
+	static glm::vec3 quatToEuler(const glm::quat& rotation)
+	{
+		const glm::mat3 m = glm::mat3_cast(rotation);
+		const float x = std::asin(glm::clamp(-m[2].y, -1.0f, 1.0f));
+		return glm::degrees(glm::vec3(x, std::atan2(m[2].x, m[2].z), std::atan2(m[0].y, m[1].y)));
 	}
 public:
 
 	void computeModelMatrix()
 	{
 		m_modelMatrix = getLocalModelMatrix();
+		updateGlobalScale();
 		m_isDirty = false;
 	}
 
 	void computeModelMatrix(const glm::mat4& parentGlobalModelMatrix)
 	{
-		m_modelMatrix = parentGlobalModelMatrix * getLocalModelMatrix();
+		// the parent is affine, only its upper 3x4 takes part
+		const glm::mat4 local = getLocalModelMatrix();
+		const glm::mat3 parentBasis(parentGlobalModelMatrix);
+		m_modelMatrix[0] = glm::vec4(parentBasis * glm::vec3(local[0]), 0.0f);
+		m_modelMatrix[1] = glm::vec4(parentBasis * glm::vec3(local[1]), 0.0f);
+		m_modelMatrix[2] = glm::vec4(parentBasis * glm::vec3(local[2]), 0.0f);
+		m_modelMatrix[3] = glm::vec4(parentBasis * glm::vec3(local[3]) + glm::vec3(parentGlobalModelMatrix[3]), 1.0f);
+		updateGlobalScale();
 		m_isDirty = false;
 	}
 
@@ -53,9 +89,18 @@ public:
 		m_isDirty = true;
 	}
 
+	//Euler angles in degrees
 	void setLocalRotation(const glm::vec3& newRotation)
 	{
 		m_eulerRot = newRotation;
+		m_rotation = eulerToQuat(newRotation);
+		m_isDirty = true;
+	}
+
+	void setLocalRotation(const glm::quat& newRotation)
+	{
+		m_rotation = glm::normalize(newRotation);
+		m_eulerRot = quatToEuler(m_rotation);
 		m_isDirty = true;
 	}
 
@@ -80,6 +125,11 @@ public:
 		return m_eulerRot;
 	}
 
+	const glm::quat& getLocalOrientation() const
+	{
+		return m_rotation;
+	}
+
 	const glm::vec3& getLocalScale() const
 	{
 		return m_scale;
@@ -111,9 +161,9 @@ public:
 		return -m_modelMatrix[2];
 	}
 
-	glm::vec3 getGlobalScale() const
+	const glm::vec3& getGlobalScale() const
 	{
-		return { glm::length(getRight()), glm::length(getUp()), glm::length(getBackward()) };
+		return m_globalScale;
 	}
 
 	bool isDirty() const
@@ -150,12 +200,63 @@ struct Frustum
 
 	Plane farFace;
 	Plane nearFace;
+
+	//Planes by index, in the order isOnFrustum tests them
+	const Plane& getPlane(unsigned int index) const
+	{
+		static constexpr Plane Frustum::* faces[6] = { &Frustum::leftFace, &Frustum::rightFace, &Frustum::topFace,
+			&Frustum::bottomFace, &Frustum::nearFace, &Frustum::farFace };
+		return this->*faces[index];
+	}
+};
+
+//Per frame counters of the coherent frustum tests, a plain isOnFrustum runs up to six plane tests per volume
+struct CullingStats
+{
+	unsigned int entities = 0;			//Entities the culler went through
+	unsigned int volumes = 0;			//Volumes that went into the plane tests, subtree boxes included
+	unsigned int planeTests = 0;
+	unsigned int insidePlanesSkipped = 0;	//Planes not tested because a subtree box was fully inside them
+	unsigned int cachedRejections = 0;	//Volumes rejected by the plane that rejected them last time
+	unsigned int culledBySubtree = 0;	//Entities not tested at all because a subtree box around them was outside
+
+	void reset()
+	{
+		*this = CullingStats();
+	}
+
+	void add(const CullingStats& other)
+	{
+		entities += other.entities;
+		volumes += other.volumes;
+		planeTests += other.planeTests;
+		insidePlanesSkipped += other.insidePlanesSkipped;
+		cachedRejections += other.cachedRejections;
+		culledBySubtree += other.culledBySubtree;
+	}
+
+	void print(std::ostream& out, const char* label) const
+	{
+		const int avoided = 6 * static_cast<int>(entities) - static_cast<int>(planeTests);
+		out << label << ": " << planeTests << " plane tests for " << entities << " entities, " << avoided
+			<< " avoided against six each (" << insidePlanesSkipped << " planes inside a subtree box, " << culledBySubtree
+			<< " entities in a culled subtree, " << cachedRejections << " rejected by last frame's plane)" << std::endl;
+	}
 };
 
 struct BoundingVolume
 {
+	//All six planes in the masks of the coherent test
+	static constexpr unsigned int allPlanes = 0x3F;
+
 	virtual bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const = 0;
 
+	//Same test for volumes culled every frame. Only the planes set in activePlanes are tested, the bits of the planes
+	//the volume is fully inside of are cleared for the volumes it contains. lastPlane is tested first and keeps the
+	//plane that rejected the volume, which is likely to reject it again next frame.
+	virtual bool isOnFrustum(const Frustum& camFrustum, const Transform& transform, unsigned int& activePlanes,
+		unsigned char& lastPlane, CullingStats& stats) const = 0;
+
 	virtual bool isOnOrForwardPlane(const Plane& plane) const = 0;
 
 	bool isOnFrustum(const Frustum& camFrustum) const
@@ -167,6 +268,37 @@ struct BoundingVolume
 			isOnOrForwardPlane(camFrustum.nearFace) &&
 			isOnOrForwardPlane(camFrustum.farFace));
 	};
+
+protected:
+	//Plane tests of the coherent isOnFrustum for a world space volume, radiusAlong(normal) is its extent along the normal
+	template <typename RadiusAlong>
+	static bool testPlanes(const Frustum& camFrustum, const glm::vec3& center, RadiusAlong radiusAlong,
+		unsigned int& activePlanes, unsigned char& lastPlane, CullingStats& stats)
+	{
+		stats.volumes++;
+		for (unsigned int n = 0; n < 6; n++)
+		{
+			const unsigned int i = (lastPlane + n) % 6;
+			if (!(activePlanes & (1u << i)))
+			{
+				stats.insidePlanesSkipped++;
+				continue;
+			}
+			stats.planeTests++;
+			const Plane& plane = camFrustum.getPlane(i);
+			const float r = radiusAlong(plane.normal);
+			const float distance = plane.getSignedDistanceToPlane(center);
+			if (distance < -r)
+			{
+				stats.cachedRejections += n == 0 ? 1 : 0;
+				lastPlane = static_cast<unsigned char>(i);
+				return false;
+			}
+			if (distance >= r)
+				activePlanes &= ~(1u << i);
+		}
+		return true;
+	}
 };
 
 struct Sphere : public BoundingVolume
@@ -183,7 +315,7 @@ struct Sphere : public BoundingVolume
 		return plane.getSignedDistanceToPlane(center) > -radius;
 	}
 
-	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const final
+	Sphere getGlobalSphere(const Transform& transform) const
 	{
 		//Get global scale thanks to our transform
 		const glm::vec3 globalScale = transform.getGlobalScale();
@@ -195,7 +327,12 @@ struct Sphere : public BoundingVolume
 		const float maxScale = std::max(std::max(globalScale.x, globalScale.y), globalScale.z);
 
 		//Max scale is assuming for the diameter. So, we need the half to apply it to our radius
-		Sphere globalSphere(globalCenter, radius * (maxScale * 0.5f));
+		return Sphere(globalCenter, radius * (maxScale * 0.5f));
+	}
+
+	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const final
+	{
+		const Sphere globalSphere = getGlobalSphere(transform);
 
 		//Check Firstly the result that have the most chance to failure to avoid to call all functions.
 		return (globalSphere.isOnOrForwardPlane(camFrustum.leftFace) &&
@@ -205,6 +342,14 @@ struct Sphere : public BoundingVolume
 			globalSphere.isOnOrForwardPlane(camFrustum.topFace) &&
 			globalSphere.isOnOrForwardPlane(camFrustum.bottomFace));
 	};
+
+	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform, unsigned int& activePlanes,
+		unsigned char& lastPlane, CullingStats& stats) const final
+	{
+		const Sphere globalSphere = getGlobalSphere(transform);
+		return testPlanes(camFrustum, globalSphere.center, [&](const glm::vec3&) { return globalSphere.radius; },
+			activePlanes, lastPlane, stats);
+	}
 };
 
 struct SquareAABB : public BoundingVolume
@@ -223,7 +368,7 @@ struct SquareAABB : public BoundingVolume
 		return -r <= plane.getSignedDistanceToPlane(center);
 	}
 
-	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const final
+	SquareAABB getGlobalSquareAABB(const Transform& transform) const
 	{
 		//Get global scale thanks to our transform
 		const glm::vec3 globalCenter{ transform.getModelMatrix() * glm::vec4(center, 1.f) };
@@ -245,7 +390,12 @@ struct SquareAABB : public BoundingVolume
 			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, up)) +
 			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, forward));
 
-		const SquareAABB globalAABB(globalCenter, std::max(std::max(newIi, newIj), newIk));
+		return SquareAABB(globalCenter, std::max(std::max(newIi, newIj), newIk));
+	}
+
+	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const final
+	{
+		const SquareAABB globalAABB = getGlobalSquareAABB(transform);
 
 		return (globalAABB.isOnOrForwardPlane(camFrustum.leftFace) &&
 			globalAABB.isOnOrForwardPlane(camFrustum.rightFace) &&
@@ -254,6 +404,15 @@ struct SquareAABB : public BoundingVolume
 			globalAABB.isOnOrForwardPlane(camFrustum.nearFace) &&
 			globalAABB.isOnOrForwardPlane(camFrustum.farFace));
 	};
+
+	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform, unsigned int& activePlanes,
+		unsigned char& lastPlane, CullingStats& stats) const final
+	{
+		const SquareAABB globalAABB = getGlobalSquareAABB(transform);
+		return testPlanes(camFrustum, globalAABB.center,
+			[&](const glm::vec3& normal) { return globalAABB.extent * (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z)); },
+			activePlanes, lastPlane, stats);
+	}
 };
 
 struct AABB : public BoundingVolume
@@ -293,7 +452,7 @@ struct AABB : public BoundingVolume
 		return -r <= plane.getSignedDistanceToPlane(center);
 	}
 
-	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const final
+	AABB getGlobalAABB(const Transform& transform) const
 	{
 		//Get global scale thanks to our transform
 		const glm::vec3 globalCenter{ transform.getModelMatrix() * glm::vec4(center, 1.f) };
@@ -315,7 +474,12 @@ struct AABB : public BoundingVolume
 			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, up)) +
 			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, forward));
 
-		const AABB globalAABB(globalCenter, newIi, newIj, newIk);
+		return AABB(globalCenter, newIi, newIj, newIk);
+	}
+
+	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const final
+	{
+		const AABB globalAABB = getGlobalAABB(transform);
 
 		return (globalAABB.isOnOrForwardPlane(camFrustum.leftFace) &&
 			globalAABB.isOnOrForwardPlane(camFrustum.rightFace) &&
@@ -324,6 +488,20 @@ struct AABB : public BoundingVolume
 			globalAABB.isOnOrForwardPlane(camFrustum.nearFace) &&
 			globalAABB.isOnOrForwardPlane(camFrustum.farFace));
 	};
+
+	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform, unsigned int& activePlanes,
+		unsigned char& lastPlane, CullingStats& stats) const final
+	{
+		return getGlobalAABB(transform).isOnFrustum(camFrustum, activePlanes, lastPlane, stats);
+	}
+
+	//Coherent test of a box already in world space
+	bool isOnFrustum(const Frustum& camFrustum, unsigned int& activePlanes, unsigned char& lastPlane, CullingStats& stats) const
+	{
+		return testPlanes(camFrustum, center,
+			[this](const glm::vec3& normal) { return glm::dot(extents, glm::abs(normal)); },
+			activePlanes, lastPlane, stats);
+	}
 };
 
 Frustum createFrustumFromCamera(const Camera& cam, float aspect, float fovY, float zNear, float zFar)
@@ -342,45 +520,17 @@ Frustum createFrustumFromCamera(const Camera& cam, float aspect, float fovY, flo
 	return frustum;
 }
 
+//Both read the bounds the model measured once at load, so creating an entity doesn't depend on the vertex count
+//and still works once the CPU geometry is released
 AABB generateAABB(const Model& model)
 {
-	glm::vec3 minAABB = glm::vec3(std::numeric_limits<float>::max());
-	glm::vec3 maxAABB = glm::vec3(std::numeric_limits<float>::min());
-	for (auto&& mesh : model.meshes)
-	{
-		for (auto&& vertex : mesh.vertices)
-		{
-			minAABB.x = std::min(minAABB.x, vertex.Position.x);
-			minAABB.y = std::min(minAABB.y, vertex.Position.y);
-			minAABB.z = std::min(minAABB.z, vertex.Position.z);
-
-			maxAABB.x = std::max(maxAABB.x, vertex.Position.x);
-			maxAABB.y = std::max(maxAABB.y, vertex.Position.y);
-			maxAABB.z = std::max(maxAABB.z, vertex.Position.z);
-		}
-	}
-	return AABB(minAABB, maxAABB);
+	return AABB(model.bounds.min, model.bounds.max);
 }
 
 Sphere generateSphereBV(const Model& model)
 {
-	glm::vec3 minAABB = glm::vec3(std::numeric_limits<float>::max());
-	glm::vec3 maxAABB = glm::vec3(std::numeric_limits<float>::min());
-	for (auto&& mesh : model.meshes)
-	{
-		for (auto&& vertex : mesh.vertices)
-		{
-			minAABB.x = std::min(minAABB.x, vertex.Position.x);
-			minAABB.y = std::min(minAABB.y, vertex.Position.y);
-			minAABB.z = std::min(minAABB.z, vertex.Position.z);
-
-			maxAABB.x = std::max(maxAABB.x, vertex.Position.x);
-			maxAABB.y = std::max(maxAABB.y, vertex.Position.y);
-			maxAABB.z = std::max(maxAABB.z, vertex.Position.z);
-		}
-	}
-
-	return Sphere((maxAABB + minAABB) * 0.5f, glm::length(minAABB - maxAABB));
+	//isOnFrustum halves the radius along with the scale, so it is given the diameter
+	return Sphere(model.bounds.sphereCenter, model.bounds.sphereRadius * 2.f);
 }
 
 class Entity
@@ -396,6 +546,16 @@ public:
 	Model* pModel = nullptr;
 	std::unique_ptr<AABB> boundingVolume;
 
+	//Level of detail used last frame, kept for the hysteresis of selectLod
+	unsigned int lod = 0;
+
+	//World box around this entity and all its descendants, refit by the updates
+	AABB subtreeAABB{ glm::vec3(0.f), glm::vec3(0.f) };
+
+	//Planes that rejected the volume and the subtree box the last time they were culled, tested first the next time
+	unsigned char cullPlane = 0;
+	unsigned char subtreeCullPlane = 0;
+
 
 	// constructor, expects a filepath to a 3D model.
 	Entity(Model& model) : pModel{ &model }
@@ -406,27 +566,7 @@ public:
 
 	AABB getGlobalAABB()
 	{
-		//Get global scale thanks to our transform
-		const glm::vec3 globalCenter{ transform.getModelMatrix() * glm::vec4(boundingVolume->center, 1.f) };
-
-		// Scaled orientation
-		const glm::vec3 right = transform.getRight() * boundingVolume->extents.x;
-		const glm::vec3 up = transform.getUp() * boundingVolume->extents.y;
-		const glm::vec3 forward = transform.getForward() * boundingVolume->extents.z;
-
-		const float newIi = std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, forward));
-
-		const float newIj = std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, forward));
-
-		const float newIk = std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, forward));
-
-		return AABB(globalCenter, newIi, newIj, newIk);
+		return boundingVolume->getGlobalAABB(transform);
 	}
 
 	//Add child. Argument input is argument of any constructor that you create. By default you can use the default constructor and don't put argument input.
@@ -437,18 +577,22 @@ public:
 		children.back()->parent = this;
 	}
 
-	//Update transform if it was changed
-	void updateSelfAndChild()
+	//Update transform if it was changed, returns whether anything moved so the parent refits its subtree box
+	bool updateSelfAndChild()
 	{
 		if (transform.isDirty()) {
 			forceUpdateSelfAndChild();
-			return;
+			return true;
 		}
-			
+
+		bool moved = false;
 		for (auto&& child : children)
 		{
-			child->updateSelfAndChild();
+			moved = child->updateSelfAndChild() || moved;
 		}
+		if (moved)
+			refitSubtreeAABB();
+		return moved;
 	}
 
 	//Force update of transform even if local space don't change
@@ -463,14 +607,30 @@ public:
 		{
 			child->forceUpdateSelfAndChild();
 		}
+		refitSubtreeAABB();
+	}
+
+	//Grow the global box of the entity over the subtree boxes of its children, which have to be up to date
+	void refitSubtreeAABB()
+	{
+		const AABB globalAABB = getGlobalAABB();
+		glm::vec3 minAABB = globalAABB.center - globalAABB.extents;
+		glm::vec3 maxAABB = globalAABB.center + globalAABB.extents;
+		for (auto&& child : children)
+		{
+			minAABB = glm::min(minAABB, child->subtreeAABB.center - child->subtreeAABB.extents);
+			maxAABB = glm::max(maxAABB, child->subtreeAABB.center + child->subtreeAABB.extents);
+		}
+		subtreeAABB = AABB(minAABB, maxAABB);
 	}
 
 
 	void drawSelfAndChild(const Frustum& frustum, Shader& ourShader, unsigned int& display, unsigned int& total)
 	{
+		static constexpr UniformName modelUniform("model");
 		if (boundingVolume->isOnFrustum(frustum, transform))
 		{
-			ourShader.setMat4("model", transform.getModelMatrix());
+			ourShader.setMat4(modelUniform, transform.getModelMatrix());
 			pModel->Draw(ourShader);
 			display++;
 		}
@@ -481,5 +641,75 @@ public:
 			child->drawSelfAndChild(frustum, ourShader, display, total);
 		}
 	}
+
+	//Same as above but draws every visible entity at the level of detail matching the screen size of its bounding sphere
+	void drawSelfAndChild(const Frustum& frustum, Shader& ourShader, const LodView& view, LodStats& stats, unsigned int& display, unsigned int& total)
+	{
+		static constexpr UniformName modelUniform("model");
+		if (boundingVolume->isOnFrustum(frustum, transform))
+		{
+			const AABB globalAABB = getGlobalAABB();
+			const float screenSize = projectedSphereSize(globalAABB.center, glm::length(globalAABB.extents), view.cameraPosition, view.fovY);
+			lod = selectLod(lod, pModel->lodCount(), screenSize, view.settings);
+
+			ourShader.setMat4(modelUniform, transform.getModelMatrix());
+			pModel->Draw(ourShader, lod);
+			stats.triangles += static_cast<unsigned int>(pModel->triangleCount(lod));
+			stats.drawsPerLod[lod]++;
+			display++;
+		}
+		total++;
+
+		for (auto&& child : children)
+		{
+			child->drawSelfAndChild(frustum, ourShader, view, stats, display, total);
+		}
+	}
+
+	//Same as above but only queues the visible entities, the queue sorts them by state before anything is drawn
+	void submitSelfAndChild(const Frustum& frustum, RenderQueue& queue, Shader& ourShader, const LodView& view, LodStats& stats, unsigned int& display, unsigned int& total)
+	{
+		if (boundingVolume->isOnFrustum(frustum, transform))
+		{
+			const AABB globalAABB = getGlobalAABB();
+			const float screenSize = projectedSphereSize(globalAABB.center, glm::length(globalAABB.extents), view.cameraPosition, view.fovY);
+			lod = selectLod(lod, pModel->lodCount(), screenSize, view.settings);
+
+			DrawPacket packet;
+			packet.model = transform.getModelMatrix();
+			pModel->Submit(queue, ourShader, packet, lod);
+			stats.triangles += static_cast<unsigned int>(pModel->triangleCount(lod));
+			stats.drawsPerLod[lod]++;
+			display++;
+		}
+		total++;
+
+		for (auto&& child : children)
+		{
+			child->submitSelfAndChild(frustum, queue, ourShader, view, stats, display, total);
+		}
+	}
+
+	//Same as above but only records the transforms, the renderer draws all copies of a model and lod with a few indirect draws
+	void addSelfAndChild(const Frustum& frustum, IndirectRenderer& renderer, const LodView& view, LodStats& stats, unsigned int& display, unsigned int& total)
+	{
+		if (boundingVolume->isOnFrustum(frustum, transform))
+		{
+			const AABB globalAABB = getGlobalAABB();
+			const float screenSize = projectedSphereSize(globalAABB.center, glm::length(globalAABB.extents), view.cameraPosition, view.fovY);
+			lod = selectLod(lod, pModel->lodCount(), screenSize, view.settings);
+
+			renderer.add(*pModel, lod, transform.getModelMatrix());
+			stats.triangles += static_cast<unsigned int>(pModel->triangleCount(lod));
+			stats.drawsPerLod[lod]++;
+			display++;
+		}
+		total++;
+
+		for (auto&& child : children)
+		{
+			child->addSelfAndChild(frustum, renderer, view, stats, display, total);
+		}
+	}
 };
 #endif
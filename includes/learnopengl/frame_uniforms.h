@@ -0,0 +1,136 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/stream_buffer.h>
+
+#include <cstddef>
+
+// uniform buffer binding point of the FrameData block, the same for every program
+#define FRAME_UNIFORMS_BINDING 0
+#define FRAME_MAX_POINT_LIGHTS 4
+
+// The lights and the block as std140 lays them out. A shader declares them as
+//     struct DirLight { vec3 direction; vec3 ambient; vec3 diffuse; vec3 specular; };
+//     struct PointLight { vec3 position; float constant; float linear; float quadratic; vec3 ambient; vec3 diffuse; vec3 specular; };
+//     struct SpotLight { vec3 position; vec3 direction; float cutOff; float outerCutOff; float constant; float linear;
+//                        float quadratic; vec3 ambient; vec3 diffuse; vec3 specular; };
+//     layout (std140) uniform FrameData {
+//         mat4 projection;
+//         mat4 view;
+//         vec3 viewPos;
+//         DirLight dirLight;
+//         PointLight pointLights[4];
+//         SpotLight spotLight;
+//         DirLight bgLight;
+//     };
+// std140 starts every vec3 and struct on 16 bytes, the padding members below keep the C++ side in step.
+// Shaders that only need the camera can declare the block up to viewPos and leave out the rest.
+struct FrameDirLight
+{
+    glm::vec3 direction = glm::vec3(0.0f); float pad0 = 0.0f;
+    glm::vec3 ambient = glm::vec3(0.0f);   float pad1 = 0.0f;
+    glm::vec3 diffuse = glm::vec3(0.0f);   float pad2 = 0.0f;
+    glm::vec3 specular = glm::vec3(0.0f);  float pad3 = 0.0f;
+};
+
+struct FramePointLight
+{
+    glm::vec3 position = glm::vec3(0.0f);
+    float constant = 1.0f;
+    float linear = 0.0f;
+    float quadratic = 0.0f;
+    float pad0[2] = {};
+    glm::vec3 ambient = glm::vec3(0.0f);   float pad1 = 0.0f;
+    glm::vec3 diffuse = glm::vec3(0.0f);   float pad2 = 0.0f;
+    glm::vec3 specular = glm::vec3(0.0f);  float pad3 = 0.0f;
+};
+
+struct FrameSpotLight
+{
+    glm::vec3 position = glm::vec3(0.0f);  float pad0 = 0.0f;
+    glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    float cutOff = 1.0f;
+    float outerCutOff = 1.0f;
+    float constant = 1.0f;
+    float linear = 0.0f;
+    float quadratic = 0.0f;
+    glm::vec3 ambient = glm::vec3(0.0f);   float pad1 = 0.0f;
+    glm::vec3 diffuse = glm::vec3(0.0f);   float pad2 = 0.0f;
+    glm::vec3 specular = glm::vec3(0.0f);  float pad3 = 0.0f;
+};
+
+struct FrameData
+{
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::vec3 viewPos = glm::vec3(0.0f);   float pad0 = 0.0f;
+    FrameDirLight dirLight;
+    FramePointLight pointLights[FRAME_MAX_POINT_LIGHTS];
+    FrameSpotLight spotLight;
+    FrameDirLight bgLight;
+};
+
+static_assert(sizeof(FrameDirLight) == 64, "FrameDirLight doesn't match std140");
+static_assert(sizeof(FramePointLight) == 80, "FramePointLight doesn't match std140");
+static_assert(sizeof(FrameSpotLight) == 96, "FrameSpotLight doesn't match std140");
+static_assert(offsetof(FrameData, dirLight) == 144 && offsetof(FrameData, pointLights) == 208 &&
+              offsetof(FrameData, spotLight) == 528 && offsetof(FrameData, bgLight) == 624, "FrameData doesn't match std140");
+
+// Camera and lights shared by every program. Instead of setting projection, view and every light member on each
+// shader, the demo fills data once per frame and upload() writes it into a uniform buffer bound at
+// FRAME_UNIFORMS_BINDING. Each Shader points its FrameData block at that binding when it is linked (see
+// bindBlock), so switching programs costs nothing. The buffer is a StreamBuffer, a frame's upload never waits
+// for draws still reading the previous frames.
+class FrameUniforms
+{
+public:
+    FrameData data;
+
+    FrameUniforms() : stream(GL_UNIFORM_BUFFER, 4 * 1024)
+    {
+    }
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+    // sends data to the GPU, call it once per frame before the draws that use it
+    void upload()
+    {
+        if (alignment == 0)
+        {
+            GLint offsetAlignment = 0;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+            alignment = offsetAlignment > 0 ? static_cast<size_t>(offsetAlignment) : 256;
+        }
+        stream.nextFrame();
+        const size_t offset = stream.write(&data, sizeof(FrameData), alignment);
+        glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, stream.buffer, offset, sizeof(FrameData));
+    }
+
+    StreamBufferStats &uploadStats()
+    {
+        return stream.stats;
+    }
+
+    // like the other stream users the buffer is not deleted on destruction
+    void release()
+    {
+        stream.release();
+    }
+
+    // points the FrameData block of program, if it has one, at the shared binding
+    static void bindBlock(GLuint program)
+    {
+        const GLuint index = glGetUniformBlockIndex(program, "FrameData");
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, index, FRAME_UNIFORMS_BINDING);
+    }
+
+private:
+    StreamBuffer stream;
+    size_t alignment = 0;
+};
+#endif
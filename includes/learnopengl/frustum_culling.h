@@ -0,0 +1,196 @@
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/entity.h>
+#include <learnopengl/simd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// World space AABBs kept as one array per component, so a single load fetches the same component of
+// SIMD_LANES boxes. The arrays are padded to a whole number of loads, the padding is never
+// reported visible.
+class CullingBoxes
+{
+public:
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+
+    // keeps the storage for the next frame
+    void clear()
+    {
+        count = 0;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    void add(const glm::vec3& center, const glm::vec3& extents)
+    {
+        if (count == centerX.size())
+        {
+            for (std::vector<float>* values : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ })
+                values->resize(count + SIMD_LANES, 0.0f);
+        }
+        centerX[count] = center.x;
+        centerY[count] = center.y;
+        centerZ[count] = center.z;
+        extentX[count] = extents.x;
+        extentY[count] = extents.y;
+        extentZ[count] = extents.z;
+        count++;
+    }
+
+    // local transformed by model, the same box AABB::isOnFrustum builds from a Transform
+    void add(const AABB& local, const glm::mat4& model)
+    {
+        const glm::vec3 center{ model * glm::vec4(local.center, 1.f) };
+        const glm::vec3 extents = glm::abs(glm::vec3(model[0])) * local.extents.x +
+            glm::abs(glm::vec3(model[1])) * local.extents.y + glm::abs(glm::vec3(model[2])) * local.extents.z;
+        add(center, extents);
+    }
+
+private:
+    size_t count = 0;
+};
+
+// World space bounding spheres, laid out like CullingBoxes.
+class CullingSpheres
+{
+public:
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> radius;
+
+    void clear()
+    {
+        count = 0;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    void add(const glm::vec3& center, float sphereRadius)
+    {
+        if (count == centerX.size())
+        {
+            for (std::vector<float>* values : { &centerX, &centerY, &centerZ, &radius })
+                values->resize(count + SIMD_LANES, 0.0f);
+        }
+        centerX[count] = center.x;
+        centerY[count] = center.y;
+        centerZ[count] = center.z;
+        radius[count] = sphereRadius;
+        count++;
+    }
+
+    // local transformed by model, the same sphere Sphere::isOnFrustum builds from a Transform
+    void add(const Sphere& local, const glm::mat4& model)
+    {
+        const glm::vec3 scale{ glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])) };
+        const float maxScale = std::max(std::max(scale.x, scale.y), scale.z);
+        add(glm::vec3(model * glm::vec4(local.center, 1.f)), local.radius * (maxScale * 0.5f));
+    }
+
+private:
+    size_t count = 0;
+};
+
+// Tests SIMD_LANES volumes at a time against all six planes of a frustum, without a branch per plane,
+// and writes the indices of the visible ones one after another. The tests are the ones of AABB and Sphere:
+// a box is visible when -r <= distance for every plane, a sphere when distance > -radius.
+namespace FrustumCulling
+{
+    using namespace Simd;
+
+    // the six planes, every component broadcast to all lanes
+    struct Planes
+    {
+        Lanes normalX[6], normalY[6], normalZ[6];
+        Lanes absX[6], absY[6], absZ[6];
+        Lanes distance[6];
+
+        explicit Planes(const Frustum& frustum)
+        {
+            const Plane* planes[6] = { &frustum.leftFace, &frustum.rightFace, &frustum.topFace,
+                                       &frustum.bottomFace, &frustum.nearFace, &frustum.farFace };
+            for (int i = 0; i < 6; i++)
+            {
+                normalX[i] = broadcast(planes[i]->normal.x);
+                normalY[i] = broadcast(planes[i]->normal.y);
+                normalZ[i] = broadcast(planes[i]->normal.z);
+                absX[i] = broadcast(std::abs(planes[i]->normal.x));
+                absY[i] = broadcast(std::abs(planes[i]->normal.y));
+                absZ[i] = broadcast(std::abs(planes[i]->normal.z));
+                distance[i] = broadcast(planes[i]->distance);
+            }
+        }
+
+        Lanes signedDistance(int i, Lanes x, Lanes y, Lanes z) const
+        {
+            return sub(add(add(mul(normalX[i], x), mul(normalY[i], y)), mul(normalZ[i], z)), distance[i]);
+        }
+    };
+
+    // appends base + lane for every lane set in mask, without a branch per lane; out needs
+    // SIMD_LANES free slots
+    inline uint32_t* compact(uint32_t* out, unsigned int mask, uint32_t base)
+    {
+        for (unsigned int lane = 0; lane < SIMD_LANES; lane++)
+        {
+            *out = base + lane;
+            out += (mask >> lane) & 1u;
+        }
+        return out;
+    }
+
+    // replaces visible with the indices of the boxes on the frustum, in increasing order
+    inline void cull(const Frustum& frustum, const CullingBoxes& boxes, std::vector<uint32_t>& visible)
+    {
+        const Planes planes(frustum);
+        const Lanes zero = broadcast(0.0f);
+        visible.resize(boxes.size() + SIMD_LANES);
+        uint32_t* out = visible.data();
+        for (size_t i = 0; i < boxes.size(); i += SIMD_LANES)
+        {
+            const Lanes x = load(&boxes.centerX[i]), y = load(&boxes.centerY[i]), z = load(&boxes.centerZ[i]);
+            const Lanes ex = load(&boxes.extentX[i]), ey = load(&boxes.extentY[i]), ez = load(&boxes.extentZ[i]);
+            LaneMask inside = Simd::lessEqual(sub(zero, add(add(mul(ex, planes.absX[0]), mul(ey, planes.absY[0])), mul(ez, planes.absZ[0]))),
+                                        planes.signedDistance(0, x, y, z));
+            for (int p = 1; p < 6; p++)
+            {
+                const Lanes r = add(add(mul(ex, planes.absX[p]), mul(ey, planes.absY[p])), mul(ez, planes.absZ[p]));
+                inside = both(inside, Simd::lessEqual(sub(zero, r), planes.signedDistance(p, x, y, z)));
+            }
+            out = compact(out, bits(inside) & validLanes(i, boxes.size()), static_cast<uint32_t>(i));
+        }
+        visible.resize(out - visible.data());
+    }
+
+    // replaces visible with the indices of the spheres on the frustum, in increasing order
+    inline void cull(const Frustum& frustum, const CullingSpheres& spheres, std::vector<uint32_t>& visible)
+    {
+        const Planes planes(frustum);
+        const Lanes zero = broadcast(0.0f);
+        visible.resize(spheres.size() + SIMD_LANES);
+        uint32_t* out = visible.data();
+        for (size_t i = 0; i < spheres.size(); i += SIMD_LANES)
+        {
+            const Lanes x = load(&spheres.centerX[i]), y = load(&spheres.centerY[i]), z = load(&spheres.centerZ[i]);
+            const Lanes negativeRadius = sub(zero, load(&spheres.radius[i]));
+            LaneMask inside = Simd::greater(planes.signedDistance(0, x, y, z), negativeRadius);
+            for (int p = 1; p < 6; p++)
+                inside = both(inside, Simd::greater(planes.signedDistance(p, x, y, z), negativeRadius));
+            out = compact(out, bits(inside) & validLanes(i, spheres.size()), static_cast<uint32_t>(i));
+        }
+        visible.resize(out - visible.data());
+    }
+}
+#endif
@@ -0,0 +1,277 @@
+#ifndef GL_COUNTERS_H
+#define GL_COUNTERS_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+// number of GL calls of each kind issued since the last reset
+struct GLCounters
+{
+    unsigned int drawCalls = 0;        // every glDraw* / glMultiDraw* entry point, a multi draw counts once
+    unsigned int drawRanges = 0;       // sub-draws submitted, drawcount of a multi draw, 1 otherwise
+    unsigned int textureBinds = 0;
+    unsigned int vertexArrayBinds = 0;
+    unsigned int bufferBinds = 0;
+    unsigned int programBinds = 0;
+    unsigned int uniformUploads = 0;   // glUniform* calls
+    unsigned int uniformLookups = 0;   // glGetUniformLocation calls
+
+    void reset()
+    {
+        *this = GLCounters();
+    }
+
+    void print(std::ostream& out, const char* label) const
+    {
+        out << label << ": " << drawCalls << " draws (" << drawRanges << " ranges), "
+            << textureBinds << " texture binds, " << vertexArrayBinds << " vao binds, "
+            << bufferBinds << " buffer binds, " << programBinds << " program binds, "
+            << uniformUploads << " uniforms, " << uniformLookups << " uniform lookups" << std::endl;
+    }
+};
+
+// Counts GL calls by swapping glad's function pointers for thin wrappers that bump a counter and
+// forward to the driver. install() must run after gladLoadGL, uninstall() restores the real entry
+// points. Other pointer wrappers installed later keep working since each one calls what it replaced.
+namespace GLCallCounter
+{
+    inline GLCounters counters;
+    inline bool installed = false;
+
+    // the entry points that were in place when install() ran
+    inline PFNGLDRAWARRAYSPROC                    realDrawArrays = nullptr;
+    inline PFNGLDRAWELEMENTSPROC                  realDrawElements = nullptr;
+    inline PFNGLDRAWELEMENTSBASEVERTEXPROC        realDrawElementsBaseVertex = nullptr;
+    inline PFNGLDRAWARRAYSINSTANCEDPROC           realDrawArraysInstanced = nullptr;
+    inline PFNGLDRAWELEMENTSINSTANCEDPROC         realDrawElementsInstanced = nullptr;
+    inline PFNGLMULTIDRAWARRAYSPROC               realMultiDrawArrays = nullptr;
+    inline PFNGLMULTIDRAWELEMENTSPROC             realMultiDrawElements = nullptr;
+    inline PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC   realMultiDrawElementsBaseVertex = nullptr;
+    inline PFNGLMULTIDRAWELEMENTSINDIRECTPROC     realMultiDrawElementsIndirect = nullptr;
+    inline PFNGLBINDTEXTUREPROC                   realBindTexture = nullptr;
+    inline PFNGLBINDVERTEXARRAYPROC               realBindVertexArray = nullptr;
+    inline PFNGLBINDBUFFERPROC                    realBindBuffer = nullptr;
+    inline PFNGLUSEPROGRAMPROC                    realUseProgram = nullptr;
+    inline PFNGLGETUNIFORMLOCATIONPROC            realGetUniformLocation = nullptr;
+    inline PFNGLUNIFORM1IPROC                     realUniform1i = nullptr;
+    inline PFNGLUNIFORM1FPROC                     realUniform1f = nullptr;
+    inline PFNGLUNIFORM2FPROC                     realUniform2f = nullptr;
+    inline PFNGLUNIFORM2FVPROC                    realUniform2fv = nullptr;
+    inline PFNGLUNIFORM3FPROC                     realUniform3f = nullptr;
+    inline PFNGLUNIFORM3FVPROC                    realUniform3fv = nullptr;
+    inline PFNGLUNIFORM4FPROC                     realUniform4f = nullptr;
+    inline PFNGLUNIFORM4FVPROC                    realUniform4fv = nullptr;
+    inline PFNGLUNIFORMMATRIX2FVPROC              realUniformMatrix2fv = nullptr;
+    inline PFNGLUNIFORMMATRIX3FVPROC              realUniformMatrix3fv = nullptr;
+    inline PFNGLUNIFORMMATRIX4FVPROC              realUniformMatrix4fv = nullptr;
+
+    inline void APIENTRY countDrawArrays(GLenum mode, GLint first, GLsizei count)
+    {
+        counters.drawCalls++; counters.drawRanges++;
+        realDrawArrays(mode, first, count);
+    }
+    inline void APIENTRY countDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices)
+    {
+        counters.drawCalls++; counters.drawRanges++;
+        realDrawElements(mode, count, type, indices);
+    }
+    inline void APIENTRY countDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint basevertex)
+    {
+        counters.drawCalls++; counters.drawRanges++;
+        realDrawElementsBaseVertex(mode, count, type, indices, basevertex);
+    }
+    inline void APIENTRY countDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount)
+    {
+        counters.drawCalls++; counters.drawRanges++;
+        realDrawArraysInstanced(mode, first, count, instancecount);
+    }
+    inline void APIENTRY countDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount)
+    {
+        counters.drawCalls++; counters.drawRanges++;
+        realDrawElementsInstanced(mode, count, type, indices, instancecount);
+    }
+    inline void APIENTRY countMultiDrawArrays(GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawcount)
+    {
+        counters.drawCalls++; counters.drawRanges += drawcount;
+        realMultiDrawArrays(mode, first, count, drawcount);
+    }
+    inline void APIENTRY countMultiDrawElements(GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawcount)
+    {
+        counters.drawCalls++; counters.drawRanges += drawcount;
+        realMultiDrawElements(mode, count, type, indices, drawcount);
+    }
+    inline void APIENTRY countMultiDrawElementsBaseVertex(GLenum mode, const GLsizei* count, GLenum type, const void* const* indices, GLsizei drawcount, const GLint* basevertex)
+    {
+        counters.drawCalls++; counters.drawRanges += drawcount;
+        realMultiDrawElementsBaseVertex(mode, count, type, indices, drawcount, basevertex);
+    }
+    inline void APIENTRY countMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride)
+    {
+        counters.drawCalls++; counters.drawRanges += drawcount;
+        realMultiDrawElementsIndirect(mode, type, indirect, drawcount, stride);
+    }
+    inline void APIENTRY countBindTexture(GLenum target, GLuint texture)
+    {
+        counters.textureBinds++;
+        realBindTexture(target, texture);
+    }
+    inline void APIENTRY countBindVertexArray(GLuint array)
+    {
+        counters.vertexArrayBinds++;
+        realBindVertexArray(array);
+    }
+    inline void APIENTRY countBindBuffer(GLenum target, GLuint buffer)
+    {
+        counters.bufferBinds++;
+        realBindBuffer(target, buffer);
+    }
+    inline void APIENTRY countUseProgram(GLuint program)
+    {
+        counters.programBinds++;
+        realUseProgram(program);
+    }
+    inline GLint APIENTRY countGetUniformLocation(GLuint program, const GLchar* name)
+    {
+        counters.uniformLookups++;
+        return realGetUniformLocation(program, name);
+    }
+    inline void APIENTRY countUniform1i(GLint location, GLint v0)
+    {
+        counters.uniformUploads++;
+        realUniform1i(location, v0);
+    }
+    inline void APIENTRY countUniform1f(GLint location, GLfloat v0)
+    {
+        counters.uniformUploads++;
+        realUniform1f(location, v0);
+    }
+    inline void APIENTRY countUniform2f(GLint location, GLfloat v0, GLfloat v1)
+    {
+        counters.uniformUploads++;
+        realUniform2f(location, v0, v1);
+    }
+    inline void APIENTRY countUniform2fv(GLint location, GLsizei count, const GLfloat* value)
+    {
+        counters.uniformUploads++;
+        realUniform2fv(location, count, value);
+    }
+    inline void APIENTRY countUniform3f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2)
+    {
+        counters.uniformUploads++;
+        realUniform3f(location, v0, v1, v2);
+    }
+    inline void APIENTRY countUniform3fv(GLint location, GLsizei count, const GLfloat* value)
+    {
+        counters.uniformUploads++;
+        realUniform3fv(location, count, value);
+    }
+    inline void APIENTRY countUniform4f(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+    {
+        counters.uniformUploads++;
+        realUniform4f(location, v0, v1, v2, v3);
+    }
+    inline void APIENTRY countUniform4fv(GLint location, GLsizei count, const GLfloat* value)
+    {
+        counters.uniformUploads++;
+        realUniform4fv(location, count, value);
+    }
+    inline void APIENTRY countUniformMatrix2fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+    {
+        counters.uniformUploads++;
+        realUniformMatrix2fv(location, count, transpose, value);
+    }
+    inline void APIENTRY countUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+    {
+        counters.uniformUploads++;
+        realUniformMatrix3fv(location, count, transpose, value);
+    }
+    inline void APIENTRY countUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value)
+    {
+        counters.uniformUploads++;
+        realUniformMatrix4fv(location, count, transpose, value);
+    }
+
+    // swaps one glad pointer for its wrapper, entry points the context doesn't provide stay null
+    template <typename Proc>
+    inline void wrap(Proc& gladProc, Proc& real, Proc wrapper)
+    {
+        real = gladProc;
+        if (gladProc)
+            gladProc = wrapper;
+    }
+
+    template <typename Proc>
+    inline void unwrap(Proc& gladProc, Proc& real)
+    {
+        if (real)
+            gladProc = real;
+        real = nullptr;
+    }
+
+    inline void install()
+    {
+        if (installed)
+            return;
+        wrap(glad_glDrawArrays, realDrawArrays, countDrawArrays);
+        wrap(glad_glDrawElements, realDrawElements, countDrawElements);
+        wrap(glad_glDrawElementsBaseVertex, realDrawElementsBaseVertex, countDrawElementsBaseVertex);
+        wrap(glad_glDrawArraysInstanced, realDrawArraysInstanced, countDrawArraysInstanced);
+        wrap(glad_glDrawElementsInstanced, realDrawElementsInstanced, countDrawElementsInstanced);
+        wrap(glad_glMultiDrawArrays, realMultiDrawArrays, countMultiDrawArrays);
+        wrap(glad_glMultiDrawElements, realMultiDrawElements, countMultiDrawElements);
+        wrap(glad_glMultiDrawElementsBaseVertex, realMultiDrawElementsBaseVertex, countMultiDrawElementsBaseVertex);
+        wrap(glad_glMultiDrawElementsIndirect, realMultiDrawElementsIndirect, countMultiDrawElementsIndirect);
+        wrap(glad_glBindTexture, realBindTexture, countBindTexture);
+        wrap(glad_glBindVertexArray, realBindVertexArray, countBindVertexArray);
+        wrap(glad_glBindBuffer, realBindBuffer, countBindBuffer);
+        wrap(glad_glUseProgram, realUseProgram, countUseProgram);
+        wrap(glad_glGetUniformLocation, realGetUniformLocation, countGetUniformLocation);
+        wrap(glad_glUniform1i, realUniform1i, countUniform1i);
+        wrap(glad_glUniform1f, realUniform1f, countUniform1f);
+        wrap(glad_glUniform2f, realUniform2f, countUniform2f);
+        wrap(glad_glUniform2fv, realUniform2fv, countUniform2fv);
+        wrap(glad_glUniform3f, realUniform3f, countUniform3f);
+        wrap(glad_glUniform3fv, realUniform3fv, countUniform3fv);
+        wrap(glad_glUniform4f, realUniform4f, countUniform4f);
+        wrap(glad_glUniform4fv, realUniform4fv, countUniform4fv);
+        wrap(glad_glUniformMatrix2fv, realUniformMatrix2fv, countUniformMatrix2fv);
+        wrap(glad_glUniformMatrix3fv, realUniformMatrix3fv, countUniformMatrix3fv);
+        wrap(glad_glUniformMatrix4fv, realUniformMatrix4fv, countUniformMatrix4fv);
+        installed = true;
+    }
+
+    // restores the pointers saved by install(), wrappers installed on top of the counter have to be removed first
+    inline void uninstall()
+    {
+        if (!installed)
+            return;
+        unwrap(glad_glDrawArrays, realDrawArrays);
+        unwrap(glad_glDrawElements, realDrawElements);
+        unwrap(glad_glDrawElementsBaseVertex, realDrawElementsBaseVertex);
+        unwrap(glad_glDrawArraysInstanced, realDrawArraysInstanced);
+        unwrap(glad_glDrawElementsInstanced, realDrawElementsInstanced);
+        unwrap(glad_glMultiDrawArrays, realMultiDrawArrays);
+        unwrap(glad_glMultiDrawElements, realMultiDrawElements);
+        unwrap(glad_glMultiDrawElementsBaseVertex, realMultiDrawElementsBaseVertex);
+        unwrap(glad_glMultiDrawElementsIndirect, realMultiDrawElementsIndirect);
+        unwrap(glad_glBindTexture, realBindTexture);
+        unwrap(glad_glBindVertexArray, realBindVertexArray);
+        unwrap(glad_glBindBuffer, realBindBuffer);
+        unwrap(glad_glUseProgram, realUseProgram);
+        unwrap(glad_glGetUniformLocation, realGetUniformLocation);
+        unwrap(glad_glUniform1i, realUniform1i);
+        unwrap(glad_glUniform1f, realUniform1f);
+        unwrap(glad_glUniform2f, realUniform2f);
+        unwrap(glad_glUniform2fv, realUniform2fv);
+        unwrap(glad_glUniform3f, realUniform3f);
+        unwrap(glad_glUniform3fv, realUniform3fv);
+        unwrap(glad_glUniform4f, realUniform4f);
+        unwrap(glad_glUniform4fv, realUniform4fv);
+        unwrap(glad_glUniformMatrix2fv, realUniformMatrix2fv);
+        unwrap(glad_glUniformMatrix3fv, realUniformMatrix3fv);
+        unwrap(glad_glUniformMatrix4fv, realUniformMatrix4fv);
+        installed = false;
+    }
+}
+#endif
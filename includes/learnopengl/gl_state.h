@@ -0,0 +1,284 @@
+#ifndef GL_STATE_H
+#define GL_STATE_H
+
+#include <glad/glad.h>
+
+#include <iostream>
+
+// binds of one kind that reached the driver and that were dropped because the state already matched
+struct GLStateCounter
+{
+    unsigned int issued = 0;
+    unsigned int filtered = 0;
+};
+
+struct GLStateStats
+{
+    GLStateCounter programs;       // glUseProgram
+    GLStateCounter vertexArrays;   // glBindVertexArray
+    GLStateCounter activeTextures; // glActiveTexture
+    GLStateCounter textures;       // glBindTexture
+    GLStateCounter buffers;        // glBindBuffer
+
+    void reset()
+    {
+        *this = GLStateStats();
+    }
+
+    void print(std::ostream& out, const char* label) const
+    {
+        out << label << " (issued/filtered): "
+            << programs.issued << "/" << programs.filtered << " programs, "
+            << vertexArrays.issued << "/" << vertexArrays.filtered << " vaos, "
+            << activeTextures.issued << "/" << activeTextures.filtered << " active units, "
+            << textures.issued << "/" << textures.filtered << " textures, "
+            << buffers.issued << "/" << buffers.filtered << " buffers" << std::endl;
+    }
+};
+
+// Drops binds that would not change anything. Like GLCallCounter it swaps glad's function pointers, so every
+// glUseProgram, glBindVertexArray, glActiveTexture, glBindTexture and glBindBuffer of the program goes through
+// the cache without touching the call sites. The wrappers forward to whatever pointers were in place when
+// install() ran, which may be the call counter (installed first it then only sees issued calls) or a mock
+// function table set up in place of a context.
+//
+// The cache only knows what went through it: call invalidate() after anything that changes bindings behind its
+// back, e.g. a library issuing GL calls through its own loader.
+namespace GLStateCache
+{
+    // state the cache can't vouch for, the next bind always reaches the driver
+    inline constexpr GLuint UNKNOWN = ~0u;
+    inline constexpr unsigned int MAX_TRACKED_UNITS = 32;
+
+    // texture targets and buffer targets with a cached binding, others are passed through
+    enum TextureTarget { TRACKED_TEXTURE_2D, TRACKED_TEXTURE_CUBE_MAP, TRACKED_TEXTURE_3D, TRACKED_TEXTURE_2D_ARRAY, TRACKED_TEXTURE_TARGETS };
+    enum BufferTarget { TRACKED_ARRAY_BUFFER, TRACKED_ELEMENT_ARRAY_BUFFER, TRACKED_UNIFORM_BUFFER, TRACKED_BUFFER_TARGETS };
+
+    inline GLStateStats stats;
+    inline bool installed = false;
+
+    inline GLuint program = UNKNOWN;
+    inline GLuint vertexArray = UNKNOWN;
+    inline GLenum activeTexture = UNKNOWN;
+    inline GLuint textures[MAX_TRACKED_UNITS][TRACKED_TEXTURE_TARGETS];
+    inline GLuint buffers[TRACKED_BUFFER_TARGETS];
+
+    // the entry points that were in place when install() ran
+    inline PFNGLUSEPROGRAMPROC          realUseProgram = nullptr;
+    inline PFNGLBINDVERTEXARRAYPROC     realBindVertexArray = nullptr;
+    inline PFNGLACTIVETEXTUREPROC       realActiveTexture = nullptr;
+    inline PFNGLBINDTEXTUREPROC         realBindTexture = nullptr;
+    inline PFNGLBINDBUFFERPROC          realBindBuffer = nullptr;
+    inline PFNGLBINDBUFFERBASEPROC      realBindBufferBase = nullptr;
+    inline PFNGLBINDBUFFERRANGEPROC     realBindBufferRange = nullptr;
+    inline PFNGLDELETEVERTEXARRAYSPROC  realDeleteVertexArrays = nullptr;
+    inline PFNGLDELETEBUFFERSPROC       realDeleteBuffers = nullptr;
+    inline PFNGLDELETETEXTURESPROC      realDeleteTextures = nullptr;
+
+    // forgets every cached binding
+    inline void invalidate()
+    {
+        program = UNKNOWN;
+        vertexArray = UNKNOWN;
+        activeTexture = UNKNOWN;
+        for (auto& unit : textures)
+            for (GLuint& texture : unit)
+                texture = UNKNOWN;
+        for (GLuint& buffer : buffers)
+            buffer = UNKNOWN;
+    }
+
+    inline int textureTargetIndex(GLenum target)
+    {
+        switch (target)
+        {
+            case GL_TEXTURE_2D:       return TRACKED_TEXTURE_2D;
+            case GL_TEXTURE_CUBE_MAP: return TRACKED_TEXTURE_CUBE_MAP;
+            case GL_TEXTURE_3D:       return TRACKED_TEXTURE_3D;
+            case GL_TEXTURE_2D_ARRAY: return TRACKED_TEXTURE_2D_ARRAY;
+            default:                  return -1;
+        }
+    }
+
+    inline int bufferTargetIndex(GLenum target)
+    {
+        switch (target)
+        {
+            case GL_ARRAY_BUFFER:         return TRACKED_ARRAY_BUFFER;
+            case GL_ELEMENT_ARRAY_BUFFER: return TRACKED_ELEMENT_ARRAY_BUFFER;
+            case GL_UNIFORM_BUFFER:       return TRACKED_UNIFORM_BUFFER;
+            default:                      return -1;
+        }
+    }
+
+    // the cached binding of texture target on the active unit, null when it isn't tracked
+    inline GLuint* textureSlot(GLenum target)
+    {
+        const int index = textureTargetIndex(target);
+        if (index < 0 || activeTexture == UNKNOWN || activeTexture - GL_TEXTURE0 >= MAX_TRACKED_UNITS)
+            return nullptr;
+        return &textures[activeTexture - GL_TEXTURE0][index];
+    }
+
+    inline void APIENTRY cacheUseProgram(GLuint name)
+    {
+        if (name == program)
+        {
+            stats.programs.filtered++;
+            return;
+        }
+        program = name;
+        stats.programs.issued++;
+        realUseProgram(name);
+    }
+    inline void APIENTRY cacheBindVertexArray(GLuint array)
+    {
+        if (array == vertexArray)
+        {
+            stats.vertexArrays.filtered++;
+            return;
+        }
+        vertexArray = array;
+        // the element buffer binding is part of the vertex array, whatever the new one holds is unknown here
+        buffers[TRACKED_ELEMENT_ARRAY_BUFFER] = UNKNOWN;
+        stats.vertexArrays.issued++;
+        realBindVertexArray(array);
+    }
+    inline void APIENTRY cacheActiveTexture(GLenum texture)
+    {
+        if (texture == activeTexture)
+        {
+            stats.activeTextures.filtered++;
+            return;
+        }
+        activeTexture = texture;
+        stats.activeTextures.issued++;
+        realActiveTexture(texture);
+    }
+    inline void APIENTRY cacheBindTexture(GLenum target, GLuint texture)
+    {
+        GLuint* slot = textureSlot(target);
+        if (slot && *slot == texture)
+        {
+            stats.textures.filtered++;
+            return;
+        }
+        if (slot)
+            *slot = texture;
+        stats.textures.issued++;
+        realBindTexture(target, texture);
+    }
+    inline void APIENTRY cacheBindBuffer(GLenum target, GLuint buffer)
+    {
+        const int index = bufferTargetIndex(target);
+        if (index >= 0 && buffers[index] == buffer)
+        {
+            stats.buffers.filtered++;
+            return;
+        }
+        if (index >= 0)
+            buffers[index] = buffer;
+        stats.buffers.issued++;
+        realBindBuffer(target, buffer);
+    }
+    // indexed binds also replace the generic binding of their target
+    inline void APIENTRY cacheBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+    {
+        const int slot = bufferTargetIndex(target);
+        if (slot >= 0)
+            buffers[slot] = buffer;
+        realBindBufferBase(target, index, buffer);
+    }
+    inline void APIENTRY cacheBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+    {
+        const int slot = bufferTargetIndex(target);
+        if (slot >= 0)
+            buffers[slot] = buffer;
+        realBindBufferRange(target, index, buffer, offset, size);
+    }
+    // deleting a bound object reverts its binding points to 0, and its name may be handed out again
+    inline void APIENTRY cacheDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+    {
+        for (GLsizei i = 0; i < n; i++)
+        {
+            if (arrays[i] == vertexArray)
+            {
+                vertexArray = 0;
+                buffers[TRACKED_ELEMENT_ARRAY_BUFFER] = 0;
+            }
+        }
+        realDeleteVertexArrays(n, arrays);
+    }
+    inline void APIENTRY cacheDeleteBuffers(GLsizei n, const GLuint* names)
+    {
+        for (GLsizei i = 0; i < n; i++)
+            for (GLuint& buffer : buffers)
+                if (buffer == names[i])
+                    buffer = 0;
+        realDeleteBuffers(n, names);
+    }
+    inline void APIENTRY cacheDeleteTextures(GLsizei n, const GLuint* names)
+    {
+        for (GLsizei i = 0; i < n; i++)
+            for (auto& unit : textures)
+                for (GLuint& texture : unit)
+                    if (texture == names[i])
+                        texture = 0;
+        realDeleteTextures(n, names);
+    }
+
+    // swaps one glad pointer for its wrapper, entry points the context doesn't provide stay null
+    template <typename Proc>
+    inline void wrap(Proc& gladProc, Proc& real, Proc wrapper)
+    {
+        real = gladProc;
+        if (gladProc)
+            gladProc = wrapper;
+    }
+
+    template <typename Proc>
+    inline void unwrap(Proc& gladProc, Proc& real)
+    {
+        if (real)
+            gladProc = real;
+        real = nullptr;
+    }
+
+    // must run after gladLoadGL, every binding starts out unknown
+    inline void install()
+    {
+        if (installed)
+            return;
+        invalidate();
+        wrap(glad_glUseProgram, realUseProgram, cacheUseProgram);
+        wrap(glad_glBindVertexArray, realBindVertexArray, cacheBindVertexArray);
+        wrap(glad_glActiveTexture, realActiveTexture, cacheActiveTexture);
+        wrap(glad_glBindTexture, realBindTexture, cacheBindTexture);
+        wrap(glad_glBindBuffer, realBindBuffer, cacheBindBuffer);
+        wrap(glad_glBindBufferBase, realBindBufferBase, cacheBindBufferBase);
+        wrap(glad_glBindBufferRange, realBindBufferRange, cacheBindBufferRange);
+        wrap(glad_glDeleteVertexArrays, realDeleteVertexArrays, cacheDeleteVertexArrays);
+        wrap(glad_glDeleteBuffers, realDeleteBuffers, cacheDeleteBuffers);
+        wrap(glad_glDeleteTextures, realDeleteTextures, cacheDeleteTextures);
+        installed = true;
+    }
+
+    // restores the pointers saved by install(), wrappers installed on top of the cache have to be removed first
+    inline void uninstall()
+    {
+        if (!installed)
+            return;
+        unwrap(glad_glUseProgram, realUseProgram);
+        unwrap(glad_glBindVertexArray, realBindVertexArray);
+        unwrap(glad_glActiveTexture, realActiveTexture);
+        unwrap(glad_glBindTexture, realBindTexture);
+        unwrap(glad_glBindBuffer, realBindBuffer);
+        unwrap(glad_glBindBufferBase, realBindBufferBase);
+        unwrap(glad_glBindBufferRange, realBindBufferRange);
+        unwrap(glad_glDeleteVertexArrays, realDeleteVertexArrays);
+        unwrap(glad_glDeleteBuffers, realDeleteBuffers);
+        unwrap(glad_glDeleteTextures, realDeleteTextures);
+        installed = false;
+    }
+}
+#endif
@@ -0,0 +1,180 @@
+#ifndef GL_STUB_H
+#define GL_STUB_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Stand-in GL entry points for running renderer code without a window or a context. Object names count up from
+// 1, shaders compile and link, data handed to buffers and textures goes nowhere and draws do nothing. install()
+// points glad's function pointers at the stubs instead of gladLoadGL; every program reports the names in
+// activeUniforms as its active uniforms, at locations 0, 1, 2, ... in that order. GL 4.1 stays unavailable, so the
+// program binary cache is never used. Entry points the stubs don't cover stay null and crash when called.
+namespace GLStub
+{
+    inline std::vector<std::string> activeUniforms;
+    inline GLuint nextName = 1;
+
+    // object names
+    inline void APIENTRY genNames(GLsizei n, GLuint* names)
+    {
+        for (GLsizei i = 0; i < n; i++)
+            names[i] = nextName++;
+    }
+    inline void APIENTRY deleteNames(GLsizei, const GLuint*) {}
+    inline GLuint APIENTRY createObject() { return nextName++; }
+    inline GLuint APIENTRY createShader(GLenum) { return nextName++; }
+    inline void APIENTRY ignoreObject(GLuint) {}
+
+    // shaders and programs
+    inline void APIENTRY shaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) {}
+    inline void APIENTRY attachShader(GLuint, GLuint) {}
+    inline void APIENTRY getShaderiv(GLuint, GLenum pname, GLint* params)
+    {
+        *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+    }
+    inline void APIENTRY getProgramiv(GLuint, GLenum pname, GLint* params)
+    {
+        switch (pname)
+        {
+        case GL_LINK_STATUS:
+            *params = GL_TRUE;
+            break;
+        case GL_ACTIVE_UNIFORMS:
+            *params = static_cast<GLint>(activeUniforms.size());
+            break;
+        case GL_ACTIVE_UNIFORM_MAX_LENGTH:
+        {
+            size_t length = 0;
+            for (const std::string& name : activeUniforms)
+                length = std::max(length, name.size() + 1);
+            *params = static_cast<GLint>(length);
+            break;
+        }
+        default:
+            *params = 0;
+        }
+    }
+    inline void APIENTRY getInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+    {
+        if (length)
+            *length = 0;
+        if (bufSize > 0)
+            infoLog[0] = '\0';
+    }
+    inline void APIENTRY getActiveUniform(GLuint, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+    {
+        const std::string& uniform = activeUniforms[index];
+        const GLsizei copied = std::min(static_cast<GLsizei>(uniform.size()), bufSize - 1);
+        std::memcpy(name, uniform.c_str(), copied);
+        name[copied] = '\0';
+        if (length)
+            *length = copied;
+        *size = 1;
+        *type = GL_FLOAT;
+    }
+    inline GLint APIENTRY getUniformLocation(GLuint, const GLchar* name)
+    {
+        for (size_t i = 0; i < activeUniforms.size(); i++)
+        {
+            if (activeUniforms[i] == name)
+                return static_cast<GLint>(i);
+        }
+        return -1;
+    }
+    inline GLuint APIENTRY getUniformBlockIndex(GLuint, const GLchar*) { return GL_INVALID_INDEX; }
+    inline void APIENTRY uniformBlockBinding(GLuint, GLuint, GLuint) {}
+
+    // uniforms
+    inline void APIENTRY uniform1i(GLint, GLint) {}
+    inline void APIENTRY uniform1f(GLint, GLfloat) {}
+    inline void APIENTRY uniformfv(GLint, GLsizei, const GLfloat*) {}
+    inline void APIENTRY uniformMatrixfv(GLint, GLsizei, GLboolean, const GLfloat*) {}
+
+    // buffers, vertex arrays and textures
+    inline void APIENTRY bindName(GLenum, GLuint) {}
+    inline void APIENTRY bindBufferRange(GLenum, GLuint, GLuint, GLintptr, GLsizeiptr) {}
+    inline void APIENTRY bufferData(GLenum, GLsizeiptr, const void*, GLenum) {}
+    inline void APIENTRY vertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) {}
+    inline void APIENTRY vertexAttribIPointer(GLuint, GLint, GLenum, GLsizei, const void*) {}
+    inline void APIENTRY vertexAttribI4i(GLuint, GLint, GLint, GLint, GLint) {}
+    inline void APIENTRY vertexAttrib4f(GLuint, GLfloat, GLfloat, GLfloat, GLfloat) {}
+    inline void APIENTRY activeTexture(GLenum) {}
+    inline void APIENTRY texImage2D(GLenum, GLint, GLint, GLsizei, GLsizei, GLint, GLenum, GLenum, const void*) {}
+    inline void APIENTRY texParameteri(GLenum, GLenum, GLint) {}
+    inline void APIENTRY generateMipmap(GLenum) {}
+    inline void APIENTRY pixelStorei(GLenum, GLint) {}
+
+    // queries
+    inline void APIENTRY getIntegerv(GLenum, GLint* data) { *data = 0; }
+    inline const GLubyte* APIENTRY getString(GLenum) { return reinterpret_cast<const GLubyte*>("stub"); }
+
+    // draws
+    inline void APIENTRY drawElements(GLenum, GLsizei, GLenum, const void*) {}
+    inline void APIENTRY drawElementsInstanced(GLenum, GLsizei, GLenum, const void*, GLsizei) {}
+    inline void APIENTRY multiDrawElements(GLenum, const GLsizei*, GLenum, const void* const*, GLsizei) {}
+
+    inline void install()
+    {
+        glad_glGenBuffers = genNames;
+        glad_glGenVertexArrays = genNames;
+        glad_glGenTextures = genNames;
+        glad_glDeleteBuffers = deleteNames;
+        glad_glDeleteVertexArrays = deleteNames;
+        glad_glDeleteTextures = deleteNames;
+        glad_glCreateProgram = createObject;
+        glad_glCreateShader = createShader;
+        glad_glDeleteProgram = ignoreObject;
+        glad_glDeleteShader = ignoreObject;
+
+        glad_glShaderSource = shaderSource;
+        glad_glCompileShader = ignoreObject;
+        glad_glAttachShader = attachShader;
+        glad_glLinkProgram = ignoreObject;
+        glad_glGetShaderiv = getShaderiv;
+        glad_glGetProgramiv = getProgramiv;
+        glad_glGetShaderInfoLog = getInfoLog;
+        glad_glGetProgramInfoLog = getInfoLog;
+        glad_glGetActiveUniform = getActiveUniform;
+        glad_glGetUniformLocation = getUniformLocation;
+        glad_glGetUniformBlockIndex = getUniformBlockIndex;
+        glad_glUniformBlockBinding = uniformBlockBinding;
+        glad_glUseProgram = ignoreObject;
+
+        glad_glUniform1i = uniform1i;
+        glad_glUniform1f = uniform1f;
+        glad_glUniform2fv = uniformfv;
+        glad_glUniform3fv = uniformfv;
+        glad_glUniform4fv = uniformfv;
+        glad_glUniformMatrix2fv = uniformMatrixfv;
+        glad_glUniformMatrix3fv = uniformMatrixfv;
+        glad_glUniformMatrix4fv = uniformMatrixfv;
+
+        glad_glBindBuffer = bindName;
+        glad_glBindTexture = bindName;
+        glad_glBindVertexArray = ignoreObject;
+        glad_glBindBufferRange = bindBufferRange;
+        glad_glBufferData = bufferData;
+        glad_glEnableVertexAttribArray = ignoreObject;
+        glad_glVertexAttribPointer = vertexAttribPointer;
+        glad_glVertexAttribIPointer = vertexAttribIPointer;
+        glad_glVertexAttribI4i = vertexAttribI4i;
+        glad_glVertexAttrib4f = vertexAttrib4f;
+        glad_glActiveTexture = activeTexture;
+        glad_glTexImage2D = texImage2D;
+        glad_glTexParameteri = texParameteri;
+        glad_glGenerateMipmap = generateMipmap;
+        glad_glPixelStorei = pixelStorei;
+
+        glad_glGetIntegerv = getIntegerv;
+        glad_glGetString = getString;
+
+        glad_glDrawElements = drawElements;
+        glad_glDrawElementsInstanced = drawElementsInstanced;
+        glad_glMultiDrawElements = multiDrawElements;
+    }
+}
+#endif
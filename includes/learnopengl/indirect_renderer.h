@@ -0,0 +1,224 @@
+#ifndef INDIRECT_RENDERER_H
+#define INDIRECT_RENDERER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/material.h>
+#include <learnopengl/model.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/stream_buffer.h>
+
+#include <algorithm>
+#include <vector>
+
+// layout glMultiDrawElementsIndirect reads from the draw indirect buffer
+struct DrawElementsIndirectCommand
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint  baseVertex;
+    GLuint baseInstance;
+};
+
+// what the last flush sent
+struct IndirectStats
+{
+    unsigned int instances = 0;
+    unsigned int commands = 0;   // one per mesh (or merged draw range) and model lod
+    unsigned int drawCalls = 0;  // glMultiDrawElementsIndirect calls, or instanced draws on the fallback path
+
+    void reset()
+    {
+        *this = IndirectStats();
+    }
+};
+
+// Draws many copies of a few models with a handful of calls. Every add() only records a transform; flush()
+// groups the transforms by model and level of detail into one instance buffer, turns every mesh of every group
+// into an indirect command whose base instance selects the group's transforms, and issues one
+// glMultiDrawElementsIndirect per vertex array and material. Merged models (MODEL_MERGE_MESHES) share one vertex
+// array, so a scene of a single merged model takes one call per material no matter how many entities it has.
+//
+// The shader reads the model matrix from the instance attributes (see instance_buffer.h). Contexts older than
+// GL 4.3 fall back to one glDrawElementsInstanced per command with the same instance data.
+class IndirectRenderer
+{
+public:
+    IndirectStats stats;
+
+    IndirectRenderer() : commandStream(GL_DRAW_INDIRECT_BUFFER, 256 * sizeof(DrawElementsIndirectCommand))
+    {
+    }
+
+    // queues one copy of model at the given level of detail
+    void add(Model &model, unsigned int lod, const glm::mat4 &transform)
+    {
+        InstanceData instance;
+        instance.model = transform;
+        findGroup(model, lod).instances.push_back(instance);
+    }
+
+    // draws everything added since the last flush
+    void flush(Shader &shader)
+    {
+        stats.reset();
+        // a model nothing was added for may have been unloaded since, its group goes with the pointer to it
+        groups.erase(std::remove_if(groups.begin(), groups.end(), [](const Group &group) { return group.instances.empty(); }), groups.end());
+        allInstances.clear();
+        for (Group &group : groups)
+        {
+            group.firstInstance = static_cast<GLuint>(allInstances.size());
+            allInstances.insert(allInstances.end(), group.instances.begin(), group.instances.end());
+        }
+        if (allInstances.empty())
+            return;
+
+        for (Batch &batch : batches)
+            batch.commands.clear();
+        for (Group &group : groups)
+        {
+            addCommands(group, shader);
+            group.instances.clear();
+        }
+        // likewise for the materials of the groups that are gone
+        batches.erase(std::remove_if(batches.begin(), batches.end(), [](const Batch &batch) { return batch.commands.empty(); }), batches.end());
+        instances.upload(allInstances);
+        stats.instances = static_cast<unsigned int>(allInstances.size());
+
+        // every batch's commands end up next to each other in one upload
+        const bool indirect = GLAD_GL_VERSION_4_3 != 0;
+        size_t commandOffset = 0;
+        if (indirect)
+        {
+            allCommands.clear();
+            for (Batch &batch : batches)
+            {
+                batch.firstCommand = allCommands.size();
+                allCommands.insert(allCommands.end(), batch.commands.begin(), batch.commands.end());
+            }
+            commandStream.nextFrame();
+            commandOffset = commandStream.write(&allCommands[0], allCommands.size() * sizeof(DrawElementsIndirectCommand), sizeof(DrawElementsIndirectCommand));
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandStream.buffer);
+        }
+
+        shader.use();
+        // only vertex arrays without a bone stream read these, see Mesh::setUnskinnedAttributes
+        Mesh::setUnskinnedAttributes();
+        for (const Batch &batch : batches)
+        {
+            stats.commands += static_cast<unsigned int>(batch.commands.size());
+            glBindVertexArray(batch.VAO);
+            batch.material->bind(shader);
+            if (indirect)
+            {
+                instances.attach(batch.VAO);
+                const size_t offset = commandOffset + batch.firstCommand * sizeof(DrawElementsIndirectCommand);
+                glMultiDrawElementsIndirect(GL_TRIANGLES, batch.indexType, (void*)offset, static_cast<GLsizei>(batch.commands.size()), 0);
+                stats.drawCalls++;
+                continue;
+            }
+            // without base instances the attributes are pointed at every group's transforms in turn
+            const size_t indexSize = batch.indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+            for (const DrawElementsIndirectCommand &command : batch.commands)
+            {
+                instances.attach(batch.VAO, command.baseInstance);
+                glDrawElementsInstanced(GL_TRIANGLES, command.count, batch.indexType, (void*)(command.firstIndex * indexSize), command.instanceCount);
+                stats.drawCalls++;
+            }
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    StreamBufferStats &instanceUploadStats()
+    {
+        return instances.stream.stats;
+    }
+
+private:
+    // all copies of one model at one level of detail
+    struct Group
+    {
+        Model* model;
+        unsigned int lod;
+        vector<InstanceData> instances;
+        GLuint firstInstance = 0;
+    };
+
+    // commands sharing vertex array, textures and index type, drawn with one call
+    struct Batch
+    {
+        unsigned int VAO;
+        const MaterialBinding* material;
+        GLenum indexType;
+        vector<DrawElementsIndirectCommand> commands;
+        size_t firstCommand = 0;
+    };
+
+    // groups and batches used in a frame are kept for the next so their arrays don't have to be allocated again,
+    // the ones that drew nothing are dropped by the flush after it
+    vector<Group> groups;
+    vector<Batch> batches;
+    vector<InstanceData> allInstances;
+    vector<DrawElementsIndirectCommand> allCommands;
+    InstanceBuffer instances;
+    StreamBuffer commandStream;
+
+    Group& findGroup(Model &model, unsigned int lod)
+    {
+        lod = std::min<unsigned int>(lod, MAX_MESH_LODS - 1);
+        for (Group &group : groups)
+        {
+            if (group.model == &model && group.lod == lod)
+                return group;
+        }
+        groups.push_back(Group{ &model, lod, {}, 0 });
+        return groups.back();
+    }
+
+    Batch& findBatch(unsigned int VAO, const MaterialBinding &material, GLenum indexType)
+    {
+        for (Batch &batch : batches)
+        {
+            if (batch.VAO == VAO && batch.material == &material && batch.indexType == indexType)
+                return batch;
+        }
+        batches.push_back(Batch{ VAO, &material, indexType, {}, 0 });
+        return batches.back();
+    }
+
+    // one command per draw range of the group's model, the same ranges Model::Draw would draw
+    void addCommands(const Group &group, Shader &shader)
+    {
+        const GLuint instanceCount = static_cast<GLuint>(group.instances.size());
+        Model &model = *group.model;
+        if (model.batch.isUploaded())
+        {
+            MeshBatch &merged = model.batch;
+            const size_t indexSize = merged.indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+            for (MeshBatch::Material &material : merged.materials)
+            {
+                const vector<GLsizei> &counts = material.counts[group.lod];
+                if (counts.empty())
+                    continue;
+                Batch &batch = findBatch(merged.VAO, material.cache.get(shader, material.textures), merged.indexType);
+                for (size_t i = 0; i < counts.size(); i++)
+                {
+                    const GLuint firstIndex = static_cast<GLuint>((size_t)material.offsets[group.lod][i] / indexSize);
+                    batch.commands.push_back({ static_cast<GLuint>(counts[i]), instanceCount, firstIndex, 0, group.firstInstance });
+                }
+            }
+            return;
+        }
+        for (Mesh &mesh : model.meshes)
+        {
+            const MeshLod &level = mesh.lods[std::min<size_t>(group.lod, mesh.lods.size() - 1)];
+            Batch &batch = findBatch(mesh.VAO, mesh.material.get(shader, mesh.textures), mesh.indexType);
+            batch.commands.push_back({ level.indexCount, instanceCount, level.indexOffset, 0, group.firstInstance });
+        }
+    }
+};
+#endif
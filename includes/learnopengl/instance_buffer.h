@@ -0,0 +1,127 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/stream_buffer.h>
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+// vertex attribute locations of the per instance data, after the mesh (0-4) and bone (5-6) streams.
+// An instanced vertex shader declares them as
+//     layout (location = 7)  in mat4 aInstanceModel;   // takes 7 to 10, one column each
+//     layout (location = 11) in vec4 aInstanceColor;
+//     layout (location = 12) in vec4 aInstanceCustom;
+#define INSTANCE_ATTRIB_MODEL  7
+#define INSTANCE_ATTRIB_COLOR  11
+#define INSTANCE_ATTRIB_CUSTOM 12
+
+// what every instance of an instanced draw gets, custom is free for the shader to interpret
+struct InstanceData {
+    glm::mat4 model  = glm::mat4(1.0f);
+    glm::vec4 color  = glm::vec4(1.0f);
+    glm::vec4 custom = glm::vec4(0.0f);
+};
+
+// InstanceData written every frame through a StreamBuffer and read with an attribute divisor of 1, so one
+// glDrawElementsInstanced draws a mesh once for every element instead of one draw call per copy.
+class InstanceBuffer
+{
+public:
+    StreamBuffer stream;
+
+    InstanceBuffer() : stream(GL_ARRAY_BUFFER, 256 * sizeof(InstanceData))
+    {
+    }
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    // replaces the contents with count instances. Draws issued since the previous upload are fenced first,
+    // the new data goes to the next region of the stream so they can still read theirs.
+    void upload(const InstanceData* data, size_t count)
+    {
+        stream.nextFrame();
+        instanceCount = static_cast<GLsizei>(count);
+        if (count > 0)
+            offset = stream.write(data, count * sizeof(InstanceData), sizeof(InstanceData));
+    }
+
+    void upload(const std::vector<InstanceData>& instances)
+    {
+        upload(instances.empty() ? nullptr : &instances[0], instances.size());
+    }
+
+    // instances written by the last upload
+    GLsizei count() const
+    {
+        return instanceCount;
+    }
+
+    // Points the instance attributes of the vertex array VAO, which has to be bound, at the last upload. Attribute
+    // pointers are vertex array state and the upload moves through the stream every frame, so this re-points
+    // them once per vertex array and frame and does nothing for the other draws of the frame. firstInstance
+    // starts the attributes further into the upload, for contexts without base instance draws.
+    void attach(unsigned int VAO, size_t firstInstance = 0) const
+    {
+        const size_t offset = this->offset + firstInstance * sizeof(InstanceData);
+        Attachment& attached = attachedBuffers()[VAO];
+        if (attached.generation == stream.generation && attached.offset == offset)
+            return;
+        attached.generation = stream.generation;
+        attached.offset = offset;
+
+        glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+        // a mat4 attribute is four vec4 attributes, one per column
+        for (unsigned int column = 0; column < 4; column++)
+        {
+            glEnableVertexAttribArray(INSTANCE_ATTRIB_MODEL + column);
+            glVertexAttribPointer(INSTANCE_ATTRIB_MODEL + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                  (void*)(offset + offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(INSTANCE_ATTRIB_MODEL + column, 1);
+        }
+        glEnableVertexAttribArray(INSTANCE_ATTRIB_COLOR);
+        glVertexAttribPointer(INSTANCE_ATTRIB_COLOR, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, color)));
+        glVertexAttribDivisor(INSTANCE_ATTRIB_COLOR, 1);
+        glEnableVertexAttribArray(INSTANCE_ATTRIB_CUSTOM);
+        glVertexAttribPointer(INSTANCE_ATTRIB_CUSTOM, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (void*)(offset + offsetof(InstanceData, custom)));
+        glVertexAttribDivisor(INSTANCE_ATTRIB_CUSTOM, 1);
+    }
+
+    // has to be called when a vertex array is deleted, its name may be handed out again
+    static void forget(unsigned int VAO)
+    {
+        attachedBuffers().erase(VAO);
+    }
+
+    // like meshes the buffer is not deleted on destruction, which may happen after the context is gone
+    void release()
+    {
+        for (auto it = attachedBuffers().begin(); it != attachedBuffers().end();)
+            it = it->second.generation == stream.generation ? attachedBuffers().erase(it) : ++it;
+        stream.release();
+        instanceCount = 0;
+        offset = 0;
+    }
+
+private:
+    GLsizei instanceCount = 0;
+    size_t offset = 0; // of the last upload in the stream
+
+    struct Attachment
+    {
+        unsigned int generation = 0; // of the stream's buffer, its name alone may be reused after the ring grows
+        size_t offset = 0;
+    };
+
+    // where the instance attributes of every vertex array currently point
+    static std::unordered_map<unsigned int, Attachment>& attachedBuffers()
+    {
+        static std::unordered_map<unsigned int, Attachment> buffers;
+        return buffers;
+    }
+};
+#endif
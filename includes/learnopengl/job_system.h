@@ -0,0 +1,139 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads for data parallel loops. parallelFor splits [0, count) into chunks of at least
+// grain elements and runs them on the workers and the calling thread, returning once every chunk is done.
+// Loops too small for one chunk run inline, so callers don't need a separate serial path.
+class JobSystem
+{
+public:
+    // workers in addition to the calling thread, by default one less than the hardware threads
+    explicit JobSystem(unsigned int workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1)
+    {
+        for (unsigned int i = 0; i < workerCount; i++)
+            workers.emplace_back([this]() { workerLoop(); });
+    }
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // threads a loop is spread over, the caller included
+    unsigned int threadCount() const
+    {
+        return static_cast<unsigned int>(workers.size()) + 1;
+    }
+
+    // calls body(begin, end) for consecutive ranges covering [0, count), concurrently
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body)
+    {
+        grain = std::max<size_t>(grain, 1);
+        if (workers.empty() || count <= grain)
+        {
+            if (count > 0)
+                body(0, count);
+            return;
+        }
+        // a few chunks per thread even out ranges that take longer than others
+        const size_t chunkSize = std::max(grain, (count + threadCount() * 4 - 1) / (threadCount() * 4));
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job.body = &body;
+            job.count = count;
+            job.chunkSize = chunkSize;
+            job.nextChunk = 0;
+            job.chunks = (count + chunkSize - 1) / chunkSize;
+            job.pending = job.chunks;
+            generation++;
+        }
+        wake.notify_all();
+        const size_t finished = runChunks();
+
+        // workers that woke up for this loop may still look at it, the next one can't start before they let go
+        std::unique_lock<std::mutex> lock(mutex);
+        job.pending -= finished;
+        done.wait(lock, [this]() { return job.pending == 0 && busyWorkers == 0; });
+        job.body = nullptr;
+    }
+
+    // shared by the systems of the program
+    static JobSystem& shared()
+    {
+        static JobSystem jobs;
+        return jobs;
+    }
+
+private:
+    struct Job
+    {
+        const std::function<void(size_t, size_t)>* body = nullptr;
+        size_t count = 0;
+        size_t chunkSize = 0;
+        size_t chunks = 0;
+        std::atomic<size_t> nextChunk{ 0 };
+        size_t pending = 0; // chunks not finished yet, guarded by mutex
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    Job job;
+    unsigned long long generation = 0;
+    unsigned int busyWorkers = 0;
+    bool stopping = false;
+
+    // takes chunks of the current job until none are left, returns how many it ran
+    size_t runChunks()
+    {
+        size_t finished = 0;
+        for (size_t chunk = job.nextChunk++; chunk < job.chunks; chunk = job.nextChunk++)
+        {
+            const size_t begin = chunk * job.chunkSize;
+            (*job.body)(begin, std::min(begin + job.chunkSize, job.count));
+            finished++;
+        }
+        return finished;
+    }
+
+    void workerLoop()
+    {
+        unsigned long long seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [&]() { return stopping || (generation != seen && job.body != nullptr); });
+                if (stopping)
+                    return;
+                seen = generation;
+                busyWorkers++;
+            }
+            const size_t finished = runChunks();
+            std::lock_guard<std::mutex> lock(mutex);
+            job.pending -= finished;
+            busyWorkers--;
+            if (job.pending == 0 && busyWorkers == 0)
+                done.notify_all();
+        }
+    }
+};
+#endif
@@ -0,0 +1,61 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <cmath>
+
+// screen size thresholds used to pick a mesh level of detail
+struct LodSettings
+{
+    // level i + 1 is used once the bounding sphere covers less than thresholds[i] of the screen height
+    float thresholds[MAX_MESH_LODS - 1] = { 0.25f, 0.10f, 0.04f };
+    // relative band around each threshold in which the current level is kept, avoids popping back and forth
+    float hysteresis = 0.15f;
+};
+
+// everything a draw call needs to know about the camera to pick a level
+struct LodView
+{
+    glm::vec3 cameraPosition{ 0.0f };
+    float fovY = glm::radians(45.0f); // vertical field of view in radians
+    LodSettings settings;
+};
+
+// per frame counters of what was actually drawn
+struct LodStats
+{
+    unsigned int triangles = 0;
+    unsigned int drawsPerLod[MAX_MESH_LODS] = {};
+
+    void reset()
+    {
+        *this = LodStats();
+    }
+};
+
+// fraction of the screen height covered by the diameter of a sphere, 1.0 or more when the camera is inside it
+inline float projectedSphereSize(const glm::vec3& center, float radius, const glm::vec3& cameraPosition, float fovY)
+{
+    const float distance = glm::length(center - cameraPosition);
+    if (distance <= radius)
+        return 1.0f;
+    return radius / (distance * std::tan(fovY * 0.5f));
+}
+
+// picks a level for the given screen size, starting from the level used last frame so the
+// hysteresis band can keep it where it is
+inline unsigned int selectLod(unsigned int currentLod, unsigned int lodCount, float screenSize, const LodSettings& settings)
+{
+    if (lodCount <= 1)
+        return 0;
+    unsigned int lod = currentLod < lodCount ? currentLod : lodCount - 1;
+    while (lod + 1 < lodCount && screenSize < settings.thresholds[lod] * (1.0f - settings.hysteresis))
+        lod++;
+    while (lod > 0 && screenSize > settings.thresholds[lod - 1] * (1.0f + settings.hysteresis))
+        lod--;
+    return lod;
+}
+#endif
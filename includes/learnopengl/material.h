@@ -0,0 +1,107 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/shader.h>
+
+#include <deque>
+#include <string>
+#include <vector>
+using namespace std;
+
+// what a texture is used for, decides the sampler it is bound to (texture_diffuseN, texture_specularN, ...)
+enum TextureType {
+    TEXTURE_DIFFUSE,
+    TEXTURE_SPECULAR,
+    TEXTURE_NORMAL,
+    TEXTURE_HEIGHT,
+    TEXTURE_TYPE_COUNT
+};
+
+struct Texture {
+    unsigned int id;
+    TextureType type;
+    string path;
+};
+
+// samplers of one type a shader can use, texture_diffuse1 up to texture_diffuse4
+#define MAX_SAMPLERS_PER_TYPE 4
+
+// sampler names live in static storage so bindings can point at them without copying strings
+inline const char* samplerName(TextureType type, unsigned int number)
+{
+    static const char* const names[TEXTURE_TYPE_COUNT][MAX_SAMPLERS_PER_TYPE] = {
+        { "texture_diffuse1",  "texture_diffuse2",  "texture_diffuse3",  "texture_diffuse4"  },
+        { "texture_specular1", "texture_specular2", "texture_specular3", "texture_specular4" },
+        { "texture_normal1",   "texture_normal2",   "texture_normal3",   "texture_normal4"   },
+        { "texture_height1",   "texture_height2",   "texture_height3",   "texture_height4"   }
+    };
+    return number < MAX_SAMPLERS_PER_TYPE ? names[type][number] : nullptr;
+}
+
+// A texture list resolved against one shader: which texture goes to which unit and which entry of the shader's
+// uniform table holds the sampler. Textures whose sampler the shader doesn't use are left out entirely.
+struct MaterialBinding
+{
+    struct Slot
+    {
+        int uniform;            // index into the shader's UniformTable
+        int unit;               // texture unit, also the sampler value
+        unsigned int textureId;
+    };
+
+    unsigned int shaderId = 0;
+    vector<Slot> slots;
+
+    void resolve(const Shader &shader, const vector<Texture> &textures)
+    {
+        shaderId = shader.ID;
+        slots.clear();
+        unsigned int typeCount[TEXTURE_TYPE_COUNT] = {};
+        for (unsigned int i = 0; i < textures.size(); i++)
+        {
+            // the N in texture_diffuseN counts the textures of the same type, starting at 1
+            const char* name = samplerName(textures[i].type, typeCount[textures[i].type]++);
+            if (!name)
+                continue;
+            const int uniform = shader.uniforms.indexOf(name);
+            if (uniform < 0)
+                continue;
+            slots.push_back({ uniform, static_cast<int>(i), textures[i].id });
+        }
+    }
+
+    // binds the textures and points the samplers at them, no lookups and no allocations
+    void bind(const Shader &shader) const
+    {
+        for (const Slot &slot : slots)
+        {
+            GLint location;
+            if (shader.uniforms.update(slot.uniform, &slot.unit, sizeof(slot.unit), location))
+                glUniform1i(location, slot.unit);
+            glActiveTexture(GL_TEXTURE0 + slot.unit);
+            glBindTexture(GL_TEXTURE_2D, slot.textureId);
+        }
+    }
+};
+
+// the bindings of one texture list for every shader it was drawn with, usually just one or two. A deque keeps
+// references to earlier bindings valid when a new shader is added, a render queue may still hold them.
+struct MaterialCache
+{
+    deque<MaterialBinding> bindings;
+
+    const MaterialBinding& get(const Shader &shader, const vector<Texture> &textures)
+    {
+        for (const MaterialBinding &binding : bindings)
+        {
+            if (binding.shaderId == shader.ID)
+                return binding;
+        }
+        bindings.emplace_back();
+        bindings.back().resolve(shader, textures);
+        return bindings.back();
+    }
+};
+#endif
@@ -0,0 +1,67 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include <cstddef>
+
+#if defined(_WIN32)
+// keeps windows.h from defining min and max macros, which break std::min and std::max in every includer
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#else
+#include <cstdio>
+#include <cstring>
+#endif
+
+// resident set size of the current process, used to measure what loading assets really costs
+struct MemoryUsage
+{
+    size_t currentBytes = 0; // resident right now
+    size_t peakBytes = 0;    // high water mark since the process started
+
+    static MemoryUsage query()
+    {
+        MemoryUsage usage;
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            usage.currentBytes = counters.WorkingSetSize;
+            usage.peakBytes = counters.PeakWorkingSetSize;
+        }
+#elif defined(__APPLE__)
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) == KERN_SUCCESS)
+            usage.currentBytes = info.resident_size;
+        struct rusage resources;
+        if (getrusage(RUSAGE_SELF, &resources) == 0)
+            usage.peakBytes = static_cast<size_t>(resources.ru_maxrss); // bytes on macOS
+#else
+        // VmRSS and VmHWM are reported in kB
+        if (FILE* status = std::fopen("/proc/self/status", "r"))
+        {
+            char line[256];
+            while (std::fgets(line, sizeof(line), status))
+            {
+                unsigned long kiloBytes = 0;
+                if (std::sscanf(line, "VmRSS: %lu", &kiloBytes) == 1)
+                    usage.currentBytes = kiloBytes * 1024;
+                else if (std::sscanf(line, "VmHWM: %lu", &kiloBytes) == 1)
+                    usage.peakBytes = kiloBytes * 1024;
+            }
+            std::fclose(status);
+        }
+#endif
+        return usage;
+    }
+};
+#endif
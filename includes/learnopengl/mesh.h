@@ -6,13 +6,26 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/material.h>
+#include <learnopengl/render_queue.h>
 #include <learnopengl/shader.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 using namespace std;
 
 #define MAX_BONE_INFLUENCE 4
+#define MAX_MESH_LODS 4
+
+// optional processing steps a Model can apply to its meshes at load time, combine with |
+enum ModelFlags {
+    MODEL_OPTIMIZE_INDICES     = 1 << 0, // reorder triangles and vertices for cache, overdraw and fetch locality
+    MODEL_GENERATE_LODS        = 1 << 1, // build up to MAX_MESH_LODS - 1 simplified index buffers per mesh
+    MODEL_RELEASE_CPU_GEOMETRY = 1 << 2, // free vertices, indices and bone data once they are uploaded
+    MODEL_MERGE_MESHES         = 1 << 3  // pack all meshes into one buffer and draw them per material with multi draw
+};
 
 struct Vertex {
     // position
@@ -25,16 +38,20 @@ struct Vertex {
     glm::vec3 Tangent;
     // bitangent
     glm::vec3 Bitangent;
+};
+
+// skinning data lives in its own vertex stream so static meshes don't pay for it
+struct BoneVertex {
 	//bone indexes which will influence this vertex
 	int m_BoneIDs[MAX_BONE_INFLUENCE];
 	//weights from each bone
 	float m_Weights[MAX_BONE_INFLUENCE];
 };
 
-struct Texture {
-    unsigned int id;
-    string type;
-    string path;
+// one level of detail, a range of the mesh's element buffer. All levels share the vertex buffer.
+struct MeshLod {
+    unsigned int indexOffset; // in indices, not bytes
+    unsigned int indexCount;
 };
 
 class Mesh {
@@ -43,64 +60,177 @@ public:
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
+    vector<BoneVertex>   boneData; // empty for static meshes
+    MaterialCache        material; // textures resolved against every shader the mesh was drawn with
     unsigned int VAO;
+    GLenum indexType = GL_UNSIGNED_INT; // GL_UNSIGNED_SHORT when every index fits in 16 bits
+    vector<MeshLod>      lods;              // lods[0] is the full resolution mesh described by indices
+    // derived data that stays valid after releaseCpuGeometry
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    unsigned int vertexCount = 0;
 
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    // constructor, pass boneData only for meshes that are actually skinned. lodIndices holds the
+    // index buffers of the simplified levels, they are only uploaded and not kept on the CPU.
+    // Every array is moved into the mesh, pass them with std::move to avoid copying the geometry.
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, vector<BoneVertex> boneData = vector<BoneVertex>(),
+         vector<vector<unsigned int>> lodIndices = vector<vector<unsigned int>>())
+        : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures)), boneData(std::move(boneData))
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
-
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        setupMesh(lodIndices);
     }
 
-    // render the mesh
-    void Draw(Shader &shader) 
+    // a mesh owns its geometry and GL objects, it can be moved but never copied
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh(Mesh&&) = default;
+    Mesh& operator=(Mesh&&) = default;
+
+    // render the mesh, lod is clamped to the levels this mesh actually has
+    void Draw(Shader &shader, unsigned int lod = 0)
     {
-        // bind appropriate textures
-        unsigned int diffuseNr  = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr   = 1;
-        unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to string
-            else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to string
-             else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to string
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
-        }
+        // bind appropriate textures, the sampler setup for this shader is resolved on the first draw
+        material.get(shader, textures).bind(shader);
         
         // draw mesh
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+        if (!skinned)
+            setUnskinnedAttributes();
+        const MeshLod& level = lods[std::min<size_t>(lod, lods.size() - 1)];
+        const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+        glDrawElements(GL_TRIANGLES, level.indexCount, indexType, (void*)(level.indexOffset * indexSize));
 
-        // always good practice to set everything back to defaults once configured.
+        // the vertex array stays bound, every draw and every buffer setup binds its own first. Unit 0 is
+        // restored since texture loading binds to the active unit; with GLStateCache that is free when it already is.
         glActiveTexture(GL_TEXTURE0);
     }
 
+    // draws the mesh once for every instance in instances, their transforms and colours come from the buffer
+    void DrawInstanced(Shader &shader, const InstanceBuffer &instances, unsigned int lod = 0)
+    {
+        if (instances.count() == 0)
+            return;
+        material.get(shader, textures).bind(shader);
+
+        glBindVertexArray(VAO);
+        instances.attach(VAO);
+        if (!skinned)
+            setUnskinnedAttributes();
+        const MeshLod& level = lods[std::min<size_t>(lod, lods.size() - 1)];
+        const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+        glDrawElementsInstanced(GL_TRIANGLES, level.indexCount, indexType, (void*)(level.indexOffset * indexSize), instances.count());
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // queues the mesh instead of drawing it right away, packet carries the pass, transform and colour
+    void Submit(RenderQueue &queue, Shader &shader, DrawPacket packet, unsigned int lod = 0)
+    {
+        const MeshLod& level = lods[std::min<size_t>(lod, lods.size() - 1)];
+        const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+        packet.shader = &shader;
+        packet.material = &material.get(shader, textures);
+        packet.VAO = VAO;
+        packet.indexType = indexType;
+        packet.count = level.indexCount;
+        packet.offset = (void*)(level.indexOffset * indexSize);
+        queue.submit(packet);
+    }
+
+    // skinned meshes carry a second vertex stream with bone ids and weights
+    bool isSkinned() const
+    {
+        return skinned;
+    }
+
+    // frees the CPU copy of the geometry, the GPU buffers, bounds and lods stay valid
+    void releaseCpuGeometry()
+    {
+        vector<Vertex>().swap(vertices);
+        vector<unsigned int>().swap(indices);
+        vector<BoneVertex>().swap(boneData);
+    }
+
+    // bytes of geometry still held on the CPU
+    size_t cpuGeometryBytes() const
+    {
+        return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int) + boneData.capacity() * sizeof(BoneVertex);
+    }
+
+    // deletes the vertex array and buffers, for meshes that are only drawn through a merged MeshBatch.
+    // Draw must not be called afterwards.
+    void releaseGpuBuffers()
+    {
+        InstanceBuffer::forget(VAO);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        if (boneVBO != 0)
+            glDeleteBuffers(1, &boneVBO);
+        VAO = VBO = EBO = boneVBO = 0;
+    }
+
+    // attribute layout of the Vertex stream (locations 0-4), the vertex buffer has to be bound
+    static void setVertexAttributes()
+    {
+        // vertex Positions
+        glEnableVertexAttribArray(0);	
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        // vertex normals
+        glEnableVertexAttribArray(1);	
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        // vertex texture coords
+        glEnableVertexAttribArray(2);	
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+        // vertex tangent
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+        // vertex bitangent
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+    }
+
+    // attribute layout of the BoneVertex stream (locations 5-6), the bone buffer has to be bound
+    static void setBoneAttributes()
+    {
+        // ids
+        glEnableVertexAttribArray(5);
+        glVertexAttribIPointer(5, 4, GL_INT, sizeof(BoneVertex), (void*)offsetof(BoneVertex, m_BoneIDs));
+
+        // weights
+        glEnableVertexAttribArray(6);
+        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(BoneVertex), (void*)offsetof(BoneVertex, m_Weights));
+    }
+
+    // the values a disabled attribute 5 and 6 read, no bone and no weight so a skinning shader keeps the bind pose.
+    // They are context state rather than vertex array state, so they are set before drawing a mesh without bones.
+    static void setUnskinnedAttributes()
+    {
+        glVertexAttribI4i(5, -1, -1, -1, -1);
+        glVertexAttrib4f(6, 0.0f, 0.0f, 0.0f, 0.0f);
+    }
+
 private:
     // render data 
     unsigned int VBO, EBO;
+    unsigned int boneVBO = 0;
+    bool skinned = false;
 
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const vector<vector<unsigned int>>& lodIndices)
     {
+        // bounds are kept so culling keeps working once the CPU geometry is released
+        vertexCount = static_cast<unsigned int>(vertices.size());
+        if (!vertices.empty())
+        {
+            boundsMin = boundsMax = vertices[0].Position;
+            for (const Vertex& vertex : vertices)
+            {
+                boundsMin = glm::min(boundsMin, vertex.Position);
+                boundsMax = glm::max(boundsMax, vertex.Position);
+            }
+        }
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
@@ -114,32 +244,55 @@ private:
         // again translates to 3/2 floats which translates to a byte array.
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
 
+        // all levels of detail go into one element buffer, full resolution first
+        lods.clear();
+        lods.push_back({ 0, static_cast<unsigned int>(indices.size()) });
+        size_t totalIndices = indices.size();
+        for (const auto& level : lodIndices)
+        {
+            lods.push_back({ static_cast<unsigned int>(totalIndices), static_cast<unsigned int>(level.size()) });
+            totalIndices += level.size();
+        }
+
+        // meshes with at most 65535 vertices get a 16-bit index buffer, halving index memory and fetch
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        if (vertices.size() <= 0xFFFF)
+        {
+            vector<unsigned short> shortIndices(indices.begin(), indices.end());
+            shortIndices.reserve(totalIndices);
+            for (const auto& level : lodIndices)
+                shortIndices.insert(shortIndices.end(), level.begin(), level.end());
+            indexType = GL_UNSIGNED_SHORT;
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(unsigned short), &shortIndices[0], GL_STATIC_DRAW);
+        }
+        else if (lodIndices.empty())
+        {
+            indexType = GL_UNSIGNED_INT;
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        }
+        else
+        {
+            vector<unsigned int> allIndices(indices);
+            allIndices.reserve(totalIndices);
+            for (const auto& level : lodIndices)
+                allIndices.insert(allIndices.end(), level.begin(), level.end());
+            indexType = GL_UNSIGNED_INT;
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, allIndices.size() * sizeof(unsigned int), &allIndices[0], GL_STATIC_DRAW);
+        }
 
         // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);	
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);	
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-		// ids
-		glEnableVertexAttribArray(5);
-		glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
+        setVertexAttributes();
 
-		// weights
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+        // bone ids and weights come from a separate buffer that only skinned meshes allocate and bind,
+        // static meshes leave attributes 5 and 6 disabled and get setUnskinnedAttributes before every draw.
+        skinned = !boneData.empty();
+        if (skinned)
+        {
+            glGenBuffers(1, &boneVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, boneVBO);
+            glBufferData(GL_ARRAY_BUFFER, boneData.size() * sizeof(BoneVertex), &boneData[0], GL_STATIC_DRAW);
+            setBoneAttributes();
+        }
         glBindVertexArray(0);
     }
 };
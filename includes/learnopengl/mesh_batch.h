@@ -0,0 +1,266 @@
+#ifndef MESH_BATCH_H
+#define MESH_BATCH_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/shader.h>
+
+#include <algorithm>
+#include <vector>
+
+// All meshes of a model packed into one vertex buffer and one element buffer, grouped by material.
+// Drawing binds the textures once per material and submits all of its meshes with a single
+// glMultiDrawElements, instead of one texture setup and one glDrawElements per mesh.
+class MeshBatch
+{
+public:
+    // meshes sharing exactly the same textures
+    struct Material
+    {
+        vector<Texture> textures;
+        MaterialCache cache;
+        // one draw range per mesh for every level of detail, offsets are in bytes as glMultiDrawElements expects
+        vector<GLsizei>     counts[MAX_MESH_LODS];
+        vector<const void*> offsets[MAX_MESH_LODS];
+    };
+
+    vector<Material> materials;
+    unsigned int VAO = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+
+    // stages the geometry of one mesh, levels[0] is the full resolution index buffer and the rest its lods.
+    // Nothing is sent to the GPU before upload().
+    void add(const vector<Vertex> &vertices, const vector<unsigned int> &indices, const vector<vector<unsigned int>> &lodIndices,
+             const vector<BoneVertex> &boneData, const vector<Texture> &textures)
+    {
+        StagedMesh staged;
+        staged.vertices = vertices;
+        staged.boneData = boneData;
+        staged.levels.reserve(lodIndices.size() + 1);
+        staged.levels.push_back(indices);
+        staged.levels.insert(staged.levels.end(), lodIndices.begin(), lodIndices.end());
+        staged.material = findMaterial(textures);
+        staging.push_back(std::move(staged));
+    }
+
+    // packs the staged meshes material by material and uploads them, the staged copies are freed afterwards
+    void upload()
+    {
+        if (staging.empty())
+            return;
+
+        size_t vertexCount = 0;
+        bool skinned = false;
+        for (const StagedMesh &staged : staging)
+        {
+            vertexCount += staged.vertices.size();
+            skinned = skinned || !staged.boneData.empty();
+        }
+        indexType = vertexCount <= 0xFFFF ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+
+        vector<Vertex> vertices;
+        vector<BoneVertex> boneData;
+        vector<unsigned int> indices;
+        vertices.reserve(vertexCount);
+        if (skinned)
+            boneData.reserve(vertexCount);
+
+        // static meshes merged with skinned ones get bone data that leaves them in bind pose
+        BoneVertex unskinned;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            unskinned.m_BoneIDs[i] = -1;
+            unskinned.m_Weights[i] = 0.0f;
+        }
+
+        // meshes of the same material end up next to each other, every level of a mesh follows the
+        // previous one so a mesh with a shorter chain keeps using its coarsest level
+        for (unsigned int m = 0; m < materials.size(); m++)
+        {
+            for (const StagedMesh &staged : staging)
+            {
+                if (staged.material != m)
+                    continue;
+                const unsigned int baseVertex = static_cast<unsigned int>(vertices.size());
+                vertices.insert(vertices.end(), staged.vertices.begin(), staged.vertices.end());
+                if (skinned)
+                {
+                    if (staged.boneData.empty())
+                        boneData.insert(boneData.end(), staged.vertices.size(), unskinned);
+                    else
+                        boneData.insert(boneData.end(), staged.boneData.begin(), staged.boneData.end());
+                }
+
+                size_t levelOffsets[MAX_MESH_LODS];
+                const size_t levelCount = std::min<size_t>(staged.levels.size(), MAX_MESH_LODS);
+                for (size_t level = 0; level < levelCount; level++)
+                {
+                    levelOffsets[level] = indices.size();
+                    for (unsigned int index : staged.levels[level])
+                        indices.push_back(index + baseVertex);
+                }
+                for (unsigned int lod = 0; lod < MAX_MESH_LODS; lod++)
+                {
+                    const size_t level = std::min<size_t>(lod, levelCount - 1);
+                    addRange(materials[m], lod, levelOffsets[level] * indexSize, staged.levels[level].size(), indexSize);
+                }
+            }
+        }
+        vector<StagedMesh>().swap(staging);
+        if (vertices.empty() || indices.empty())
+            return;
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        Mesh::setVertexAttributes();
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        if (indexType == GL_UNSIGNED_SHORT)
+        {
+            vector<unsigned short> shortIndices(indices.begin(), indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(unsigned short), &shortIndices[0], GL_STATIC_DRAW);
+        }
+        else
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+
+        if (skinned)
+        {
+            glGenBuffers(1, &boneVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, boneVBO);
+            glBufferData(GL_ARRAY_BUFFER, boneData.size() * sizeof(BoneVertex), &boneData[0], GL_STATIC_DRAW);
+            Mesh::setBoneAttributes();
+        }
+        glBindVertexArray(0);
+    }
+
+    bool isUploaded() const
+    {
+        return VAO != 0;
+    }
+
+    // deletes the buffers and forgets the materials, the batch can be filled and uploaded again
+    void release()
+    {
+        InstanceBuffer::forget(VAO);
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        if (boneVBO != 0)
+            glDeleteBuffers(1, &boneVBO);
+        VAO = VBO = EBO = boneVBO = 0;
+        materials.clear();
+        staging.clear();
+    }
+
+    // one texture setup and one multi draw per material
+    void Draw(Shader &shader, unsigned int lod = 0)
+    {
+        lod = std::min<unsigned int>(lod, MAX_MESH_LODS - 1);
+        glBindVertexArray(VAO);
+        if (boneVBO == 0)
+            Mesh::setUnskinnedAttributes();
+        for (Material &material : materials)
+        {
+            if (material.counts[lod].empty())
+                continue;
+            material.cache.get(shader, material.textures).bind(shader);
+            glMultiDrawElements(GL_TRIANGLES, &material.counts[lod][0], indexType, &material.offsets[lod][0],
+                                static_cast<GLsizei>(material.counts[lod].size()));
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // every instance of instances drawn with one call per draw range, there is no instanced multi draw in GL 3.3
+    void DrawInstanced(Shader &shader, const InstanceBuffer &instances, unsigned int lod = 0)
+    {
+        if (instances.count() == 0)
+            return;
+        lod = std::min<unsigned int>(lod, MAX_MESH_LODS - 1);
+        glBindVertexArray(VAO);
+        instances.attach(VAO);
+        if (boneVBO == 0)
+            Mesh::setUnskinnedAttributes();
+        for (Material &material : materials)
+        {
+            if (material.counts[lod].empty())
+                continue;
+            material.cache.get(shader, material.textures).bind(shader);
+            for (size_t i = 0; i < material.counts[lod].size(); i++)
+                glDrawElementsInstanced(GL_TRIANGLES, material.counts[lod][i], indexType, material.offsets[lod][i], instances.count());
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    // queues one multi draw per material
+    void Submit(RenderQueue &queue, Shader &shader, DrawPacket packet, unsigned int lod = 0)
+    {
+        lod = std::min<unsigned int>(lod, MAX_MESH_LODS - 1);
+        packet.shader = &shader;
+        packet.VAO = VAO;
+        packet.indexType = indexType;
+        for (Material &material : materials)
+        {
+            if (material.counts[lod].empty())
+                continue;
+            packet.material = &material.cache.get(shader, material.textures);
+            packet.counts = &material.counts[lod][0];
+            packet.offsets = &material.offsets[lod][0];
+            packet.drawCount = static_cast<GLsizei>(material.counts[lod].size());
+            queue.submit(packet);
+        }
+    }
+
+private:
+    struct StagedMesh
+    {
+        vector<Vertex> vertices;
+        vector<BoneVertex> boneData;
+        vector<vector<unsigned int>> levels;
+        unsigned int material;
+    };
+
+    vector<StagedMesh> staging;
+    unsigned int VBO = 0, EBO = 0, boneVBO = 0;
+
+    unsigned int findMaterial(const vector<Texture> &textures)
+    {
+        for (unsigned int m = 0; m < materials.size(); m++)
+        {
+            const vector<Texture> &other = materials[m].textures;
+            bool same = other.size() == textures.size();
+            for (size_t t = 0; same && t < textures.size(); t++)
+                same = other[t].id == textures[t].id && other[t].type == textures[t].type;
+            if (same)
+                return m;
+        }
+        materials.push_back(Material());
+        materials.back().textures = textures;
+        return static_cast<unsigned int>(materials.size() - 1);
+    }
+
+    // appends a range, or grows the previous one when they touch
+    static void addRange(Material &material, unsigned int lod, size_t byteOffset, size_t count, size_t indexSize)
+    {
+        if (count == 0)
+            return;
+        vector<GLsizei> &counts = material.counts[lod];
+        vector<const void*> &offsets = material.offsets[lod];
+        if (!counts.empty() && (size_t)offsets.back() + counts.back() * indexSize == byteOffset)
+        {
+            counts.back() += static_cast<GLsizei>(count);
+            return;
+        }
+        counts.push_back(static_cast<GLsizei>(count));
+        offsets.push_back((const void*)byteOffset);
+    }
+};
+#endif
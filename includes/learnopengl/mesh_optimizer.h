@@ -0,0 +1,298 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+// post-transform vertex cache statistics for an index buffer. Counts are kept raw so
+// the numbers of several meshes can be added together before taking the ratios.
+struct VertexCacheStats
+{
+    size_t triangles = 0;   // triangles in the index buffer
+    size_t vertices = 0;    // unique vertices referenced by the index buffer
+    size_t transformed = 0; // vertex shader invocations (cache misses)
+
+    // average cache miss ratio, 0.5 is the theoretical best and 3.0 the worst
+    float acmr() const
+    {
+        return triangles ? (float)transformed / (float)triangles : 0.0f;
+    }
+
+    // average transformed vertex ratio, 1.0 means every vertex is shaded exactly once
+    float atvr() const
+    {
+        return vertices ? (float)transformed / (float)vertices : 0.0f;
+    }
+
+    VertexCacheStats& operator+=(const VertexCacheStats& other)
+    {
+        triangles += other.triangles;
+        vertices += other.vertices;
+        transformed += other.transformed;
+        return *this;
+    }
+
+    // these ratios next to the ones of after, the same buffer once optimized
+    void print(std::ostream& out, const char* label, const VertexCacheStats& after) const
+    {
+        out << label << ": ACMR " << acmr() << " -> " << after.acmr() << ", ATVR " << atvr() << " -> " << after.atvr() << std::endl;
+    }
+};
+
+// Import-time index/vertex reordering. Everything works on plain arrays so it can be
+// run (and checked) without a GL context.
+namespace MeshOptimizer
+{
+    // size of the FIFO used to simulate the post-transform cache of the GPU
+    const unsigned int CACHE_SIZE = 16;
+
+    // simulates a FIFO post-transform cache and returns the resulting statistics
+    inline VertexCacheStats analyzeVertexCache(const vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = CACHE_SIZE)
+    {
+        VertexCacheStats stats;
+        stats.triangles = indices.size() / 3;
+
+        // timestamp based FIFO: a vertex is in the cache if it was inserted less than cacheSize insertions ago
+        vector<size_t> insertedAt(vertexCount, 0);
+        vector<bool> referenced(vertexCount, false);
+        size_t time = cacheSize + 1;
+        for (unsigned int index : indices)
+        {
+            if (!referenced[index])
+            {
+                referenced[index] = true;
+                stats.vertices++;
+            }
+            if (time - insertedAt[index] > cacheSize)
+            {
+                insertedAt[index] = time++;
+                stats.transformed++;
+            }
+        }
+        return stats;
+    }
+
+    // Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw").
+    // Fans triangles around the vertex that is most likely still in the cache. The triangle index at which each
+    // locality cluster starts (every time the algorithm has to jump to a dead end) is written into clusters.
+    inline vector<unsigned int> optimizeVertexCache(const vector<unsigned int>& indices, size_t vertexCount, vector<unsigned int>* clusters = nullptr, unsigned int cacheSize = CACHE_SIZE)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        vector<unsigned int> result;
+        result.reserve(triangleCount * 3);
+        if (clusters)
+            clusters->clear();
+        if (triangleCount == 0)
+            return result;
+
+        // vertex -> triangle adjacency stored as one flat array
+        vector<unsigned int> live(vertexCount, 0);
+        for (unsigned int index : indices)
+            live[index]++;
+        vector<unsigned int> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] = offsets[v] + live[v];
+        vector<unsigned int> adjacency(indices.size());
+        vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+
+        vector<size_t> cacheTime(vertexCount, 0);
+        vector<bool> emitted(triangleCount, false);
+        vector<unsigned int> deadEnd;
+        vector<unsigned int> candidates;
+        size_t time = cacheSize + 1;
+        size_t cursor = 0;
+
+        // pick the first vertex that is actually used
+        long fanning = -1;
+        while (cursor < vertexCount && fanning < 0)
+        {
+            if (live[cursor] > 0)
+                fanning = static_cast<long>(cursor);
+            cursor++;
+        }
+        bool newCluster = true;
+
+        while (fanning >= 0)
+        {
+            if (newCluster && clusters)
+                clusters->push_back(static_cast<unsigned int>(result.size() / 3));
+            newCluster = false;
+
+            // emit every remaining triangle around the fanning vertex
+            candidates.clear();
+            for (unsigned int a = offsets[fanning]; a < offsets[fanning + 1]; a++)
+            {
+                unsigned int triangle = adjacency[a];
+                if (emitted[triangle])
+                    continue;
+                emitted[triangle] = true;
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int v = indices[triangle * 3 + k];
+                    result.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    live[v]--;
+                    if (time - cacheTime[v] > cacheSize)
+                        cacheTime[v] = time++;
+                }
+            }
+
+            // next fanning vertex: the candidate that stays in the cache the longest while still having triangles left
+            long next = -1;
+            long bestPriority = -1;
+            for (unsigned int v : candidates)
+            {
+                if (live[v] == 0)
+                    continue;
+                long priority = 0;
+                if (time - cacheTime[v] + 2 * live[v] <= cacheSize)
+                    priority = static_cast<long>(time - cacheTime[v]);
+                if (priority > bestPriority)
+                {
+                    bestPriority = priority;
+                    next = v;
+                }
+            }
+
+            // nothing useful in the cache, fall back to the dead-end stack and finally to a linear scan
+            if (next < 0)
+            {
+                newCluster = true;
+                while (!deadEnd.empty() && next < 0)
+                {
+                    unsigned int v = deadEnd.back();
+                    deadEnd.pop_back();
+                    if (live[v] > 0)
+                        next = v;
+                }
+                while (cursor < vertexCount && next < 0)
+                {
+                    if (live[cursor] > 0)
+                        next = static_cast<long>(cursor);
+                    cursor++;
+                }
+            }
+            fanning = next;
+        }
+        return result;
+    }
+
+    // Sorts the clusters produced by optimizeVertexCache so that clusters facing away from the mesh
+    // centre (usually the outer shell) are drawn first and occlude the rest. Triangle order inside a
+    // cluster is untouched, so the cache efficiency only changes at cluster boundaries.
+    inline void optimizeOverdraw(vector<unsigned int>& indices, const vector<Vertex>& vertices, const vector<unsigned int>& clusters)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (clusters.size() < 2)
+            return;
+
+        // area weighted centroid of the whole mesh
+        glm::vec3 meshCentroid(0.0f);
+        float meshArea = 0.0f;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const glm::vec3& p0 = vertices[indices[t * 3 + 0]].Position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+            float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+            meshCentroid += (p0 + p1 + p2) * (area / 3.0f);
+            meshArea += area;
+        }
+        if (meshArea > 0.0f)
+            meshCentroid /= meshArea;
+
+        struct ClusterSort
+        {
+            unsigned int begin, end;
+            float key;
+        };
+        vector<ClusterSort> sorted;
+        sorted.reserve(clusters.size());
+        for (size_t c = 0; c < clusters.size(); c++)
+        {
+            ClusterSort cluster;
+            cluster.begin = clusters[c];
+            cluster.end = c + 1 < clusters.size() ? clusters[c + 1] : static_cast<unsigned int>(triangleCount);
+
+            glm::vec3 centroid(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+            for (unsigned int t = cluster.begin; t < cluster.end; t++)
+            {
+                const glm::vec3& p0 = vertices[indices[t * 3 + 0]].Position;
+                const glm::vec3& p1 = vertices[indices[t * 3 + 1]].Position;
+                const glm::vec3& p2 = vertices[indices[t * 3 + 2]].Position;
+                glm::vec3 n = glm::cross(p1 - p0, p2 - p0); // length is twice the triangle area
+                float a = glm::length(n);
+                centroid += (p0 + p1 + p2) * (a / 3.0f);
+                normal += n;
+                area += a;
+            }
+            if (area > 0.0f)
+                centroid /= area;
+            float length = glm::length(normal);
+            if (length > 0.0f)
+                normal /= length;
+
+            cluster.key = glm::dot(centroid - meshCentroid, normal);
+            sorted.push_back(cluster);
+        }
+        std::stable_sort(sorted.begin(), sorted.end(), [](const ClusterSort& a, const ClusterSort& b) { return a.key > b.key; });
+
+        vector<unsigned int> result;
+        result.reserve(indices.size());
+        for (const ClusterSort& cluster : sorted)
+            result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+        indices.swap(result);
+    }
+
+    // Reorders the vertex arrays in the order the index buffer first touches them, so vertex fetch walks
+    // memory mostly sequentially. Vertices that no triangle references are dropped.
+    inline void optimizeVertexFetch(vector<Vertex>& vertices, vector<unsigned int>& indices, vector<BoneVertex>& boneData)
+    {
+        const unsigned int unused = ~0u;
+        vector<unsigned int> remap(vertices.size(), unused);
+        vector<Vertex> newVertices;
+        vector<BoneVertex> newBoneData;
+        newVertices.reserve(vertices.size());
+        newBoneData.reserve(boneData.size());
+        for (unsigned int& index : indices)
+        {
+            if (remap[index] == unused)
+            {
+                remap[index] = static_cast<unsigned int>(newVertices.size());
+                newVertices.push_back(vertices[index]);
+                if (!boneData.empty())
+                    newBoneData.push_back(boneData[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(newVertices);
+        boneData.swap(newBoneData);
+    }
+
+    // runs the full pipeline (cache, overdraw, fetch) and accumulates before/after statistics
+    inline void optimizeMesh(vector<Vertex>& vertices, vector<unsigned int>& indices, vector<BoneVertex>& boneData,
+                             VertexCacheStats* before = nullptr, VertexCacheStats* after = nullptr)
+    {
+        if (before)
+            *before += analyzeVertexCache(indices, vertices.size());
+
+        vector<unsigned int> clusters;
+        indices = optimizeVertexCache(indices, vertices.size(), &clusters);
+        optimizeOverdraw(indices, vertices, clusters);
+        optimizeVertexFetch(vertices, indices, boneData);
+
+        if (after)
+            *after += analyzeVertexCache(indices, vertices.size());
+    }
+}
+#endif
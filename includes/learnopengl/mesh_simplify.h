@@ -0,0 +1,301 @@
+#ifndef MESH_SIMPLIFY_H
+#define MESH_SIMPLIFY_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+// Quadric error metric simplification (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics").
+// The simplifier only rewrites the index buffer: every collapse moves a vertex onto one of its neighbours, so all
+// LOD levels of a mesh can share the original vertex buffer. Like the optimizer it only needs plain arrays and can
+// be run without a GL context.
+namespace MeshSimplifier
+{
+    // symmetric 4x4 matrix stored as its upper triangle
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+
+        // quadric of the plane n.p + d = 0, scaled by weight
+        static Quadric fromPlane(const glm::dvec3& n, double d, double weight)
+        {
+            Quadric q;
+            q.a2 = n.x * n.x * weight; q.ab = n.x * n.y * weight; q.ac = n.x * n.z * weight; q.ad = n.x * d * weight;
+            q.b2 = n.y * n.y * weight; q.bc = n.y * n.z * weight; q.bd = n.y * d * weight;
+            q.c2 = n.z * n.z * weight; q.cd = n.z * d * weight;
+            q.d2 = d * d * weight;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& o)
+        {
+            a2 += o.a2; ab += o.ab; ac += o.ac; ad += o.ad;
+            b2 += o.b2; bc += o.bc; bd += o.bd;
+            c2 += o.c2; cd += o.cd;
+            d2 += o.d2;
+            return *this;
+        }
+
+        // squared distance sum of p to all accumulated planes
+        double error(const glm::vec3& p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            double e = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                     + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                     + c2 * z * z + 2 * cd * z
+                     + d2;
+            return e > 0 ? e : 0;
+        }
+    };
+
+    // vertices sharing a position but not the other attributes (uv seams, hard normals) and open borders are locked,
+    // collapsing them would tear the surface or smear the attributes
+    inline vector<bool> findLockedVertices(const vector<Vertex>& vertices, const vector<unsigned int>& indices)
+    {
+        vector<bool> locked(vertices.size(), false);
+
+        struct PositionHash
+        {
+            size_t operator()(const glm::vec3& p) const
+            {
+                const unsigned int* bits = reinterpret_cast<const unsigned int*>(&p);
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            }
+        };
+        unordered_map<glm::vec3, unsigned int, PositionHash> firstAtPosition;
+        firstAtPosition.reserve(vertices.size());
+        vector<bool> referenced(vertices.size(), false);
+        for (unsigned int index : indices)
+            referenced[index] = true;
+        for (unsigned int v = 0; v < vertices.size(); v++)
+        {
+            if (!referenced[v])
+                continue;
+            auto it = firstAtPosition.find(vertices[v].Position);
+            if (it == firstAtPosition.end())
+                firstAtPosition.emplace(vertices[v].Position, v);
+            else
+                locked[v] = locked[it->second] = true;
+        }
+
+        // an edge used by exactly one triangle lies on a border
+        unordered_map<unsigned long long, unsigned int> edgeUse;
+        edgeUse.reserve(indices.size());
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned long long a = indices[i + k], b = indices[i + (k + 1) % 3];
+                edgeUse[a < b ? (a << 32) | b : (b << 32) | a]++;
+            }
+        }
+        for (const auto& edge : edgeUse)
+        {
+            if (edge.second == 1)
+                locked[edge.first >> 32] = locked[edge.first & 0xFFFFFFFFull] = true;
+        }
+        return locked;
+    }
+
+    // Simplifies the triangle list until it holds at most targetIndexCount indices or the next collapse would move the
+    // surface further than targetError (in model units). The error reached is written to resultError.
+    inline vector<unsigned int> simplify(const vector<Vertex>& vertices, const vector<unsigned int>& indices,
+                                         size_t targetIndexCount, float targetError, float* resultError = nullptr)
+    {
+        vector<unsigned int> result(indices);
+        const size_t vertexCount = vertices.size();
+        if (resultError)
+            *resultError = 0.0f;
+        if (result.size() <= targetIndexCount)
+            return result;
+
+        // plane quadrics weighted by triangle area
+        vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            const glm::dvec3 p0(vertices[result[i + 0]].Position);
+            const glm::dvec3 p1(vertices[result[i + 1]].Position);
+            const glm::dvec3 p2(vertices[result[i + 2]].Position);
+            glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+            double area = glm::length(n);
+            if (area <= 0.0)
+                continue;
+            n /= area;
+            Quadric q = Quadric::fromPlane(n, -glm::dot(n, p0), area * 0.5);
+            for (int k = 0; k < 3; k++)
+                quadrics[result[i + k]] += q;
+        }
+
+        const vector<bool> locked = findLockedVertices(vertices, indices);
+        const double maxError = (double)targetError * (double)targetError;
+        double reachedError = 0.0;
+
+        struct Collapse
+        {
+            unsigned int from, to;
+            double error;
+        };
+        vector<Collapse> collapses;
+        vector<unsigned int> remap(vertexCount);
+        vector<bool> touched(vertexCount);
+        vector<unsigned int> adjacencyOffsets(vertexCount + 1);
+        vector<unsigned int> adjacency;
+
+        // every pass collapses an independent set of edges, then rebuilds the index buffer
+        while (result.size() > targetIndexCount)
+        {
+            // vertex -> triangle adjacency for the current index buffer
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (unsigned int index : result)
+                adjacencyOffsets[index + 1]++;
+            for (size_t v = 0; v < vertexCount; v++)
+                adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+            adjacency.resize(result.size());
+            vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++)
+                adjacency[fill[result[i]]++] = static_cast<unsigned int>(i / 3);
+
+            // cost of moving each unlocked endpoint onto the other one
+            collapses.clear();
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    unsigned int a = result[i + k], b = result[i + (k + 1) % 3];
+                    if (!locked[a])
+                    {
+                        Quadric q = quadrics[a];
+                        q += quadrics[b];
+                        collapses.push_back({ a, b, q.error(vertices[b].Position) });
+                    }
+                    if (!locked[b])
+                    {
+                        Quadric q = quadrics[b];
+                        q += quadrics[a];
+                        collapses.push_back({ b, a, q.error(vertices[a].Position) });
+                    }
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+            for (size_t v = 0; v < vertexCount; v++)
+                remap[v] = static_cast<unsigned int>(v);
+            std::fill(touched.begin(), touched.end(), false);
+
+            size_t remainingTriangles = result.size() / 3;
+            const size_t targetTriangles = targetIndexCount / 3;
+            size_t collapsed = 0;
+            for (const Collapse& c : collapses)
+            {
+                if (remainingTriangles <= targetTriangles || c.error > maxError)
+                    break;
+                if (touched[c.from] || touched[c.to])
+                    continue;
+
+                // reject collapses that would flip or degenerate a triangle that survives
+                bool valid = true;
+                size_t removed = 0;
+                for (unsigned int a = adjacencyOffsets[c.from]; a < adjacencyOffsets[c.from + 1] && valid; a++)
+                {
+                    const unsigned int* tri = &result[adjacency[a] * 3];
+                    if (tri[0] == c.to || tri[1] == c.to || tri[2] == c.to)
+                    {
+                        removed++;
+                        continue;
+                    }
+                    glm::vec3 p[3], q[3];
+                    for (int k = 0; k < 3; k++)
+                    {
+                        p[k] = vertices[tri[k]].Position;
+                        q[k] = tri[k] == c.from ? vertices[c.to].Position : p[k];
+                    }
+                    glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                    // a triangle squeezed onto a line turns edge-on, at the border it becomes a fin standing on
+                    // three locked vertices, whatever the angle test makes of its tiny normal
+                    const float beforeLength = glm::length(before), afterLength = glm::length(after);
+                    if (glm::dot(before, after) <= 0.25f * beforeLength * afterLength || afterLength < 0.01f * beforeLength)
+                        valid = false;
+                }
+                if (!valid)
+                    continue;
+
+                remap[c.from] = c.to;
+                quadrics[c.to] += quadrics[c.from];
+                reachedError = std::max(reachedError, c.error);
+                remainingTriangles -= std::min(removed, remainingTriangles);
+                collapsed++;
+
+                // the neighbourhood of both endpoints changed, leave it alone for the rest of this pass
+                for (unsigned int a = adjacencyOffsets[c.from]; a < adjacencyOffsets[c.from + 1]; a++)
+                {
+                    const unsigned int* tri = &result[adjacency[a] * 3];
+                    touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = true;
+                }
+                touched[c.to] = true;
+            }
+            if (collapsed == 0)
+                break;
+
+            // apply the collapses and drop the triangles that became degenerate
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                unsigned int a = remap[result[i + 0]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+                if (a == b || b == c || a == c)
+                    continue;
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        if (resultError)
+            *resultError = static_cast<float>(std::sqrt(reachedError));
+        return result;
+    }
+
+    // Builds up to levels simplified index buffers, level i keeping roughly 1 / 2^(i+1) of the triangles.
+    // The chain stops early once a level can't drop at least 10% more triangles within its error budget.
+    inline vector<vector<unsigned int>> generateLodChain(const vector<Vertex>& vertices, const vector<unsigned int>& indices,
+                                                         unsigned int levels = MAX_MESH_LODS - 1)
+    {
+        // error budget of each level as a fraction of the mesh diagonal
+        static const float errorScale[MAX_MESH_LODS - 1] = { 0.005f, 0.02f, 0.05f };
+
+        vector<vector<unsigned int>> chain;
+        if (indices.empty())
+            return chain;
+
+        glm::vec3 minPos(vertices[indices[0]].Position), maxPos(minPos);
+        for (unsigned int index : indices)
+        {
+            minPos = glm::min(minPos, vertices[index].Position);
+            maxPos = glm::max(maxPos, vertices[index].Position);
+        }
+        const float diagonal = glm::length(maxPos - minPos);
+
+        size_t previousSize = indices.size();
+        levels = std::min<unsigned int>(levels, MAX_MESH_LODS - 1);
+        for (unsigned int level = 0; level < levels; level++)
+        {
+            size_t target = (indices.size() >> (level + 1)) / 3 * 3;
+            vector<unsigned int> lod = simplify(vertices, indices, target, errorScale[level] * diagonal);
+            if (lod.empty() || lod.size() > previousSize * 9 / 10)
+                break;
+            previousSize = lod.size();
+            chain.push_back(std::move(lod));
+        }
+        return chain;
+    }
+}
+#endif
@@ -10,7 +10,13 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/instance_buffer.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_batch.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplify.h>
+#include <learnopengl/model_bounds.h>
+#include <learnopengl/render_queue.h>
 #include <learnopengl/shader.h>
 
 #include <string>
@@ -22,49 +28,104 @@
 using namespace std;
 
 inline unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+inline unsigned int TextureFromPixels(const unsigned char *pixels, int width, int height, int components);
 
-class Model 
+// a texture a model's materials use, with its pixels when they were decoded before the upload
+struct ModelTextureData
 {
-public:
-    // model data 
-    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
-    vector<Mesh>    meshes;
-    string directory;
-    bool gammaCorrection;
+    string path;                    // as the material names it, relative to the model's directory
+    TextureType type;
+    bool decoded = false;           // false: the file is read when the texture is uploaded
+    int width = 0, height = 0, components = 0;
+    vector<unsigned char> pixels;   // empty if decoding failed
 
-    // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    // reads the file with stb_image, path is relative to directory
+    void decode(const string &directory)
     {
-        loadModel(path);
+        const string filename = directory + '/' + path;
+        decoded = true;
+        unsigned char *data = stbi_load(filename.c_str(), &width, &height, &components, 0);
+        if (data)
+            pixels.assign(data, data + static_cast<size_t>(width) * height * components);
+        stbi_image_free(data);
     }
+};
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader &shader)
-    {
-        for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
-    }
-    
-private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const &path)
+// one mesh as it will be uploaded, processed as the flags asked
+struct ModelMeshData
+{
+    vector<Vertex> vertices;
+    vector<unsigned int> indices;
+    vector<BoneVertex> boneData;
+    vector<vector<unsigned int>> lodIndices;
+    vector<unsigned int> textures;  // into ModelData::textures, in the order the mesh binds them
+};
+
+// What reading a model file gives before any GL object exists: the meshes after optimization and lod generation,
+// and the textures they use. read makes no GL calls, so it can run on a loading thread while a Model built from
+// the data later uploads it on the GL thread.
+struct ModelData
+{
+    string directory;
+    unsigned int flags = 0;
+    vector<ModelMeshData> meshes;
+    vector<ModelTextureData> textures;
+    VertexCacheStats cacheStatsBefore;
+    VertexCacheStats cacheStatsAfter;
+
+    // imports path with ASSIMP, decodePixels decodes the textures with stb_image as well. Returns false, with the
+    // error printed, if the file couldn't be imported.
+    bool read(string const &path, unsigned int flags, bool decodePixels)
     {
+        this->flags = flags;
+        meshes.clear();
+        textures.clear();
+
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        unsigned int importFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+        // reordering and simplification only pay off once identical vertices are shared between triangles
+        if (flags & (MODEL_OPTIMIZE_INDICES | MODEL_GENERATE_LODS))
+            importFlags |= aiProcess_JoinIdenticalVertices;
+        const aiScene* scene = importer.ReadFile(path, importFlags);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            return false;
         }
         // retrieve the directory path of the filepath
         directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
+        meshes.reserve(scene->mNumMeshes);
         processNode(scene->mRootNode, scene);
+
+        if (decodePixels)
+        {
+            for (ModelTextureData &texture : textures)
+                texture.decode(directory);
+        }
+        return true;
+    }
+
+    // bytes of geometry and pixels held
+    size_t bytes() const
+    {
+        size_t total = 0;
+        for (const ModelMeshData &mesh : meshes)
+        {
+            total += mesh.vertices.capacity() * sizeof(Vertex) + mesh.indices.capacity() * sizeof(unsigned int)
+                   + mesh.boneData.capacity() * sizeof(BoneVertex);
+            for (const auto &level : mesh.lodIndices)
+                total += level.capacity() * sizeof(unsigned int);
+        }
+        for (const ModelTextureData &texture : textures)
+            total += texture.pixels.capacity();
+        return total;
     }
 
+private:
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
     void processNode(aiNode *node, const aiScene *scene)
     {
@@ -84,12 +145,14 @@ private:
 
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    ModelMeshData processMesh(aiMesh *mesh, const aiScene *scene)
     {
         // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
+        ModelMeshData data;
+        vector<Vertex> &vertices = data.vertices;
+        vector<unsigned int> &indices = data.indices;
+        vertices.reserve(mesh->mNumVertices);
+        indices.reserve(mesh->mNumFaces * 3);
 
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
@@ -152,53 +215,223 @@ private:
         // normal: texture_normalN
 
         // 1. diffuse maps
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        addMaterialTextures(material, aiTextureType_DIFFUSE, TEXTURE_DIFFUSE, data.textures);
         // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        addMaterialTextures(material, aiTextureType_SPECULAR, TEXTURE_SPECULAR, data.textures);
         // 3. normal maps
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+        addMaterialTextures(material, aiTextureType_HEIGHT, TEXTURE_NORMAL, data.textures);
         // 4. height maps
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-        
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        addMaterialTextures(material, aiTextureType_AMBIENT, TEXTURE_HEIGHT, data.textures);
+
+        // reorder triangles and vertices for the post-transform cache, overdraw and vertex fetch
+        if (flags & MODEL_OPTIMIZE_INDICES)
+            MeshOptimizer::optimizeMesh(vertices, indices, data.boneData, &cacheStatsBefore, &cacheStatsAfter);
+
+        // simplified index buffers sharing the vertices above
+        if (flags & MODEL_GENERATE_LODS)
+            data.lodIndices = generateLods(vertices, indices);
+        return data;
+    }
+
+    // builds the level of detail chain of one mesh, cache optimized as well when that was requested
+    vector<vector<unsigned int>> generateLods(const vector<Vertex> &vertices, const vector<unsigned int> &indices)
+    {
+        vector<vector<unsigned int>> lodIndices = MeshSimplifier::generateLodChain(vertices, indices);
+        if (flags & MODEL_OPTIMIZE_INDICES)
+        {
+            for (auto &level : lodIndices)
+                level = MeshOptimizer::optimizeVertexCache(level, vertices.size());
+        }
+        return lodIndices;
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
+    // adds the material textures of a given type to meshTextures, a file used by an earlier mesh is only listed once
+    void addMaterialTextures(aiMaterial *mat, aiTextureType type, TextureType textureType, vector<unsigned int> &meshTextures)
     {
-        vector<Texture> textures;
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
+            // check if texture was listed before and if so, point at that one instead of loading it twice
+            unsigned int index = 0;
+            while (index < textures.size() && std::strcmp(textures[index].path.data(), str.C_Str()) != 0)
+                index++;
+            if (index == textures.size())
             {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
+                ModelTextureData texture;
+                texture.type = textureType;
                 texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
+                textures.push_back(std::move(texture));
             }
+            meshTextures.push_back(index);
+        }
+    }
+};
+
+class Model 
+{
+public:
+    // model data 
+    vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    vector<Mesh>    meshes;
+    string directory;
+    bool gammaCorrection;
+    unsigned int flags;                 // ModelFlags applied while loading
+    VertexCacheStats cacheStatsBefore;  // post-transform cache statistics of the imported index order
+    VertexCacheStats cacheStatsAfter;   // and after MODEL_OPTIMIZE_INDICES
+    MeshBatch batch;                    // merged geometry drawn instead of the meshes with MODEL_MERGE_MESHES
+    ModelBounds bounds;                 // box, sphere and principal axis of all the meshes, measured at load
+
+    // constructor, expects a filepath to a 3D model. flags is a combination of ModelFlags.
+    Model(string const &path, bool gamma = false, unsigned int flags = 0) : gammaCorrection(gamma), flags(flags)
+    {
+        // the textures are read from their files as they are uploaded, one decoded image at a time
+        ModelData data;
+        if (data.read(path, flags, false))
+            upload(data);
+    }
+
+    // uploads a model read earlier, possibly on another thread, with the flags it was read with.
+    // The geometry and pixels are moved out of data.
+    explicit Model(ModelData &&data, bool gamma = false) : gammaCorrection(gamma), flags(data.flags)
+    {
+        upload(data);
+    }
+
+    // draws the model, and thus all its meshes, at the given level of detail
+    void Draw(Shader &shader, unsigned int lod = 0)
+    {
+        if (batch.isUploaded())
+        {
+            batch.Draw(shader, lod);
+            return;
+        }
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader, lod);
+    }
+
+    // draws the model once for every instance in instances with one instanced call per mesh (or draw range when merged)
+    void DrawInstanced(Shader &shader, const InstanceBuffer &instances, unsigned int lod = 0)
+    {
+        if (batch.isUploaded())
+        {
+            batch.DrawInstanced(shader, instances, lod);
+            return;
+        }
+        for (Mesh &mesh : meshes)
+            mesh.DrawInstanced(shader, instances, lod);
+    }
+
+    // queues the model instead of drawing it, packet holds the pass, model matrix and colour of this instance
+    void Submit(RenderQueue &queue, Shader &shader, const DrawPacket &packet, unsigned int lod = 0)
+    {
+        if (batch.isUploaded())
+        {
+            batch.Submit(queue, shader, packet, lod);
+            return;
+        }
+        for (Mesh &mesh : meshes)
+            mesh.Submit(queue, shader, packet, lod);
+    }
+
+    // bytes of mesh geometry still held on the CPU, zero with MODEL_RELEASE_CPU_GEOMETRY
+    size_t cpuGeometryBytes() const
+    {
+        size_t bytes = 0;
+        for (const Mesh& mesh : meshes)
+            bytes += mesh.cpuGeometryBytes();
+        return bytes;
+    }
+
+    // number of levels of detail, meshes with fewer levels keep drawing their coarsest one
+    unsigned int lodCount() const
+    {
+        size_t count = 1;
+        for (const Mesh& mesh : meshes)
+            count = std::max(count, mesh.lods.size());
+        return static_cast<unsigned int>(count);
+    }
+
+    // triangles drawn by Draw at the given level of detail
+    size_t triangleCount(unsigned int lod = 0) const
+    {
+        size_t triangles = 0;
+        for (const Mesh& mesh : meshes)
+            triangles += mesh.lods[std::min<size_t>(lod, mesh.lods.size() - 1)].indexCount / 3;
+        return triangles;
+    }
+
+    // deletes the buffers and textures of the model, for models that go away before the program ends. The model
+    // can't be drawn afterwards.
+    void releaseGpuResources()
+    {
+        batch.release();
+        for (Mesh &mesh : meshes)
+            mesh.releaseGpuBuffers();
+        for (const Texture &texture : textures_loaded)
+            glDeleteTextures(1, &texture.id);
+        textures_loaded.clear();
+    }
+    
+private:
+    // creates the textures and meshes of data, leaving its geometry and pixels moved out
+    void upload(ModelData &data)
+    {
+        directory = data.directory;
+        cacheStatsBefore = data.cacheStatsBefore;
+        cacheStatsAfter = data.cacheStatsAfter;
+
+        // every texture is uploaded once, however many meshes use it
+        textures_loaded.reserve(data.textures.size());
+        for (ModelTextureData &texture : data.textures)
+        {
+            Texture loaded;
+            if (!texture.decoded)
+                loaded.id = TextureFromFile(texture.path.c_str(), this->directory);
+            else if (!texture.pixels.empty())
+                loaded.id = TextureFromPixels(&texture.pixels[0], texture.width, texture.height, texture.components);
+            else
+            {
+                std::cout << "Texture failed to load at path: " << texture.path << std::endl;
+                glGenTextures(1, &loaded.id);
+            }
+            loaded.type = texture.type;
+            loaded.path = texture.path;
+            textures_loaded.push_back(loaded);
+            vector<unsigned char>().swap(texture.pixels);
+        }
+
+        meshes.reserve(data.meshes.size());
+        for (ModelMeshData &mesh : data.meshes)
+        {
+            vector<Texture> textures;
+            textures.reserve(mesh.textures.size());
+            for (unsigned int index : mesh.textures)
+                textures.push_back(textures_loaded[index]);
+
+            // keep a copy for the merged buffers, the mesh itself takes ownership below
+            if (flags & MODEL_MERGE_MESHES)
+                batch.add(mesh.vertices, mesh.indices, mesh.lodIndices, mesh.boneData, textures);
+            meshes.emplace_back(std::move(mesh.vertices), std::move(mesh.indices), std::move(textures), std::move(mesh.boneData),
+                                std::move(mesh.lodIndices));
+        }
+        data.meshes.clear();
+        bounds = ModelBounds::compute(meshes, &JobSystem::shared());
+
+        // the merged copy replaces the per mesh buffers, the meshes stay around for their bounds and lods
+        if (flags & MODEL_MERGE_MESHES)
+        {
+            batch.upload();
+            for (Mesh& mesh : meshes)
+                mesh.releaseGpuBuffers();
+        }
+
+        // everything is on the GPU now, keep only the derived data (bounds, lods) if asked to
+        if (flags & MODEL_RELEASE_CPU_GEOMETRY)
+        {
+            for (Mesh& mesh : meshes)
+                mesh.releaseCpuGeometry();
         }
-        return textures;
     }
 };
 
@@ -208,37 +441,44 @@ inline unsigned int TextureFromFile(const char *path, const string &directory, b
     string filename = string(path);
     filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
     int width, height, nrComponents;
     unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
     if (data)
     {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
+        unsigned int textureID = TextureFromPixels(data, width, height, nrComponents);
+        stbi_image_free(data);
+        return textureID;
+    }
 
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+    std::cout << "Texture failed to load at path: " << path << std::endl;
+    stbi_image_free(data);
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
+    return textureID;
+}
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+// uploads decoded 8-bit pixels of 1, 3 or 4 components into a new mipmapped texture
+inline unsigned int TextureFromPixels(const unsigned char *pixels, int width, int height, int components)
+{
+    unsigned int textureID;
+    glGenTextures(1, &textureID);
 
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
+    GLenum format = GL_RGBA;
+    if (components == 1)
+        format = GL_RED;
+    else if (components == 2)
+        format = GL_RG;
+    else if (components == 3)
+        format = GL_RGB;
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     return textureID;
 }
@@ -10,7 +10,13 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/instance_buffer.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_batch.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplify.h>
+#include <learnopengl/model_bounds.h>
+#include <learnopengl/render_queue.h>
 #include <learnopengl/shader.h>
 
 #include <string>
@@ -32,20 +38,81 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    unsigned int flags;                 // ModelFlags applied while loading
+    VertexCacheStats cacheStatsBefore;  // post-transform cache statistics of the imported index order
+    VertexCacheStats cacheStatsAfter;   // and after MODEL_OPTIMIZE_INDICES
+    MeshBatch batch;                    // merged geometry drawn instead of the meshes with MODEL_MERGE_MESHES
+    ModelBounds bounds;                 // box, sphere and principal axis of all the meshes, measured at load
 	
 	
 
-    // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    // constructor, expects a filepath to a 3D model. flags is a combination of ModelFlags.
+    Model(string const &path, bool gamma = false, unsigned int flags = 0) : gammaCorrection(gamma), flags(flags)
     {
         loadModel(path);
     }
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader &shader)
+    // draws the model, and thus all its meshes, at the given level of detail
+    void Draw(Shader &shader, unsigned int lod = 0)
     {
+        if (batch.isUploaded())
+        {
+            batch.Draw(shader, lod);
+            return;
+        }
         for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+            meshes[i].Draw(shader, lod);
+    }
+
+    // draws the model once for every instance in instances with one instanced call per mesh (or draw range when merged)
+    void DrawInstanced(Shader &shader, const InstanceBuffer &instances, unsigned int lod = 0)
+    {
+        if (batch.isUploaded())
+        {
+            batch.DrawInstanced(shader, instances, lod);
+            return;
+        }
+        for (Mesh &mesh : meshes)
+            mesh.DrawInstanced(shader, instances, lod);
+    }
+
+    // queues the model instead of drawing it, packet holds the pass, model matrix and colour of this instance
+    void Submit(RenderQueue &queue, Shader &shader, const DrawPacket &packet, unsigned int lod = 0)
+    {
+        if (batch.isUploaded())
+        {
+            batch.Submit(queue, shader, packet, lod);
+            return;
+        }
+        for (Mesh &mesh : meshes)
+            mesh.Submit(queue, shader, packet, lod);
+    }
+
+    // bytes of mesh geometry still held on the CPU, zero with MODEL_RELEASE_CPU_GEOMETRY
+    size_t cpuGeometryBytes() const
+    {
+        size_t bytes = 0;
+        for (const Mesh& mesh : meshes)
+            bytes += mesh.cpuGeometryBytes();
+        return bytes;
+    }
+
+    // number of levels of detail, meshes with fewer levels keep drawing their coarsest one
+    unsigned int lodCount() const
+    {
+        size_t count = 1;
+        for (const Mesh& mesh : meshes)
+            count = std::max(count, mesh.lods.size());
+        return static_cast<unsigned int>(count);
+    }
+
+    // triangles drawn by Draw at the given level of detail
+    size_t triangleCount(unsigned int lod = 0) const
+    {
+        size_t triangles = 0;
+        for (const Mesh& mesh : meshes)
+            triangles += mesh.lods[std::min<size_t>(lod, mesh.lods.size() - 1)].indexCount / 3;
+        return triangles;
     }
     
 	auto& GetBoneInfoMap() { return m_BoneInfoMap; }
@@ -62,7 +129,11 @@ private:
     {
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace);
+        unsigned int importFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace;
+        // reordering and simplification only pay off once identical vertices are shared between triangles
+        if (flags & (MODEL_OPTIMIZE_INDICES | MODEL_GENERATE_LODS))
+            importFlags |= aiProcess_JoinIdenticalVertices;
+        const aiScene* scene = importer.ReadFile(path, importFlags);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
@@ -73,7 +144,24 @@ private:
         directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
+        meshes.reserve(scene->mNumMeshes);
         processNode(scene->mRootNode, scene);
+        bounds = ModelBounds::compute(meshes, &JobSystem::shared());
+
+        // the merged copy replaces the per mesh buffers, the meshes stay around for their bounds and lods
+        if (flags & MODEL_MERGE_MESHES)
+        {
+            batch.upload();
+            for (Mesh& mesh : meshes)
+                mesh.releaseGpuBuffers();
+        }
+
+        // everything is on the GPU now, keep only the derived data (bounds, lods) if asked to
+        if (flags & MODEL_RELEASE_CPU_GEOMETRY)
+        {
+            for (Mesh& mesh : meshes)
+                mesh.releaseCpuGeometry();
+        }
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -95,7 +183,7 @@ private:
 
     }
 
-	void SetVertexBoneDataToDefault(Vertex& vertex)
+	void SetVertexBoneDataToDefault(BoneVertex& vertex)
 	{
 		for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
 		{
@@ -110,11 +198,12 @@ private:
 		vector<Vertex> vertices;
 		vector<unsigned int> indices;
 		vector<Texture> textures;
+		vertices.reserve(mesh->mNumVertices);
+		indices.reserve(mesh->mNumFaces * 3);
 
 		for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 		{
 			Vertex vertex;
-			SetVertexBoneDataToDefault(vertex);
 			vertex.Position = AssimpGLMHelpers::GetGLMVec(mesh->mVertices[i]);
 			vertex.Normal = AssimpGLMHelpers::GetGLMVec(mesh->mNormals[i]);
 			
@@ -138,21 +227,51 @@ private:
 		}
 		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
 
-		vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+		vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, TEXTURE_DIFFUSE);
 		textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-		vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+		vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, TEXTURE_SPECULAR);
 		textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-		std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
+		std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, TEXTURE_NORMAL);
 		textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-		std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
+		std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, TEXTURE_HEIGHT);
 		textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-		ExtractBoneWeightForVertices(vertices,mesh,scene);
+		// only meshes with bones get the skinned vertex stream, everything else stays static
+		vector<BoneVertex> boneData;
+		if (mesh->mNumBones > 0)
+		{
+			boneData.resize(vertices.size());
+			for (auto& bone : boneData)
+				SetVertexBoneDataToDefault(bone);
+			ExtractBoneWeightForVertices(boneData, mesh, scene);
+		}
+
+		if (flags & MODEL_OPTIMIZE_INDICES)
+			MeshOptimizer::optimizeMesh(vertices, indices, boneData, &cacheStatsBefore, &cacheStatsAfter);
+
+		vector<vector<unsigned int>> lodIndices;
+		if (flags & MODEL_GENERATE_LODS)
+			lodIndices = generateLods(vertices, indices);
+
+		if (flags & MODEL_MERGE_MESHES)
+			batch.add(vertices, indices, lodIndices, boneData, textures);
 
-		return Mesh(vertices, indices, textures);
+		return Mesh(std::move(vertices), std::move(indices), std::move(textures), std::move(boneData), std::move(lodIndices));
+	}
+
+	// builds the level of detail chain of one mesh, cache optimized as well when that was requested
+	vector<vector<unsigned int>> generateLods(const vector<Vertex>& vertices, const vector<unsigned int>& indices)
+	{
+		vector<vector<unsigned int>> lodIndices = MeshSimplifier::generateLodChain(vertices, indices);
+		if (flags & MODEL_OPTIMIZE_INDICES)
+		{
+			for (auto& level : lodIndices)
+				level = MeshOptimizer::optimizeVertexCache(level, vertices.size());
+		}
+		return lodIndices;
 	}
 
-	void SetVertexBoneData(Vertex& vertex, int boneID, float weight)
+	void SetVertexBoneData(BoneVertex& vertex, int boneID, float weight)
 	{
 		for (int i = 0; i < MAX_BONE_INFLUENCE; ++i)
 		{
@@ -166,7 +285,7 @@ private:
 	}
 
 
-	void ExtractBoneWeightForVertices(std::vector<Vertex>& vertices, aiMesh* mesh, const aiScene* scene)
+	void ExtractBoneWeightForVertices(std::vector<BoneVertex>& vertices, aiMesh* mesh, const aiScene* scene)
 	{
 		auto& boneInfoMap = m_BoneInfoMap;
 		int& boneCount = m_BoneCounter;
@@ -245,7 +364,7 @@ private:
     
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
     // the required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
+    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, TextureType textureType)
     {
         vector<Texture> textures;
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
@@ -267,7 +386,7 @@ private:
             {   // if texture hasn't been loaded already, load it
                 Texture texture;
                 texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
+                texture.type = textureType;
                 texture.path = str.C_Str();
                 textures.push_back(texture);
                 textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
@@ -0,0 +1,275 @@
+#ifndef MODEL_BOUNDS_H
+#define MODEL_BOUNDS_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/job_system.h>
+#include <learnopengl/simd.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+// vertices reduced by one job, fixed so the result doesn't depend on the thread count
+#define MODEL_BOUNDS_CHUNK_SIZE 16384
+
+// Shape of a whole model, measured once from the vertices of all its meshes when it's loaded, so entities,
+// culling and gameplay code share it instead of scanning the vertices again, and it stays valid once they
+// are released with MODEL_RELEASE_CPU_GEOMETRY. The passes are SIMD reductions over fixed chunks of vertices
+// spread over a JobSystem, merged in chunk order.
+struct ModelBounds
+{
+    glm::vec3 min{ 0.0f };                  // box around every vertex
+    glm::vec3 max{ 0.0f };
+    glm::vec3 sphereCenter{ 0.0f };         // sphere around every vertex, tighter than the one around the box
+    float sphereRadius = 0.0f;
+    float boxCenterRadius = 0.0f;           // distance from the center of the box to the farthest vertex
+    glm::vec3 principalAxis{ 1.0f, 0.0f, 0.0f }; // unit direction of largest spread about the mean, pointing to +x
+    size_t vertexCount = 0;
+
+    glm::vec3 center() const
+    {
+        return (min + max) * 0.5f;
+    }
+
+    glm::vec3 extents() const
+    {
+        return (max - min) * 0.5f;
+    }
+
+    // measures the vertices of meshes, anything whose elements hold vertices[i].Position
+    template <typename MeshList>
+    static ModelBounds compute(const MeshList& meshes, JobSystem* jobs = nullptr)
+    {
+        Measure<MeshList> measure(meshes);
+        return measure.run(jobs);
+    }
+
+private:
+    // partial sums of one chunk of vertices
+    struct Moments
+    {
+        glm::vec3 min{ FLT_MAX };
+        glm::vec3 max{ -FLT_MAX };
+        glm::dvec3 sum{ 0.0 };
+        glm::dmat3 outer{ 0.0 }; // sum of p * p^T
+    };
+
+    // the vertex farthest from a point
+    struct Farthest
+    {
+        float distanceSquared = -1.0f;
+        glm::vec3 position{ 0.0f };
+    };
+
+    struct Chunk
+    {
+        size_t mesh = 0;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    template <typename MeshList>
+    class Measure
+    {
+    public:
+        explicit Measure(const MeshList& meshes) : meshes(meshes)
+        {
+            for (size_t mesh = 0; mesh < meshes.size(); mesh++)
+            {
+                const size_t count = meshes[mesh].vertices.size();
+                for (size_t begin = 0; begin < count; begin += MODEL_BOUNDS_CHUNK_SIZE)
+                    chunks.push_back({ mesh, begin, std::min(begin + MODEL_BOUNDS_CHUNK_SIZE, count) });
+            }
+        }
+
+        ModelBounds run(JobSystem* jobs)
+        {
+            ModelBounds bounds;
+            for (const Chunk& chunk : chunks)
+                bounds.vertexCount += chunk.end - chunk.begin;
+            if (bounds.vertexCount == 0)
+                return bounds;
+
+            // box and moments
+            std::vector<Moments> moments(chunks.size());
+            forEachChunk(jobs, [&](size_t i) { moments[i] = measureMoments(chunks[i]); });
+            Moments total;
+            for (const Moments& part : moments)
+            {
+                total.min = glm::min(total.min, part.min);
+                total.max = glm::max(total.max, part.max);
+                total.sum += part.sum;
+                total.outer += part.outer;
+            }
+            bounds.min = total.min;
+            bounds.max = total.max;
+
+            // Ritter's sphere grown from the center of the box: the farthest vertex outside the sphere pulls it
+            // halfway to itself until none is left outside. Each step is a parallel pass, a few are enough.
+            glm::vec3 center = bounds.center();
+            float radius = 0.0f;
+            bool enclosed = false;
+            for (int step = 0; step < 32 && !enclosed; step++)
+            {
+                const Farthest farthest = farthestFrom(center, jobs);
+                const float distance = std::sqrt(farthest.distanceSquared);
+                if (step == 0)
+                    bounds.boxCenterRadius = distance;
+                enclosed = distance <= radius;
+                if (enclosed)
+                    break;
+                const float grown = (radius + distance) * 0.5f;
+                center += (farthest.position - center) * ((grown - radius) / distance);
+                radius = grown;
+            }
+            // out of steps, the radius reaches the farthest vertex instead
+            if (!enclosed)
+                radius = std::max(radius, std::sqrt(farthestFrom(center, jobs).distanceSquared));
+            bounds.sphereCenter = center;
+            bounds.sphereRadius = radius;
+
+            // principal axis by power iteration on the covariance, starting from +x which decides its sign
+            const double count = static_cast<double>(bounds.vertexCount);
+            const glm::dvec3 mean = total.sum / count;
+            const glm::dmat3 covariance = total.outer / count - glm::outerProduct(mean, mean);
+            glm::dvec3 axis(1.0, 0.0, 0.0);
+            for (int iteration = 0; iteration < 32; iteration++)
+            {
+                const glm::dvec3 next = covariance * axis;
+                const double length = glm::length(next);
+                if (length < 1e-12)
+                    break;
+                axis = next / length;
+            }
+            bounds.principalAxis = glm::vec3(axis);
+            return bounds;
+        }
+
+    private:
+        const MeshList& meshes;
+        std::vector<Chunk> chunks;
+
+        template <typename Body>
+        void forEachChunk(JobSystem* jobs, Body&& body)
+        {
+            const auto range = [&](size_t first, size_t last)
+            {
+                for (size_t i = first; i < last; i++)
+                    body(i);
+            };
+            if (jobs)
+                jobs->parallelFor(chunks.size(), 1, range);
+            else
+                range(0, chunks.size());
+        }
+
+        // copies SIMD_LANES positions from first into one array per component, repeating the first
+        // position past end so the extra lanes change neither the box nor the farthest vertex
+        void gather(const Chunk& chunk, size_t first, float* x, float* y, float* z) const
+        {
+            const auto& vertices = meshes[chunk.mesh].vertices;
+            for (unsigned int lane = 0; lane < SIMD_LANES; lane++)
+            {
+                const glm::vec3& position = vertices[first + lane < chunk.end ? first + lane : chunk.begin].Position;
+                x[lane] = position.x;
+                y[lane] = position.y;
+                z[lane] = position.z;
+            }
+        }
+
+        Moments measureMoments(const Chunk& chunk) const
+        {
+            using namespace Simd;
+            float x[SIMD_LANES], y[SIMD_LANES], z[SIMD_LANES];
+            Lanes minX = broadcast(FLT_MAX), minY = broadcast(FLT_MAX), minZ = broadcast(FLT_MAX);
+            Lanes maxX = broadcast(-FLT_MAX), maxY = broadcast(-FLT_MAX), maxZ = broadcast(-FLT_MAX);
+            for (size_t i = chunk.begin; i < chunk.end; i += SIMD_LANES)
+            {
+                gather(chunk, i, x, y, z);
+                const Lanes px = load(x), py = load(y), pz = load(z);
+                minX = minimum(minX, px);
+                minY = minimum(minY, py);
+                minZ = minimum(minZ, pz);
+                maxX = maximum(maxX, px);
+                maxY = maximum(maxY, py);
+                maxZ = maximum(maxZ, pz);
+            }
+
+            Moments result;
+            float minimums[3][SIMD_LANES], maximums[3][SIMD_LANES];
+            store(minimums[0], minX);
+            store(minimums[1], minY);
+            store(minimums[2], minZ);
+            store(maximums[0], maxX);
+            store(maximums[1], maxY);
+            store(maximums[2], maxZ);
+            for (unsigned int lane = 0; lane < SIMD_LANES; lane++)
+            {
+                result.min = glm::min(result.min, glm::vec3(minimums[0][lane], minimums[1][lane], minimums[2][lane]));
+                result.max = glm::max(result.max, glm::vec3(maximums[0][lane], maximums[1][lane], maximums[2][lane]));
+            }
+
+            // the sums in double, a float loses the covariance of a model far from its origin
+            const auto& vertices = meshes[chunk.mesh].vertices;
+            for (size_t i = chunk.begin; i < chunk.end; i++)
+            {
+                const glm::dvec3 p(vertices[i].Position);
+                result.sum += p;
+                result.outer += glm::outerProduct(p, p);
+            }
+            return result;
+        }
+
+        Farthest farthestFrom(const glm::vec3& point, JobSystem* jobs)
+        {
+            std::vector<Farthest> parts(chunks.size());
+            forEachChunk(jobs, [&](size_t i) { parts[i] = farthestInChunk(chunks[i], point); });
+            Farthest farthest;
+            for (const Farthest& part : parts)
+            {
+                if (part.distanceSquared > farthest.distanceSquared)
+                    farthest = part;
+            }
+            return farthest;
+        }
+
+        Farthest farthestInChunk(const Chunk& chunk, const glm::vec3& point) const
+        {
+            using namespace Simd;
+            float x[SIMD_LANES], y[SIMD_LANES], z[SIMD_LANES];
+            const Lanes cx = broadcast(point.x), cy = broadcast(point.y), cz = broadcast(point.z);
+            Lanes best = broadcast(-1.0f), bestX = broadcast(0.0f), bestY = broadcast(0.0f), bestZ = broadcast(0.0f);
+            for (size_t i = chunk.begin; i < chunk.end; i += SIMD_LANES)
+            {
+                gather(chunk, i, x, y, z);
+                const Lanes px = load(x), py = load(y), pz = load(z);
+                const Lanes dx = sub(px, cx), dy = sub(py, cy), dz = sub(pz, cz);
+                const Lanes distance = add(add(mul(dx, dx), mul(dy, dy)), mul(dz, dz));
+                const LaneMask farther = Simd::greater(distance, best);
+                best = select(farther, distance, best);
+                bestX = select(farther, px, bestX);
+                bestY = select(farther, py, bestY);
+                bestZ = select(farther, pz, bestZ);
+            }
+
+            float distances[SIMD_LANES], xs[SIMD_LANES], ys[SIMD_LANES], zs[SIMD_LANES];
+            store(distances, best);
+            store(xs, bestX);
+            store(ys, bestY);
+            store(zs, bestZ);
+            Farthest farthest;
+            for (unsigned int lane = 0; lane < SIMD_LANES; lane++)
+            {
+                if (distances[lane] > farthest.distanceSquared)
+                {
+                    farthest.distanceSquared = distances[lane];
+                    farthest.position = glm::vec3(xs[lane], ys[lane], zs[lane]);
+                }
+            }
+            return farthest;
+        }
+    };
+};
+#endif
@@ -0,0 +1,198 @@
+#ifndef MODEL_CELL_LOADER_H
+#define MODEL_CELL_LOADER_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <learnopengl/ecs.h>
+#include <learnopengl/ecs_systems.h>
+#include <learnopengl/model.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/world_streaming.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+// what a ModelCellLoader read for one cell: every model file and texture the objects name, each once. The models
+// are owned by the cell, two cells using the same file load it twice.
+struct ModelCell : public CellPayload
+{
+    struct Part
+    {
+        std::string mesh;
+        ModelData data;                 // emptied by the upload
+        std::unique_ptr<Model> model;   // null until uploaded, and for a file that couldn't be read
+        bool read = false;
+        size_t uploadedBytes = 0;
+    };
+
+    struct Image
+    {
+        ModelTextureData data;          // pixels freed by the upload
+        unsigned int texture = 0;
+        size_t uploadedBytes = 0;
+    };
+
+    std::vector<Part> parts;
+    std::vector<Image> images;
+    std::vector<int> objectPart;        // per manifest object, into parts
+    std::vector<int> objectImage;       // per manifest object, into images, -1 for none
+    std::vector<EntityId> entities;
+    size_t finishedParts = 0, finishedImages = 0, finishedObjects = 0;
+
+    size_t bytes() const override
+    {
+        size_t total = 0;
+        for (const Part& part : parts)
+            total += part.data.bytes() + part.uploadedBytes + (part.model ? part.model->cpuGeometryBytes() : 0);
+        for (const Image& image : images)
+            total += image.data.pixels.capacity() + image.uploadedBytes;
+        return total;
+    }
+};
+
+// Streams cells of model files. An object's mesh is the path of a model relative to root and its texture the path
+// of an image that becomes the Renderable's texture, "-" for none; meshes with material textures of their own keep
+// drawing those. load imports the models with ASSIMP, processed as flags asks, and decodes every texture with
+// stb_image on the streaming thread. finish uploads one image or model at a time until the deadline and then makes
+// an entity of every object, with the model's bounds and a Renderable drawn with shader. Objects whose model
+// couldn't be read get no entity.
+class ModelCellLoader : public CellLoader
+{
+public:
+    World& world;
+    Shader& shader;
+    std::string root;
+    unsigned int flags;
+
+    ModelCellLoader(World& world, Shader& shader, const std::string& root, unsigned int flags = MODEL_OPTIMIZE_INDICES | MODEL_RELEASE_CPU_GEOMETRY)
+        : world(world), shader(shader), root(root), flags(flags)
+    {
+    }
+
+    std::unique_ptr<CellPayload> load(const CellManifest& cell) override
+    {
+        std::unique_ptr<ModelCell> payload(new ModelCell());
+        for (const ManifestObject& object : cell.objects)
+        {
+            payload->objectPart.push_back(findPart(*payload, object.mesh));
+            payload->objectImage.push_back(object.texture == "-" ? -1 : findImage(*payload, object.texture));
+        }
+        return payload;
+    }
+
+    bool finish(const CellManifest& cell, CellPayload& payload, std::chrono::steady_clock::time_point deadline) override
+    {
+        ModelCell& loaded = static_cast<ModelCell&>(payload);
+        while (loaded.finishedImages < loaded.images.size())
+        {
+            ModelCell::Image& image = loaded.images[loaded.finishedImages++];
+            if (!image.data.pixels.empty())
+            {
+                image.texture = TextureFromPixels(&image.data.pixels[0], image.data.width, image.data.height, image.data.components);
+                image.uploadedBytes = image.data.pixels.size();
+            }
+            else
+            {
+                std::cout << "ERROR::MODEL_CELL_LOADER:: texture failed to load at path: " << image.data.path << std::endl;
+            }
+            std::vector<unsigned char>().swap(image.data.pixels);
+            if (std::chrono::steady_clock::now() >= deadline)
+                return false;
+        }
+        while (loaded.finishedParts < loaded.parts.size())
+        {
+            ModelCell::Part& part = loaded.parts[loaded.finishedParts++];
+            if (part.read)
+            {
+                part.uploadedBytes = part.data.bytes();
+                part.model.reset(new Model(std::move(part.data)));
+            }
+            if (std::chrono::steady_clock::now() >= deadline)
+                return false;
+        }
+        while (loaded.finishedObjects < cell.objects.size())
+        {
+            const size_t index = loaded.finishedObjects++;
+            const ManifestObject& placement = cell.objects[index];
+            Model* model = loaded.parts[loaded.objectPart[index]].model.get();
+            if (model)
+            {
+                LocalTransform transform;
+                transform.position = placement.position;
+                transform.rotation = glm::angleAxis(glm::radians(placement.yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+                transform.scale = glm::vec3(placement.scale);
+                LocalBounds bounds;
+                bounds.center = model->bounds.center();
+                bounds.extents = model->bounds.extents();
+                Renderable renderable;
+                renderable.model = model;
+                renderable.shader = &shader;
+                if (loaded.objectImage[index] >= 0)
+                    renderable.texture = loaded.images[loaded.objectImage[index]].texture;
+                loaded.entities.push_back(world.create(transform, WorldTransform(), bounds, WorldBounds(), Visibility(), renderable));
+            }
+            if (std::chrono::steady_clock::now() >= deadline)
+                break;
+        }
+        return loaded.finishedObjects == cell.objects.size();
+    }
+
+    void unload(const CellManifest&, CellPayload& payload) override
+    {
+        ModelCell& loaded = static_cast<ModelCell&>(payload);
+        for (EntityId entity : loaded.entities)
+            world.destroy(entity);
+        loaded.entities.clear();
+        for (ModelCell::Part& part : loaded.parts)
+        {
+            if (part.model)
+                part.model->releaseGpuResources();
+            part.model.reset();
+            part.uploadedBytes = 0;
+        }
+        for (ModelCell::Image& image : loaded.images)
+        {
+            if (image.texture != 0)
+                glDeleteTextures(1, &image.texture);
+            image.texture = 0;
+            image.uploadedBytes = 0;
+        }
+    }
+
+private:
+    // index of the part reading mesh, read now if it is the first object using it
+    int findPart(ModelCell& cell, const std::string& mesh)
+    {
+        for (size_t i = 0; i < cell.parts.size(); i++)
+        {
+            if (cell.parts[i].mesh == mesh)
+                return static_cast<int>(i);
+        }
+        cell.parts.emplace_back();
+        ModelCell::Part& part = cell.parts.back();
+        part.mesh = mesh;
+        part.read = part.data.read(root + "/" + mesh, flags, true);
+        return static_cast<int>(cell.parts.size() - 1);
+    }
+
+    int findImage(ModelCell& cell, const std::string& texture)
+    {
+        for (size_t i = 0; i < cell.images.size(); i++)
+        {
+            if (cell.images[i].data.path == texture)
+                return static_cast<int>(i);
+        }
+        cell.images.emplace_back();
+        ModelCell::Image& image = cell.images.back();
+        image.data.path = texture;
+        image.data.type = TEXTURE_DIFFUSE;
+        image.data.decode(root);
+        return static_cast<int>(cell.images.size() - 1);
+    }
+};
+#endif
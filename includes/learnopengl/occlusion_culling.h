@@ -0,0 +1,419 @@
+#ifndef OCCLUSION_CULLING_H
+#define OCCLUSION_CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/entity.h>
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/job_system.h>
+#include <learnopengl/simd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// pixels per side of the tiles the depth buffer keeps a farthest depth for, also the rows rasterized per job
+#define OCCLUSION_TILE_SIZE 8
+
+// what the occlusion buffer did since the last reset
+struct OcclusionStats
+{
+    unsigned int frames = 0;
+    unsigned int occluderTriangles = 0;  // triangles given to addOccluder and addBox
+    unsigned int rasterizedTriangles = 0; // of those, the ones in front of the camera that reached the buffer
+    unsigned int tested = 0;
+    unsigned int occluded = 0;
+    double rasterMilliseconds = 0.0;
+    double testMilliseconds = 0.0;
+
+    void reset()
+    {
+        *this = OcclusionStats();
+    }
+
+    // per frame averages
+    void print(std::ostream& out, const char* label) const
+    {
+        const unsigned int count = std::max(frames, 1u);
+        out << label << ": " << rasterizedTriangles / count << "/" << occluderTriangles / count << " occluder triangles, "
+            << occluded / count << "/" << tested / count << " boxes occluded, raster " << rasterMilliseconds / count << " ms, test "
+            << testMilliseconds / count << " ms" << std::endl;
+    }
+};
+
+// A depth buffer drawn on the CPU with only a few large occluders (walls, buildings, simplified meshes), that
+// bounding boxes are tested against before anything is submitted to the GPU. Every frame:
+//     occlusion.beginFrame(projection * view);
+//     occlusion.addBox(wallModelMatrix); ...
+//     occlusion.rasterize(&JobSystem::shared());
+//     occlusion.cull(boxes, frustumVisible, visible);
+// The buffer is small (a box covering a few pixels there covers dozens on screen), rasterized SIMD_LANES pixels
+// at a time, one band of OCCLUSION_TILE_SIZE rows per job. Next to every pixel's nearest depth it keeps the
+// farthest depth of each tile, so most boxes are decided by a few tile reads instead of every pixel they cover.
+//
+// The test is conservative: a box is occluded only if its nearest corner is behind the occluders at every
+// pixel its screen rectangle touches and at the pixels around them. Occluder triangles are clipped against the near plane, so a wall the
+// camera stands next to still hides what is behind it. Nothing here touches GL, so it runs headless.
+class OcclusionBuffer
+{
+public:
+    OcclusionStats stats;
+
+    // the width is rounded up to whole tiles, the height to whole bands
+    OcclusionBuffer(int width = 256, int height = 128)
+        : width((width + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE * OCCLUSION_TILE_SIZE),
+          height((height + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE * OCCLUSION_TILE_SIZE)
+    {
+        tilesX = this->width / OCCLUSION_TILE_SIZE;
+        tilesY = this->height / OCCLUSION_TILE_SIZE;
+        depth.assign(static_cast<size_t>(this->width) * this->height, 1.0f);
+        tileFarthest.assign(static_cast<size_t>(tilesX) * tilesY, 1.0f);
+    }
+
+    int getWidth() const
+    {
+        return width;
+    }
+
+    int getHeight() const
+    {
+        return height;
+    }
+
+    // drops the occluders of the last frame
+    void beginFrame(const glm::mat4& newViewProjection)
+    {
+        viewProjection = newViewProjection;
+        triangles.clear();
+        stats.frames++;
+    }
+
+    // indexed triangles of an occluder mesh, positions in model space
+    void addOccluder(const glm::vec3* positions, const unsigned int* indices, size_t indexCount, const glm::mat4& model)
+    {
+        const glm::mat4 transform = viewProjection * model;
+        for (size_t i = 0; i + 2 < indexCount; i += 3)
+        {
+            const glm::vec4 a = transform * glm::vec4(positions[indices[i]], 1.0f);
+            const glm::vec4 b = transform * glm::vec4(positions[indices[i + 1]], 1.0f);
+            const glm::vec4 c = transform * glm::vec4(positions[indices[i + 2]], 1.0f);
+            addTriangle(a, b, c);
+        }
+    }
+
+    // the unit cube centered on the origin under model, the cube Ground scales into walls
+    void addBox(const glm::mat4& model)
+    {
+        static const glm::vec3 corners[8] = {
+            { -0.5f, -0.5f, -0.5f }, { 0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, -0.5f }, { -0.5f, 0.5f, -0.5f },
+            { -0.5f, -0.5f, 0.5f }, { 0.5f, -0.5f, 0.5f }, { 0.5f, 0.5f, 0.5f }, { -0.5f, 0.5f, 0.5f }
+        };
+        static const unsigned int faces[36] = {
+            0, 2, 1, 0, 3, 2,  4, 5, 6, 4, 6, 7,  0, 4, 7, 0, 7, 3,
+            1, 2, 6, 1, 6, 5,  0, 1, 5, 0, 5, 4,  3, 7, 6, 3, 6, 2
+        };
+        addOccluder(corners, faces, 36, model);
+    }
+
+    void addBox(const glm::vec3& min, const glm::vec3& max)
+    {
+        glm::mat4 model(1.0f);
+        model[0].x = max.x - min.x;
+        model[1].y = max.y - min.y;
+        model[2].z = max.z - min.z;
+        model[3] = glm::vec4((min + max) * 0.5f, 1.0f);
+        addBox(model);
+    }
+
+    // draws the occluders added since beginFrame, spread over jobs when given
+    void rasterize(JobSystem* jobs = nullptr)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const size_t bands = static_cast<size_t>(tilesY);
+        auto rasterizeBands = [this](size_t first, size_t last) {
+            for (size_t band = first; band < last; band++)
+                rasterizeBand(static_cast<int>(band));
+        };
+        if (jobs)
+            jobs->parallelFor(bands, 1, rasterizeBands);
+        else
+            rasterizeBands(0, bands);
+        stats.rasterizedTriangles += static_cast<unsigned int>(triangles.size());
+        stats.rasterMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // whether the box is hidden behind what was rasterized; boxes reaching behind the camera or off screen
+    // aren't, the frustum decides about those
+    bool isOccluded(const glm::vec3& min, const glm::vec3& max) const
+    {
+        glm::vec2 screenMin(std::numeric_limits<float>::max());
+        glm::vec2 screenMax(-std::numeric_limits<float>::max());
+        float nearest = std::numeric_limits<float>::max();
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const glm::vec3 point((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+            const glm::vec4 clip = viewProjection * glm::vec4(point, 1.0f);
+            if (clip.w <= NEAR_W)
+                return false;
+            const glm::vec3 window = toWindow(clip);
+            screenMin = glm::min(screenMin, glm::vec2(window));
+            screenMax = glm::max(screenMax, glm::vec2(window));
+            nearest = std::min(nearest, window.z);
+        }
+
+        if (screenMax.x < 0.0f || screenMax.y < 0.0f || screenMin.x >= width || screenMin.y >= height)
+            return false;
+        // occluders cover whole pixels whose centers they cover, a box reaching into such a pixel may still show
+        // past the occluder's edge there, so its neighbours have to be nearer as well
+        const int x0 = pixel(screenMin.x - 1.0f, width), y0 = pixel(screenMin.y - 1.0f, height);
+        const int x1 = pixel(screenMax.x + 1.0f, width), y1 = pixel(screenMax.y + 1.0f, height);
+
+        for (int ty = y0 / OCCLUSION_TILE_SIZE; ty <= y1 / OCCLUSION_TILE_SIZE; ty++)
+        {
+            for (int tx = x0 / OCCLUSION_TILE_SIZE; tx <= x1 / OCCLUSION_TILE_SIZE; tx++)
+            {
+                // the whole tile is nearer than the box, no need to look at its pixels
+                if (tileFarthest[ty * tilesX + tx] < nearest)
+                    continue;
+                const int rowEnd = std::min(y1, ty * OCCLUSION_TILE_SIZE + OCCLUSION_TILE_SIZE - 1);
+                const int columnEnd = std::min(x1, tx * OCCLUSION_TILE_SIZE + OCCLUSION_TILE_SIZE - 1);
+                for (int y = std::max(y0, ty * OCCLUSION_TILE_SIZE); y <= rowEnd; y++)
+                {
+                    const float* row = &depth[static_cast<size_t>(y) * width];
+                    for (int x = std::max(x0, tx * OCCLUSION_TILE_SIZE); x <= columnEnd; x++)
+                    {
+                        if (row[x] >= nearest)
+                            return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    bool isOccluded(const AABB& box) const
+    {
+        return isOccluded(box.center - box.extents, box.center + box.extents);
+    }
+
+    // keeps the candidates (indices into boxes, e.g. the output of FrustumCulling::cull) that aren't occluded
+    void cull(const CullingBoxes& boxes, const std::vector<uint32_t>& candidates, std::vector<uint32_t>& visible, JobSystem* jobs = nullptr)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        hidden.resize(candidates.size());
+        auto testRange = [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++)
+            {
+                const uint32_t box = candidates[i];
+                const glm::vec3 center(boxes.centerX[box], boxes.centerY[box], boxes.centerZ[box]);
+                const glm::vec3 extents(boxes.extentX[box], boxes.extentY[box], boxes.extentZ[box]);
+                hidden[i] = isOccluded(center - extents, center + extents) ? 1 : 0;
+            }
+        };
+        if (jobs)
+            jobs->parallelFor(candidates.size(), 256, testRange);
+        else
+            testRange(0, candidates.size());
+
+        visible.clear();
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            if (!hidden[i])
+                visible.push_back(candidates[i]);
+        }
+        stats.tested += static_cast<unsigned int>(candidates.size());
+        stats.occluded += static_cast<unsigned int>(candidates.size() - visible.size());
+        stats.testMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // nearest depth in [0, 1] at a pixel, 1 where no occluder was drawn; row 0 is the bottom of the screen
+    float depthAt(int x, int y) const
+    {
+        return depth[static_cast<size_t>(y) * width + x];
+    }
+
+    // the depth buffer as a binary PGM image, near is dark, for looking at the occluders of a headless run
+    bool writeImage(const std::string& path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cout << "ERROR::OCCLUSION::CANNOT_WRITE: " << path << std::endl;
+            return false;
+        }
+        file << "P5\n" << width << " " << height << "\n255\n";
+        for (int y = height - 1; y >= 0; y--)
+        {
+            for (int x = 0; x < width; x++)
+            {
+                // depth crowds towards 1 with a perspective projection, spread it out a bit
+                const float value = std::pow(depthAt(x, y), 32.0f);
+                file.put(static_cast<char>(static_cast<unsigned char>(value * 255.0f)));
+            }
+        }
+        return static_cast<bool>(file);
+    }
+
+private:
+    // a triangle in window space: x and y in pixels, z the depth in [0, 1]
+    struct Triangle
+    {
+        glm::vec3 a, b, c;
+        glm::vec2 min, max;
+    };
+
+    // boxes reaching this close to the eye aren't tested, the divide would blow them up
+    static constexpr float NEAR_W = 1e-4f;
+
+    int width, height;
+    int tilesX, tilesY;
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    std::vector<Triangle> triangles;
+    std::vector<float> depth;
+    std::vector<float> tileFarthest;
+    std::vector<uint8_t> hidden;
+
+    // the pixel a window coordinate falls in, clamped to [0, size) before converting
+    static int pixel(float coordinate, int size)
+    {
+        return static_cast<int>(std::floor(std::min(std::max(coordinate, 0.0f), size - 1.0f)));
+    }
+
+    glm::vec3 toWindow(const glm::vec4& clip) const
+    {
+        const glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        return glm::vec3((ndc.x * 0.5f + 0.5f) * width, (ndc.y * 0.5f + 0.5f) * height, ndc.z * 0.5f + 0.5f);
+    }
+
+    // clips a clip space triangle against the near plane (z >= -w), the rest is fanned into window space triangles
+    void addTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+    {
+        stats.occluderTriangles++;
+        const glm::vec4 input[3] = { a, b, c };
+        glm::vec4 clipped[4];
+        int count = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            const glm::vec4& from = input[i];
+            const glm::vec4& to = input[(i + 1) % 3];
+            const float fromDistance = from.z + from.w;
+            const float toDistance = to.z + to.w;
+            if (fromDistance >= 0.0f)
+                clipped[count++] = from;
+            if ((fromDistance >= 0.0f) != (toDistance >= 0.0f))
+                clipped[count++] = glm::mix(from, to, fromDistance / (fromDistance - toDistance));
+        }
+        for (int i = 1; i + 1 < count; i++)
+            addClippedTriangle(clipped[0], clipped[i], clipped[i + 1]);
+    }
+
+    void addClippedTriangle(const glm::vec4& a, const glm::vec4& b, const glm::vec4& c)
+    {
+        if (a.w <= NEAR_W || b.w <= NEAR_W || c.w <= NEAR_W)
+            return;
+        Triangle triangle;
+        triangle.a = toWindow(a);
+        triangle.b = toWindow(b);
+        triangle.c = toWindow(c);
+        triangle.min = glm::min(glm::min(glm::vec2(triangle.a), glm::vec2(triangle.b)), glm::vec2(triangle.c));
+        triangle.max = glm::max(glm::max(glm::vec2(triangle.a), glm::vec2(triangle.b)), glm::vec2(triangle.c));
+        // off screen or beyond the far plane
+        if (triangle.max.x < 0.0f || triangle.max.y < 0.0f || triangle.min.x > width || triangle.min.y > height)
+            return;
+        if (triangle.a.z > 1.0f && triangle.b.z > 1.0f && triangle.c.z > 1.0f)
+            return;
+        triangles.push_back(triangle);
+    }
+
+    void rasterizeBand(int band)
+    {
+        const int rowBegin = band * OCCLUSION_TILE_SIZE;
+        const int rowEnd = rowBegin + OCCLUSION_TILE_SIZE;
+        std::fill(depth.begin() + static_cast<size_t>(rowBegin) * width, depth.begin() + static_cast<size_t>(rowEnd) * width, 1.0f);
+        for (const Triangle& triangle : triangles)
+        {
+            if (triangle.max.y < rowBegin || triangle.min.y > rowEnd)
+                continue;
+            rasterizeTriangle(triangle, rowBegin, rowEnd);
+        }
+
+        // farthest depth of every tile in the band
+        for (int tx = 0; tx < tilesX; tx++)
+        {
+            float farthest = 0.0f;
+            for (int y = rowBegin; y < rowEnd; y++)
+            {
+                const float* row = &depth[static_cast<size_t>(y) * width + tx * OCCLUSION_TILE_SIZE];
+                for (int x = 0; x < OCCLUSION_TILE_SIZE; x++)
+                    farthest = std::max(farthest, row[x]);
+            }
+            tileFarthest[band * tilesX + tx] = farthest;
+        }
+    }
+
+    // edge functions at the pixel centers, SIMD_LANES pixels of a row at a time; a pixel is covered when it is on
+    // the inner side of all three edges and keeps the nearer of its depth and the triangle's
+    void rasterizeTriangle(const Triangle& triangle, int rowBegin, int rowEnd)
+    {
+        glm::vec3 a = triangle.a, b = triangle.b, c = triangle.c;
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (area == 0.0f)
+            return;
+        // both windings are drawn, an occluder hides what is behind it whichever side faces the camera
+        if (area < 0.0f)
+        {
+            std::swap(b, c);
+            area = -area;
+        }
+
+        // edge i is e(x, y) = stepX * x + stepY * y + offset, positive inside
+        const glm::vec3 stepX(b.y - c.y, c.y - a.y, a.y - b.y);
+        const glm::vec3 stepY(c.x - b.x, a.x - c.x, b.x - a.x);
+        const glm::vec3 offset(b.x * c.y - b.y * c.x, c.x * a.y - c.y * a.x, a.x * b.y - a.y * b.x);
+        // the depth is linear in window space, the edge functions divided by the area are its weights
+        const glm::vec3 depths(a.z, b.z, c.z);
+        const float depthStepX = glm::dot(stepX, depths) / area;
+        const float depthStepY = glm::dot(stepY, depths) / area;
+        const float depthOffset = glm::dot(offset, depths) / area;
+
+        const int x0 = pixel(triangle.min.x, width) / SIMD_LANES * SIMD_LANES;
+        const int x1 = pixel(triangle.max.x, width);
+        const int y0 = std::max(rowBegin, pixel(triangle.min.y, height));
+        const int y1 = std::min(rowEnd - 1, pixel(triangle.max.y, height));
+
+        const Simd::Lanes zero = Simd::broadcast(0.0f);
+        const Simd::Lanes laneX = Simd::laneIndices();
+        const Simd::Lanes edgeStepX0 = Simd::broadcast(stepX.x), edgeStepX1 = Simd::broadcast(stepX.y), edgeStepX2 = Simd::broadcast(stepX.z);
+        const Simd::Lanes laneDepthStep = Simd::broadcast(depthStepX);
+        for (int y = y0; y <= y1; y++)
+        {
+            const float centerY = y + 0.5f;
+            const float rowEdge0 = stepY.x * centerY + offset.x;
+            const float rowEdge1 = stepY.y * centerY + offset.y;
+            const float rowEdge2 = stepY.z * centerY + offset.z;
+            const float rowDepth = depthStepY * centerY + depthOffset;
+            float* row = &depth[static_cast<size_t>(y) * width];
+            for (int x = x0; x <= x1; x += SIMD_LANES)
+            {
+                const Simd::Lanes centerX = Simd::add(Simd::broadcast(x + 0.5f), laneX);
+                const Simd::Lanes edge0 = Simd::add(Simd::mul(edgeStepX0, centerX), Simd::broadcast(rowEdge0));
+                const Simd::Lanes edge1 = Simd::add(Simd::mul(edgeStepX1, centerX), Simd::broadcast(rowEdge1));
+                const Simd::Lanes edge2 = Simd::add(Simd::mul(edgeStepX2, centerX), Simd::broadcast(rowEdge2));
+                const Simd::LaneMask inside = Simd::both(Simd::both(Simd::greaterEqual(edge0, zero), Simd::greaterEqual(edge1, zero)),
+                                                         Simd::greaterEqual(edge2, zero));
+                if (Simd::bits(inside) == 0)
+                    continue;
+                const Simd::Lanes triangleDepth = Simd::add(Simd::mul(laneDepthStep, centerX), Simd::broadcast(rowDepth));
+                const Simd::Lanes current = Simd::load(row + x);
+                Simd::store(row + x, Simd::select(inside, Simd::minimum(current, triangleDepth), current));
+            }
+        }
+    }
+};
+#endif
@@ -0,0 +1,234 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// what the cache did for the programs built since the last reset
+struct ProgramCacheStats
+{
+    unsigned int loaded = 0;        // programs created from a stored binary
+    unsigned int compiled = 0;      // programs compiled from source
+    unsigned int rejected = 0;      // stored binaries the driver refused, compiled again
+    double loadMilliseconds = 0.0;
+    double compileMilliseconds = 0.0;
+    double savedMilliseconds = 0.0; // compile time recorded with each loaded binary minus the time its load took
+
+    void reset()
+    {
+        *this = ProgramCacheStats();
+    }
+
+    void print(std::ostream& out, const char* label) const
+    {
+        out << label << ": " << loaded << " loaded (" << loadMilliseconds << " ms), " << compiled << " compiled ("
+            << compileMilliseconds << " ms), " << rejected << " rejected, " << savedMilliseconds << " ms saved" << std::endl;
+    }
+};
+
+// Linked programs kept on disk with glGetProgramBinary, so the next launch creates them with glProgramBinary
+// instead of compiling GLSL again. A binary is keyed by a hash of every stage's source (including any defines
+// written into it) and the GL vendor, renderer and version strings, a changed shader or a driver update simply
+// misses. Binaries the driver refuses anyway are compiled again and overwritten.
+//
+// Program binaries need a GL 4.1 context and at least one binary format, without them (and with
+// LOGL_PROGRAM_CACHE set to an empty string) every program is compiled as before. The files go to
+// LOGL_PROGRAM_CACHE, or program_cache/ in the working directory when it isn't set.
+namespace ProgramCache
+{
+    inline ProgramCacheStats stats;
+
+    // file header, followed by length bytes of binary
+    struct Header
+    {
+        uint32_t magic = 0x42504C47; // "GLPB"
+        uint32_t version = 1;
+        uint64_t key = 0;
+        uint32_t format = 0;
+        uint32_t length = 0;
+        double compileMilliseconds = 0.0;
+    };
+
+    // 64-bit FNV-1a, continued from hash
+    inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 14695981039346656037ull)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    inline bool supported()
+    {
+        if (!GLAD_GL_VERSION_4_1)
+            return false;
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+    inline const std::string& directory()
+    {
+        static const std::string path = []() {
+            const char* env = getenv("LOGL_PROGRAM_CACHE");
+            return std::string(env != nullptr ? env : "program_cache");
+        }();
+        return path;
+    }
+
+    inline bool enabled()
+    {
+        static const bool available = !directory().empty() && supported();
+        return available;
+    }
+
+    // binaries only fit the driver that wrote them
+    inline const std::string& driver()
+    {
+        static const std::string name = []() {
+            std::string result;
+            for (GLenum query : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+            {
+                const GLubyte* value = glGetString(query);
+                result += value ? reinterpret_cast<const char*>(value) : "";
+                result += '\n';
+            }
+            return result;
+        }();
+        return name;
+    }
+
+    inline uint64_t key(std::initializer_list<const std::string*> sources)
+    {
+        uint64_t hash = hashBytes(driver().data(), driver().size());
+        for (const std::string* source : sources)
+        {
+            // the length separates the stages, moving text from one to the next changes the key
+            const uint64_t length = source ? source->size() : 0;
+            hash = hashBytes(&length, sizeof(length), hash);
+            if (length > 0)
+                hash = hashBytes(source->data(), source->size(), hash);
+        }
+        return hash;
+    }
+
+    inline std::string pathOf(uint64_t key)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+        return directory() + "/" + name;
+    }
+}
+
+// One program being built. Construct it with the stage sources before compiling, then
+//     ID = cached.load();
+//     if (ID == 0) { compile, cached.prepareLink(ID), link, cached.store(ID) }
+// load() and store() keep the timing for ProgramCache::stats.
+class CachedProgram
+{
+public:
+    explicit CachedProgram(std::initializer_list<const std::string*> sources) : start(std::chrono::steady_clock::now())
+    {
+        if (ProgramCache::enabled())
+            key = ProgramCache::key(sources);
+    }
+
+    // a linked program from the stored binary, 0 when there is none or the driver refuses it
+    GLuint load()
+    {
+        if (!ProgramCache::enabled())
+            return 0;
+        std::ifstream file(ProgramCache::pathOf(key), std::ios::binary);
+        if (!file)
+            return 0;
+        ProgramCache::Header header, expected;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!file || header.magic != expected.magic || header.version != expected.version || header.key != key)
+            return 0;
+        std::vector<char> binary(header.length);
+        file.read(binary.data(), header.length);
+        if (!file)
+            return 0;
+
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(header.length));
+        GLint linked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            glDeleteProgram(program);
+            ProgramCache::stats.rejected++;
+            start = std::chrono::steady_clock::now();
+            return 0;
+        }
+        const double milliseconds = elapsedMilliseconds();
+        ProgramCache::stats.loaded++;
+        ProgramCache::stats.loadMilliseconds += milliseconds;
+        ProgramCache::stats.savedMilliseconds += header.compileMilliseconds - milliseconds;
+        return program;
+    }
+
+    // asks the driver to keep the binary around, has to be called before glLinkProgram
+    void prepareLink(GLuint program) const
+    {
+        if (ProgramCache::enabled())
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // writes the binary of the freshly linked program for the next run
+    void store(GLuint program)
+    {
+        const double milliseconds = elapsedMilliseconds();
+        ProgramCache::stats.compiled++;
+        ProgramCache::stats.compileMilliseconds += milliseconds;
+        if (!ProgramCache::enabled())
+            return;
+        GLint linked = 0, length = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (!linked || length <= 0)
+            return;
+
+        ProgramCache::Header header;
+        header.key = key;
+        header.compileMilliseconds = milliseconds;
+        std::vector<char> binary(length);
+        GLsizei written = 0;
+        glGetProgramBinary(program, length, &written, &header.format, binary.data());
+        header.length = static_cast<uint32_t>(written);
+
+        std::error_code error;
+        std::filesystem::create_directories(ProgramCache::directory(), error);
+        std::ofstream file(ProgramCache::pathOf(key), std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            std::cout << "ERROR::PROGRAM_CACHE::CANNOT_WRITE: " << ProgramCache::pathOf(key) << std::endl;
+            return;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+    }
+
+private:
+    uint64_t key = 0;
+    std::chrono::steady_clock::time_point start;
+
+    double elapsedMilliseconds() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+#endif
@@ -0,0 +1,250 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/instance_buffer.h>
+#include <learnopengl/material.h>
+#include <learnopengl/shader.h>
+
+#include <cstdint>
+#include <vector>
+
+// passes are drawn in this order, the transparent one back to front
+enum RenderPass {
+    PASS_OPAQUE = 0,
+    PASS_TRANSPARENT = 1
+};
+
+// everything needed to issue one draw, collected first and executed in sorted order by RenderQueue::flush
+struct DrawPacket
+{
+    RenderPass pass = PASS_OPAQUE;
+    Shader* shader = nullptr;
+    const MaterialBinding* material = nullptr; // textures resolved for shader
+    unsigned int texture = 0;                  // bound to unit 0 when there is no material (or it has no textures)
+    unsigned int VAO = 0;
+
+    // geometry: glDrawArrays when indexType is 0, glMultiDrawElements when drawCount is set, glDrawElements otherwise
+    GLenum indexType = 0;
+    GLsizei count = 0;
+    GLint first = 0;                      // first vertex for glDrawArrays
+    const void* offset = nullptr;         // byte offset into the element buffer
+    const GLsizei* counts = nullptr;      // multi draw ranges, owned by the mesh
+    const void* const* offsets = nullptr;
+    GLsizei drawCount = 0;
+
+    // set for instanced draws, every instance the buffer holds at flush time is drawn with one call per range
+    const InstanceBuffer* instances = nullptr;
+
+    // per draw uniforms
+    glm::mat4 model = glm::mat4(1.0f);
+    bool useColor = false;
+    glm::vec3 color = glm::vec3(1.0f);
+};
+
+// state changes and draws of the last flush
+struct RenderQueueStats
+{
+    unsigned int packets = 0;
+    unsigned int programChanges = 0;
+    unsigned int materialChanges = 0;
+    unsigned int vertexArrayChanges = 0;
+
+    void reset()
+    {
+        *this = RenderQueueStats();
+    }
+};
+
+// Collects DrawPackets and executes them sorted by a 64-bit key, so draws sharing a shader, material and
+// vertex array end up next to each other and only the state that differs is changed between them.
+//
+// opaque key:      | pass 4 | shader 8 | material 16 | vao 12 | depth 24 |   front to back inside a state group
+// transparent key: | pass 4 | depth 24 | shader 8 | material 16 | vao 12 |   back to front, state second
+// shader and vao are the low bits of the GL object names, material a hash of the binding.
+class RenderQueue
+{
+public:
+    RenderQueueStats stats;
+
+    // names of the uniforms written for every packet, inactive ones cost nothing
+    UniformName modelUniform = "model";
+    UniformName useColorUniform = "useColor";
+    UniformName colorUniform = "objectColor";
+    UniformName samplerUniform = "texture_diffuse1"; // pointed at unit 0 for packets without a material
+
+    // depth in the sort keys is the distance to the camera, quantized over [0, farPlane]
+    void setCamera(const glm::vec3& position, float farPlane)
+    {
+        cameraPosition = position;
+        depthScale = farPlane > 0.0f ? 1.0f / farPlane : 0.0f;
+    }
+
+    void submit(const DrawPacket& packet)
+    {
+        const uint64_t pass = static_cast<uint64_t>(packet.pass) & 0xF;
+        const uint64_t shader = static_cast<uint64_t>(packet.shader->ID) & 0xFF;
+        const uint64_t material = materialKey(packet) & 0xFFFF;
+        const uint64_t vao = static_cast<uint64_t>(packet.VAO) & 0xFFF;
+
+        const glm::vec3 position(packet.model[3]);
+        float depth = glm::length(position - cameraPosition) * depthScale;
+        depth = depth < 0.0f ? 0.0f : (depth > 1.0f ? 1.0f : depth);
+        uint64_t quantized = static_cast<uint64_t>(depth * 0xFFFFFF);
+
+        uint64_t key;
+        if (packet.pass == PASS_TRANSPARENT)
+            key = pass << 60 | (0xFFFFFF - quantized) << 36 | shader << 28 | material << 12 | vao;
+        else
+            key = pass << 60 | shader << 52 | material << 36 | vao << 24 | quantized;
+
+        sortEntries.push_back({ key, static_cast<uint32_t>(packets.size()) });
+        packets.push_back(packet);
+    }
+
+    // sorts and executes everything submitted since the last flush
+    void flush()
+    {
+        stats.reset();
+        stats.packets = static_cast<unsigned int>(packets.size());
+        radixSort();
+
+        Shader* currentShader = nullptr;
+        const void* currentMaterial = nullptr;
+        unsigned int currentTexture = 0;
+        unsigned int currentVAO = ~0u;
+        // no bone and no weight for vertex arrays without a bone stream, arrays that have one never read these
+        glVertexAttribI4i(5, -1, -1, -1, -1);
+        glVertexAttrib4f(6, 0.0f, 0.0f, 0.0f, 0.0f);
+        for (const SortEntry& entry : sortEntries)
+        {
+            const DrawPacket& packet = packets[entry.index];
+            if (packet.instances && packet.instances->count() == 0)
+                continue;
+            bool shaderChanged = false;
+            if (packet.shader != currentShader)
+            {
+                currentShader = packet.shader;
+                currentShader->use();
+                stats.programChanges++;
+                shaderChanged = true;
+            }
+            if (packet.VAO != currentVAO)
+            {
+                currentVAO = packet.VAO;
+                glBindVertexArray(currentVAO);
+                stats.vertexArrayChanges++;
+            }
+
+            // sampler values belong to the program, a new program needs its material set again
+            const bool hasMaterial = packet.material && !packet.material->slots.empty();
+            const void* material = hasMaterial ? static_cast<const void*>(packet.material) : nullptr;
+            if (shaderChanged || material != currentMaterial || (!hasMaterial && packet.texture != currentTexture))
+            {
+                if (hasMaterial)
+                    packet.material->bind(*currentShader);
+                else
+                {
+                    glActiveTexture(GL_TEXTURE0);
+                    glBindTexture(GL_TEXTURE_2D, packet.texture);
+                    currentShader->setInt(samplerUniform, 0);
+                }
+                currentMaterial = material;
+                currentTexture = hasMaterial ? 0 : packet.texture;
+                stats.materialChanges++;
+            }
+
+            currentShader->setMat4(modelUniform, packet.model);
+            currentShader->setBool(useColorUniform, packet.useColor);
+            if (packet.useColor)
+                currentShader->setVec3(colorUniform, packet.color);
+
+            if (packet.instances)
+                drawInstanced(packet);
+            else if (packet.indexType == 0)
+                glDrawArrays(GL_TRIANGLES, packet.first, packet.count);
+            else if (packet.drawCount > 0)
+                glMultiDrawElements(GL_TRIANGLES, packet.counts, packet.indexType, packet.offsets, packet.drawCount);
+            else
+                glDrawElements(GL_TRIANGLES, packet.count, packet.indexType, packet.offset);
+        }
+        glActiveTexture(GL_TEXTURE0);
+
+        packets.clear();
+        sortEntries.clear();
+    }
+
+private:
+    struct SortEntry
+    {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    vector<DrawPacket> packets;
+    vector<SortEntry> sortEntries;
+    vector<SortEntry> sortScratch;
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    float depthScale = 0.001f;
+
+    // Materials and plain textures hashed into the 16 bits of the key, textures tagged in the low bit so they can't
+    // collide with a material pointer. A collision only interleaves two groups, flush still compares the real objects.
+    static uint64_t materialKey(const DrawPacket& packet)
+    {
+        const bool hasMaterial = packet.material && !packet.material->slots.empty();
+        uint64_t id = hasMaterial ? reinterpret_cast<uintptr_t>(packet.material) : (static_cast<uint64_t>(packet.texture) << 1 | 1);
+        id ^= id >> 33;
+        id *= 0xff51afd7ed558ccdull;
+        id ^= id >> 33;
+        return id;
+    }
+
+    // the vertex array of packet has to be bound
+    static void drawInstanced(const DrawPacket& packet)
+    {
+        const GLsizei instanceCount = packet.instances->count();
+        packet.instances->attach(packet.VAO);
+        if (packet.indexType == 0)
+            glDrawArraysInstanced(GL_TRIANGLES, packet.first, packet.count, instanceCount);
+        else if (packet.drawCount > 0)
+        {
+            // there is no instanced multi draw before indirect draws, one call per range
+            for (GLsizei i = 0; i < packet.drawCount; i++)
+                glDrawElementsInstanced(GL_TRIANGLES, packet.counts[i], packet.indexType, packet.offsets[i], instanceCount);
+        }
+        else
+            glDrawElementsInstanced(GL_TRIANGLES, packet.count, packet.indexType, packet.offset, instanceCount);
+    }
+
+    // least significant digit radix sort on 8-bit digits, digits every key shares are skipped
+    void radixSort()
+    {
+        const size_t count = sortEntries.size();
+        if (count < 2)
+            return;
+        sortScratch.resize(count);
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            size_t histogram[256] = {};
+            for (const SortEntry& entry : sortEntries)
+                histogram[(entry.key >> shift) & 0xFF]++;
+            if (histogram[(sortEntries[0].key >> shift) & 0xFF] == count)
+                continue;
+
+            size_t offset = 0;
+            for (size_t& bucket : histogram)
+            {
+                const size_t size = bucket;
+                bucket = offset;
+                offset += size;
+            }
+            for (const SortEntry& entry : sortEntries)
+                sortScratch[histogram[(entry.key >> shift) & 0xFF]++] = entry;
+            sortEntries.swap(sortScratch);
+        }
+    }
+};
+#endif
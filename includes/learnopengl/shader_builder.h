@@ -0,0 +1,186 @@
+#ifndef SHADER_BUILDER_H
+#define SHADER_BUILDER_H
+
+#include <fstream>
+#include <iostream>
+#include <locale>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Permutation keys of a shader, written as #define lines right after its #version. A shader tests them with
+// #ifdef / #if, so a feature a material doesn't use is compiled out instead of branched around at runtime.
+class ShaderDefines
+{
+public:
+    ShaderDefines& set(const std::string& name, const std::string& value = "1")
+    {
+        // kept sorted by name, the same set of keys always gives the same key() and source
+        auto it = entries.begin();
+        while (it != entries.end() && it->first < name)
+            ++it;
+        if (it != entries.end() && it->first == name)
+            it->second = value;
+        else
+            entries.insert(it, std::make_pair(name, value));
+        return *this;
+    }
+
+    ShaderDefines& set(const std::string& name, int value)
+    {
+        return set(name, std::to_string(value));
+    }
+
+    ShaderDefines& set(const std::string& name, float value)
+    {
+        // std::to_string would write the locale's decimal separator
+        std::ostringstream text;
+        text.imbue(std::locale::classic());
+        text << std::showpoint << value;
+        return set(name, text.str());
+    }
+
+    bool empty() const
+    {
+        return entries.empty();
+    }
+
+    // identifies the permutation, e.g. "FACE_TEXTURE=1;NR_POINT_LIGHTS=4"
+    std::string key() const
+    {
+        std::string result;
+        for (const auto& entry : entries)
+            result += entry.first + "=" + entry.second + ";";
+        return result;
+    }
+
+    std::string header() const
+    {
+        std::string result;
+        for (const auto& entry : entries)
+            result += "#define " + entry.first + " " + entry.second + "\n";
+        return result;
+    }
+
+private:
+    std::vector<std::pair<std::string, std::string>> entries;
+};
+
+// Loads shader sources for every Shader class. Lines of the form
+//     #include "common.glsl"
+// are replaced by the named file, looked up next to the file including it, and every file is included at most
+// once per shader. #line directives keep compile errors pointing at the right place: the first number of an
+// error is the file (0 for the shader itself, then the includes in the order they were met), the second the
+// line in that file.
+namespace ShaderBuilder
+{
+    inline bool readFile(const std::string& path, std::string& text)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        std::stringstream stream;
+        stream << file.rdbuf();
+        text = stream.str();
+        return true;
+    }
+
+    inline std::string directoryOf(const std::string& path)
+    {
+        const size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+    }
+
+    // appends path to out, defines go after its #version line
+    inline bool append(const std::string& path, std::string& out, std::vector<std::string>& files, const ShaderDefines* defines)
+    {
+        std::string text;
+        if (!readFile(path, text))
+            return false;
+        const size_t fileIndex = files.size();
+        files.push_back(path);
+        if (fileIndex > 0)
+            out += "#line 1 " + std::to_string(fileIndex) + "\n";
+
+        std::istringstream lines(text);
+        std::string line;
+        for (unsigned int number = 1; std::getline(lines, line); number++)
+        {
+            const size_t start = line.find_first_not_of(" \t");
+            const std::string directive = start == std::string::npos ? std::string() : line.substr(start);
+            if (directive.compare(0, 8, "#include") == 0)
+            {
+                const size_t open = directive.find('"');
+                const size_t close = open == std::string::npos ? open : directive.find('"', open + 1);
+                if (close == std::string::npos)
+                {
+                    std::cout << "ERROR::SHADER::BAD_INCLUDE: " << path << "(" << number << ")" << std::endl;
+                    continue;
+                }
+                const std::string included = directoryOf(path) + directive.substr(open + 1, close - open - 1);
+                bool seen = false;
+                for (const std::string& file : files)
+                    seen = seen || file == included;
+                if (!seen && !append(included, out, files, nullptr))
+                    std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << included << " (from " << path << ")" << std::endl;
+                out += "#line " + std::to_string(number + 1) + " " + std::to_string(fileIndex) + "\n";
+                continue;
+            }
+            out += line;
+            out += '\n';
+            if (defines && !defines->empty() && directive.compare(0, 8, "#version") == 0)
+            {
+                out += defines->header();
+                out += "#line " + std::to_string(number + 1) + " " + std::to_string(fileIndex) + "\n";
+                defines = nullptr;
+            }
+        }
+        return true;
+    }
+
+    // the source of path with its includes resolved and defines injected, empty if it can't be read
+    inline std::string load(const char* path, const ShaderDefines& defines = ShaderDefines())
+    {
+        if (path == nullptr)
+            return std::string();
+        std::string source;
+        std::vector<std::string> files;
+        if (!append(path, source, files, &defines))
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << std::endl;
+        return source;
+    }
+}
+
+// The programs built from one vertex and fragment shader pair, one per permutation key. get() compiles a
+// permutation the first time it is asked for and returns the same program afterwards, so materials can each
+// pick the specialised program they need without building it twice.
+template <typename ShaderType>
+class ShaderVariants
+{
+public:
+    ShaderVariants(const char* vertexPath, const char* fragmentPath) : vertexPath(vertexPath), fragmentPath(fragmentPath)
+    {
+    }
+
+    ShaderType& get(const ShaderDefines& defines = ShaderDefines())
+    {
+        std::unique_ptr<ShaderType>& program = programs[defines.key()];
+        if (!program)
+            program.reset(new ShaderType(vertexPath.c_str(), fragmentPath.c_str(), defines));
+        return *program;
+    }
+
+    size_t size() const
+    {
+        return programs.size();
+    }
+
+private:
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::map<std::string, std::unique_ptr<ShaderType>> programs;
+};
+#endif
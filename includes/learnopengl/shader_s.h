@@ -3,50 +3,41 @@
 
 #include <glad/glad.h>
 
+#include <glm/glm.hpp>
+
 #include <string>
-#include <fstream>
-#include <sstream>
 #include <iostream>
 
+#include <learnopengl/frame_uniforms.h>
+#include <learnopengl/program_cache.h>
+#include <learnopengl/shader_builder.h>
+#include <learnopengl/uniform_table.h>
+
 class Shader
 {
 public:
     unsigned int ID;
+    // active uniforms of the program with the last value written to each, see uniform_table.h
+    mutable UniformTable uniforms;
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath)
+    Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines& defines = ShaderDefines())
     {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode   = vShaderStream.str();
-            fragmentCode = fShaderStream.str();
-        }
-        catch (std::ifstream::failure& e)
+        // 1. retrieve the source code from filePath, with includes resolved and the defines added
+        std::string vertexCode = ShaderBuilder::load(vertexPath, defines);
+        std::string fragmentCode = ShaderBuilder::load(fragmentPath, defines);
+        // 2. reuse the program binary of an earlier run when neither the sources nor the driver changed
+        CachedProgram cached({ &vertexCode, &fragmentCode });
+        ID = cached.load();
+        if (ID != 0)
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
+            uniforms.reflect(ID);
+            FrameUniforms::bindBlock(ID);
+            return;
         }
         const char* vShaderCode = vertexCode.c_str();
         const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
+        // 3. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
@@ -62,8 +53,12 @@ public:
         ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
+        cached.prepareLink(ID);
         glLinkProgram(ID);
         checkCompileErrors(ID, "PROGRAM");
+        cached.store(ID);
+        uniforms.reflect(ID);
+        FrameUniforms::bindBlock(ID);
         // delete the shaders as they're linked into our program now and no longer necessary
         glDeleteShader(vertex);
         glDeleteShader(fragment);
@@ -76,19 +71,47 @@ public:
     }
     // utility uniform functions
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    void setBool(const UniformName &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        int intValue = (int)value;
+        GLint location;
+        if (uniforms.update(name, &intValue, sizeof(intValue), location))
+            glUniform1i(location, intValue);
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setInt(const UniformName &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        GLint location;
+        if (uniforms.update(name, &value, sizeof(value), location))
+            glUniform1i(location, value);
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setFloat(const UniformName &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        GLint location;
+        if (uniforms.update(name, &value, sizeof(value), location))
+            glUniform1f(location, value);
+    }
+    // ------------------------------------------------------------------------
+    void setVec3(const UniformName &name, const glm::vec3 &value) const
+    {
+        GLint location;
+        if (uniforms.update(name, &value[0], sizeof(value), location))
+            glUniform3fv(location, 1, &value[0]);
+    }
+    // ------------------------------------------------------------------------
+    void setVec4(const UniformName &name, const glm::vec4 &value) const
+    {
+        GLint location;
+        if (uniforms.update(name, &value[0], sizeof(value), location))
+            glUniform4fv(location, 1, &value[0]);
+    }
+    // ------------------------------------------------------------------------
+    void setMat4(const UniformName &name, const glm::mat4 &mat) const
+    {
+        GLint location;
+        if (uniforms.update(name, &mat[0][0], sizeof(mat), location))
+            glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
     }
 
 private:
@@ -0,0 +1,121 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <cstdint>
+
+// the widest instruction set the compiler was allowed to use, NEON only on 64-bit ARM where
+// lanes can be summed into a mask with one instruction
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIMD_AVX
+#define SIMD_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_SSE
+#define SIMD_LANES 4
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SIMD_NEON
+#define SIMD_LANES 4
+#else
+#define SIMD_LANES 1
+#endif
+
+// SIMD_LANES floats handled by one instruction, with a scalar fallback so code written against these
+// functions builds everywhere. Comparisons give a LaneMask, bits() packs it into one bit per lane.
+namespace Simd
+{
+#if defined(SIMD_AVX)
+    typedef __m256 Lanes;
+    typedef __m256 LaneMask;
+    inline Lanes load(const float* values) { return _mm256_loadu_ps(values); }
+    inline void store(float* values, Lanes lanes) { _mm256_storeu_ps(values, lanes); }
+    inline Lanes broadcast(float value) { return _mm256_set1_ps(value); }
+    inline Lanes laneIndices() { return _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f); }
+    inline Lanes add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+    inline Lanes sub(Lanes a, Lanes b) { return _mm256_sub_ps(a, b); }
+    inline Lanes mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+    inline Lanes minimum(Lanes a, Lanes b) { return _mm256_min_ps(a, b); }
+    inline Lanes maximum(Lanes a, Lanes b) { return _mm256_max_ps(a, b); }
+    inline LaneMask less(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    inline LaneMask lessEqual(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+    inline LaneMask greater(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    inline LaneMask greaterEqual(Lanes a, Lanes b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    inline LaneMask both(LaneMask a, LaneMask b) { return _mm256_and_ps(a, b); }
+    inline Lanes select(LaneMask mask, Lanes a, Lanes b) { return _mm256_blendv_ps(b, a, mask); }
+    inline unsigned int bits(LaneMask mask) { return static_cast<unsigned int>(_mm256_movemask_ps(mask)); }
+#elif defined(SIMD_SSE)
+    typedef __m128 Lanes;
+    typedef __m128 LaneMask;
+    inline Lanes load(const float* values) { return _mm_loadu_ps(values); }
+    inline void store(float* values, Lanes lanes) { _mm_storeu_ps(values, lanes); }
+    inline Lanes broadcast(float value) { return _mm_set1_ps(value); }
+    inline Lanes laneIndices() { return _mm_setr_ps(0.f, 1.f, 2.f, 3.f); }
+    inline Lanes add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+    inline Lanes sub(Lanes a, Lanes b) { return _mm_sub_ps(a, b); }
+    inline Lanes mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+    inline Lanes minimum(Lanes a, Lanes b) { return _mm_min_ps(a, b); }
+    inline Lanes maximum(Lanes a, Lanes b) { return _mm_max_ps(a, b); }
+    inline LaneMask less(Lanes a, Lanes b) { return _mm_cmplt_ps(a, b); }
+    inline LaneMask lessEqual(Lanes a, Lanes b) { return _mm_cmple_ps(a, b); }
+    inline LaneMask greater(Lanes a, Lanes b) { return _mm_cmpgt_ps(a, b); }
+    inline LaneMask greaterEqual(Lanes a, Lanes b) { return _mm_cmpge_ps(a, b); }
+    inline LaneMask both(LaneMask a, LaneMask b) { return _mm_and_ps(a, b); }
+    inline Lanes select(LaneMask mask, Lanes a, Lanes b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+    inline unsigned int bits(LaneMask mask) { return static_cast<unsigned int>(_mm_movemask_ps(mask)); }
+#elif defined(SIMD_NEON)
+    typedef float32x4_t Lanes;
+    typedef uint32x4_t LaneMask;
+    inline Lanes load(const float* values) { return vld1q_f32(values); }
+    inline void store(float* values, Lanes lanes) { vst1q_f32(values, lanes); }
+    inline Lanes broadcast(float value) { return vdupq_n_f32(value); }
+    inline Lanes laneIndices()
+    {
+        const float indices[4] = { 0.f, 1.f, 2.f, 3.f };
+        return vld1q_f32(indices);
+    }
+    inline Lanes add(Lanes a, Lanes b) { return vaddq_f32(a, b); }
+    inline Lanes sub(Lanes a, Lanes b) { return vsubq_f32(a, b); }
+    inline Lanes mul(Lanes a, Lanes b) { return vmulq_f32(a, b); }
+    inline Lanes minimum(Lanes a, Lanes b) { return vminq_f32(a, b); }
+    inline Lanes maximum(Lanes a, Lanes b) { return vmaxq_f32(a, b); }
+    inline LaneMask less(Lanes a, Lanes b) { return vcltq_f32(a, b); }
+    inline LaneMask lessEqual(Lanes a, Lanes b) { return vcleq_f32(a, b); }
+    inline LaneMask greater(Lanes a, Lanes b) { return vcgtq_f32(a, b); }
+    inline LaneMask greaterEqual(Lanes a, Lanes b) { return vcgeq_f32(a, b); }
+    inline LaneMask both(LaneMask a, LaneMask b) { return vandq_u32(a, b); }
+    inline Lanes select(LaneMask mask, Lanes a, Lanes b) { return vbslq_f32(mask, a, b); }
+    inline unsigned int bits(LaneMask mask)
+    {
+        const uint32_t weights[4] = { 1, 2, 4, 8 };
+        return vaddvq_u32(vandq_u32(mask, vld1q_u32(weights)));
+    }
+#else
+    typedef float Lanes;
+    typedef bool LaneMask;
+    inline Lanes load(const float* values) { return *values; }
+    inline void store(float* values, Lanes lanes) { *values = lanes; }
+    inline Lanes broadcast(float value) { return value; }
+    inline Lanes laneIndices() { return 0.f; }
+    inline Lanes add(Lanes a, Lanes b) { return a + b; }
+    inline Lanes sub(Lanes a, Lanes b) { return a - b; }
+    inline Lanes mul(Lanes a, Lanes b) { return a * b; }
+    inline Lanes minimum(Lanes a, Lanes b) { return a < b ? a : b; }
+    inline Lanes maximum(Lanes a, Lanes b) { return a > b ? a : b; }
+    inline LaneMask less(Lanes a, Lanes b) { return a < b; }
+    inline LaneMask lessEqual(Lanes a, Lanes b) { return a <= b; }
+    inline LaneMask greater(Lanes a, Lanes b) { return a > b; }
+    inline LaneMask greaterEqual(Lanes a, Lanes b) { return a >= b; }
+    inline LaneMask both(LaneMask a, LaneMask b) { return a && b; }
+    inline Lanes select(LaneMask mask, Lanes a, Lanes b) { return mask ? a : b; }
+    inline unsigned int bits(LaneMask mask) { return mask ? 1u : 0u; }
+#endif
+
+    // the mask of the lanes of a step starting at first that are below count
+    inline unsigned int validLanes(size_t first, size_t count)
+    {
+        const size_t left = count - first;
+        return left >= SIMD_LANES ? (1u << SIMD_LANES) - 1u : (1u << left) - 1u;
+    }
+}
+#endif
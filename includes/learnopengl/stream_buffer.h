@@ -0,0 +1,206 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+// frames the GPU may still be reading while the CPU writes the next one
+#define STREAM_BUFFER_FRAMES 3
+
+// what the stream cost since the last reset
+struct StreamBufferStats
+{
+    size_t uploadBytes = 0;
+    unsigned int uploads = 0;
+    unsigned int stalls = 0;          // writes that had to wait for the GPU to release a region
+    double stallMilliseconds = 0.0;
+    unsigned int orphans = 0;         // storage respecified by the fallback path, once per trip around the ring
+    unsigned int reallocations = 0;   // the ring was too small and grew
+
+    void reset()
+    {
+        *this = StreamBufferStats();
+    }
+
+    void print(std::ostream& out, const char* label) const
+    {
+        out << label << ": " << uploads << " uploads, " << uploadBytes / 1024 << " kB, "
+            << stalls << " stalls (" << stallMilliseconds << " ms), " << orphans << " orphans, "
+            << reallocations << " reallocations" << std::endl;
+    }
+};
+
+// A buffer for data that is rewritten every frame: vertices generated on the CPU, instance transforms and the like.
+// It is split into STREAM_BUFFER_FRAMES regions used round robin, so the CPU fills one region while the GPU still
+// draws from the others. With GL 4.4 the storage is mapped once, persistently, and a fence per region makes a write
+// wait only if the GPU is really still reading that region. Without it the storage is orphaned (glBufferData with no
+// data) each time the ring wraps back to its first region, which lets the driver hand out fresh memory instead of
+// stalling; the frames in between write to regions no pending draw reads.
+//
+// Data is valid for the frame it was written in: call write() for everything drawn this frame, issue the draws with
+// the returned offsets and call nextFrame() once they are all issued. A write that doesn't fit the region grows the
+// ring into a new buffer, so draw from each write before the next one or size frameBytes for the whole frame.
+class StreamBuffer
+{
+public:
+    unsigned int buffer = 0; // may change when the ring grows, bind it after writing
+    // changes whenever buffer is created, never the same for two buffers of any stream. A deleted buffer's
+    // name may be handed out again, so caches of what points at buffer compare this instead of the name.
+    unsigned int generation = 0;
+    StreamBufferStats stats;
+
+    StreamBuffer(GLenum target = GL_ARRAY_BUFFER, size_t frameBytes = 64 * 1024) : target(target), regionSize(frameBytes)
+    {
+    }
+
+    // the buffer owns a GL object and a mapping, it is neither copied nor deleted on destruction
+    // (which may happen after the context is gone), call release()
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    // copies bytes into the current frame's region and returns their offset into buffer
+    size_t write(const void* data, size_t bytes, size_t alignment = 16)
+    {
+        size_t offset = (head + alignment - 1) / alignment * alignment;
+        if (buffer == 0 || offset + bytes > regionSize)
+        {
+            if (buffer != 0)
+                stats.reallocations++;
+            // regions stay a multiple of the alignment so offsets into later regions keep it as well
+            const size_t grown = std::max(regionSize, (offset + bytes) * 2);
+            allocate((grown + alignment - 1) / alignment * alignment);
+            offset = 0;
+        }
+        if (head == 0)
+            beginRegion();
+
+        const size_t position = region * regionSize + offset;
+        if (mapped)
+            std::memcpy(mapped + position, data, bytes);
+        else
+        {
+            glBindBuffer(target, buffer);
+            glBufferSubData(target, position, bytes, data);
+        }
+        head = offset + bytes;
+        stats.uploads++;
+        stats.uploadBytes += bytes;
+        return position;
+    }
+
+    // fences the region written this frame and moves on to the next one
+    void nextFrame()
+    {
+        if (buffer == 0 || head == 0)
+            return;
+        if (mapped)
+        {
+            if (fences[region])
+                glDeleteSync(fences[region]);
+            fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        region = (region + 1) % STREAM_BUFFER_FRAMES;
+        if (region == 0)
+            wrapped = true;
+        head = 0;
+    }
+
+    bool isPersistent() const
+    {
+        return mapped != nullptr;
+    }
+
+    void release()
+    {
+        for (GLsync& fence : fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+            fence = nullptr;
+        }
+        if (buffer != 0)
+        {
+            if (mapped)
+            {
+                glBindBuffer(target, buffer);
+                glUnmapBuffer(target);
+            }
+            glDeleteBuffers(1, &buffer);
+        }
+        buffer = 0;
+        mapped = nullptr;
+        region = 0;
+        head = 0;
+        wrapped = false;
+    }
+
+private:
+    GLenum target;
+    size_t regionSize;          // bytes per frame
+    unsigned int region = 0;    // region written this frame
+    size_t head = 0;            // bytes written into it so far
+    bool wrapped = false;       // back at the first region with the earlier frames' draws possibly still pending
+    char* mapped = nullptr;     // persistent mapping of the whole buffer
+    GLsync fences[STREAM_BUFFER_FRAMES] = {};
+
+    void allocate(size_t frameBytes)
+    {
+        // the old buffer is only deleted by name, the GL keeps its storage alive until pending draws are done
+        release();
+        regionSize = frameBytes;
+        const size_t totalBytes = regionSize * STREAM_BUFFER_FRAMES;
+        static unsigned int generations = 0;
+        generation = ++generations;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(target, buffer);
+        if (GLAD_GL_VERSION_4_4)
+        {
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(target, totalBytes, nullptr, flags);
+            mapped = static_cast<char*>(glMapBufferRange(target, 0, totalBytes, flags));
+            if (mapped)
+                return;
+            // immutable storage can't be respecified, the fallback needs a fresh buffer
+            glDeleteBuffers(1, &buffer);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(target, buffer);
+        }
+        glBufferData(target, totalBytes, nullptr, GL_STREAM_DRAW);
+    }
+
+    // makes the current region writable: waits for its fence, or orphans the storage on the fallback path
+    void beginRegion()
+    {
+        if (!mapped)
+        {
+            // the other regions have not been written since the storage was last specified
+            if (!wrapped)
+                return;
+            glBindBuffer(target, buffer);
+            glBufferData(target, regionSize * STREAM_BUFFER_FRAMES, nullptr, GL_STREAM_DRAW);
+            stats.orphans++;
+            wrapped = false;
+            return;
+        }
+        GLsync& fence = fences[region];
+        if (!fence)
+            return;
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            // the GPU is still reading what was written STREAM_BUFFER_FRAMES frames ago
+            const auto start = std::chrono::steady_clock::now();
+            while (result == GL_TIMEOUT_EXPIRED)
+                result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            stats.stalls++;
+            stats.stallMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+};
+#endif
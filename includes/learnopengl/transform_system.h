@@ -0,0 +1,236 @@
+#ifndef TRANSFORM_SYSTEM_H
+#define TRANSFORM_SYSTEM_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/job_system.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+// handle of a node, stays valid while the system reorders its arrays
+typedef uint32_t TransformHandle;
+
+// A transform hierarchy kept as parallel arrays instead of a tree of objects: local position, rotation and
+// scale, parent index, dirty flag and world matrix of every node, ordered by depth so that every parent comes
+// before its children. update() walks the arrays level by level, front to back, computing the world matrix of
+// each node whose local transform or whose parent's world matrix changed. Within a level no node depends on
+// another, so a level can be split over the threads of a JobSystem.
+//
+// The local matrix follows Transform in entity.h: translation * rotation (Y * X * Z euler angles, in degrees)
+// * scale, so both give the same world matrices for the same hierarchy.
+class TransformSystem
+{
+public:
+    static constexpr uint32_t NO_PARENT = ~0u;
+
+    // adds a node below parent (NO_PARENT for a root), it starts dirty with an identity local transform
+    TransformHandle add(TransformHandle parent = NO_PARENT)
+    {
+        const TransformHandle handle = static_cast<TransformHandle>(indexOfHandle.size());
+        const uint32_t parentIndex = parent == NO_PARENT ? NO_PARENT : indexOfHandle[parent];
+        const uint32_t index = static_cast<uint32_t>(parents.size());
+        positions.push_back(glm::vec3(0.0f));
+        rotations.push_back(glm::vec3(0.0f));
+        scales.push_back(glm::vec3(1.0f));
+        parents.push_back(parentIndex);
+        depths.push_back(parentIndex == NO_PARENT ? 0 : depths[parentIndex] + 1);
+        dirty.push_back(1);
+        changed.push_back(0);
+        worlds.push_back(glm::mat4(1.0f));
+        handleOfIndex.push_back(handle);
+        indexOfHandle.push_back(index);
+        // a node appended after deeper ones breaks the order, it is restored before the next update
+        sorted = sorted && (index == 0 || depths[index - 1] <= depths[index]);
+        levelsValid = false;
+        return handle;
+    }
+
+    size_t size() const
+    {
+        return parents.size();
+    }
+
+    void reserve(size_t count)
+    {
+        positions.reserve(count);
+        rotations.reserve(count);
+        scales.reserve(count);
+        parents.reserve(count);
+        depths.reserve(count);
+        dirty.reserve(count);
+        changed.reserve(count);
+        worlds.reserve(count);
+        handleOfIndex.reserve(count);
+        indexOfHandle.reserve(count);
+    }
+
+    void setLocalPosition(TransformHandle node, const glm::vec3& position)
+    {
+        const uint32_t index = indexOfHandle[node];
+        positions[index] = position;
+        dirty[index] = 1;
+    }
+
+    void setLocalRotation(TransformHandle node, const glm::vec3& eulerDegrees)
+    {
+        const uint32_t index = indexOfHandle[node];
+        rotations[index] = eulerDegrees;
+        dirty[index] = 1;
+    }
+
+    void setLocalScale(TransformHandle node, const glm::vec3& scale)
+    {
+        const uint32_t index = indexOfHandle[node];
+        scales[index] = scale;
+        dirty[index] = 1;
+    }
+
+    const glm::vec3& getLocalPosition(TransformHandle node) const
+    {
+        return positions[indexOfHandle[node]];
+    }
+
+    // world matrix as of the last update()
+    const glm::mat4& getModelMatrix(TransformHandle node) const
+    {
+        return worlds[indexOfHandle[node]];
+    }
+
+    // world matrices in update order, together with handleAt() for code that walks every node
+    const std::vector<glm::mat4>& modelMatrices() const
+    {
+        return worlds;
+    }
+
+    TransformHandle handleAt(size_t index) const
+    {
+        return handleOfIndex[index];
+    }
+
+    // recomputes the world matrices that are out of date, spread over jobs when given
+    void update(JobSystem* jobs = nullptr)
+    {
+        if (!sorted)
+            sortByDepth();
+        if (!levelsValid)
+            findLevels();
+        for (size_t level = 0; level + 1 < levelStarts.size(); level++)
+        {
+            const size_t begin = levelStarts[level];
+            const size_t end = levelStarts[level + 1];
+            if (jobs)
+                jobs->parallelFor(end - begin, 4096, [&](size_t first, size_t last) { updateRange(begin + first, begin + last); });
+            else
+                updateRange(begin, end);
+        }
+    }
+
+    // marks every node dirty, the next update recomputes them all
+    void invalidate()
+    {
+        std::fill(dirty.begin(), dirty.end(), 1);
+    }
+
+private:
+    // per node, indexed in depth order
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> rotations; // euler angles in degrees
+    std::vector<glm::vec3> scales;
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> depths;
+    std::vector<uint8_t> dirty;       // local transform changed since the last update
+    std::vector<uint8_t> changed;     // world matrix recomputed by the current update, read by the children
+    std::vector<glm::mat4> worlds;
+
+    std::vector<TransformHandle> handleOfIndex;
+    std::vector<uint32_t> indexOfHandle;
+    std::vector<size_t> levelStarts;  // first index of every depth, then size()
+    bool sorted = true;
+    bool levelsValid = false;
+
+    void updateRange(size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            const uint32_t parent = parents[i];
+            if (!dirty[i] && (parent == NO_PARENT || !changed[parent]))
+            {
+                changed[i] = 0;
+                continue;
+            }
+            const glm::mat4 local = localMatrix(positions[i], rotations[i], scales[i]);
+            worlds[i] = parent == NO_PARENT ? local : worlds[parent] * local;
+            dirty[i] = 0;
+            changed[i] = 1;
+        }
+    }
+
+    // translation * Ry * Rx * Rz * scale written out, the same matrix the glm::rotate chain of Transform builds
+    static glm::mat4 localMatrix(const glm::vec3& position, const glm::vec3& eulerDegrees, const glm::vec3& scale)
+    {
+        const glm::vec3 angles = glm::radians(eulerDegrees);
+        const float cx = std::cos(angles.x), sx = std::sin(angles.x);
+        const float cy = std::cos(angles.y), sy = std::sin(angles.y);
+        const float cz = std::cos(angles.z), sz = std::sin(angles.z);
+        glm::mat4 m(1.0f);
+        m[0] = glm::vec4(cy * cz + sy * sx * sz, cx * sz, -sy * cz + cy * sx * sz, 0.0f) * scale.x;
+        m[1] = glm::vec4(-cy * sz + sy * sx * cz, cx * cz, sy * sz + cy * sx * cz, 0.0f) * scale.y;
+        m[2] = glm::vec4(sy * cx, -sx, cy * cx, 0.0f) * scale.z;
+        m[3] = glm::vec4(position, 1.0f);
+        return m;
+    }
+
+    // stable sort of every array by depth, parents keep coming before their children
+    void sortByDepth()
+    {
+        std::vector<uint32_t> order(parents.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+        std::vector<uint32_t> newIndex(order.size());
+        for (uint32_t i = 0; i < order.size(); i++)
+            newIndex[order[i]] = i;
+
+        reorder(positions, order);
+        reorder(rotations, order);
+        reorder(scales, order);
+        reorder(depths, order);
+        reorder(dirty, order);
+        reorder(changed, order);
+        reorder(worlds, order);
+        reorder(handleOfIndex, order);
+        reorder(parents, order);
+        for (uint32_t& parent : parents)
+            if (parent != NO_PARENT)
+                parent = newIndex[parent];
+        for (uint32_t i = 0; i < handleOfIndex.size(); i++)
+            indexOfHandle[handleOfIndex[i]] = i;
+        sorted = true;
+    }
+
+    template <typename T>
+    static void reorder(std::vector<T>& values, const std::vector<uint32_t>& order)
+    {
+        std::vector<T> result;
+        result.reserve(values.size());
+        for (uint32_t index : order)
+            result.push_back(values[index]);
+        values.swap(result);
+    }
+
+    void findLevels()
+    {
+        levelStarts.clear();
+        for (size_t i = 0; i < depths.size(); i++)
+        {
+            if (i == 0 || depths[i] != depths[i - 1])
+                levelStarts.push_back(i);
+        }
+        levelStarts.push_back(depths.size());
+        levelsValid = true;
+    }
+};
+#endif
@@ -0,0 +1,189 @@
+#ifndef UNIFORM_TABLE_H
+#define UNIFORM_TABLE_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// 32-bit FNV-1a, constexpr so names known at compile time are hashed by the compiler
+constexpr unsigned int uniformHash(const char* name)
+{
+    unsigned int hash = 2166136261u;
+    while (*name)
+    {
+        hash ^= static_cast<unsigned char>(*name++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// a uniform name together with its hash. Declare the names used every frame as constants,
+//     static constexpr UniformName modelUniform("model");
+// so the hash is computed once (at compile time) instead of on every set call.
+struct UniformName
+{
+    const char* name;
+    unsigned int hash;
+
+    constexpr UniformName(const char* name) : name(name), hash(uniformHash(name)) {}
+    UniformName(const std::string& name) : name(name.c_str()), hash(uniformHash(name.c_str())) {}
+};
+
+// how the set calls of a shader were served since the last reset
+struct UniformStats
+{
+    unsigned int hits = 0;     // name found in the table
+    unsigned int misses = 0;   // name is not an active uniform of the program, nothing was sent
+    unsigned int skipped = 0;  // value matched the shadow copy, the glUniform call was skipped
+    unsigned int uploads = 0;  // glUniform calls actually made
+
+    void reset()
+    {
+        *this = UniformStats();
+    }
+};
+
+// Locations of all active uniforms of a linked program, filled once with glGetActiveUniform, and a
+// shadow copy of the last value written to each of them. Lookups are a binary search on the name
+// hash instead of a glGetUniformLocation string lookup in the driver.
+class UniformTable
+{
+public:
+    struct Entry
+    {
+        unsigned int hash;
+        GLint location;
+        std::string name;
+        bool hasValue = false;   // false until the first write, the shadow is meaningless before that
+        float value[16];         // large enough for a mat4, ints are stored bit for bit
+        int alias = -1;          // index of the entry holding the shadow when this name is another name for it
+    };
+
+    UniformStats stats;
+
+    // enumerates the active uniforms of program, has to run after a successful link
+    void reflect(GLuint program)
+    {
+        entries.clear();
+        std::vector<std::string> arrayNames;
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> buffer(std::max(maxLength, 1) + 16);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program, static_cast<GLuint>(i), static_cast<GLsizei>(buffer.size()), &length, &size, &type, &buffer[0]);
+            std::string name(&buffer[0], length);
+            GLint location = glGetUniformLocation(program, name.c_str());
+            if (location < 0)
+                continue; // members of uniform blocks have no location
+            addEntry(name, location);
+
+            // arrays are reported once as "name[0]", register every element and the bare name as well
+            const size_t bracket = name.rfind("[0]");
+            if (bracket != std::string::npos && bracket + 3 == name.size())
+            {
+                const std::string base = name.substr(0, bracket);
+                addEntry(base, location);
+                arrayNames.push_back(base);
+                for (GLint element = 1; element < size; element++)
+                {
+                    const std::string elementName = base + "[" + std::to_string(element) + "]";
+                    addEntry(elementName, glGetUniformLocation(program, elementName.c_str()));
+                }
+            }
+        }
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.hash < b.hash; });
+
+        // the bare name writes the same location as "name[0]", both have to compare against one shadow
+        for (const std::string& base : arrayNames)
+        {
+            const int index = indexOf(base);
+            if (index >= 0)
+                entries[index].alias = indexOf(base + "[0]");
+        }
+    }
+
+    // location of an active uniform, -1 if the program doesn't use it
+    GLint location(const UniformName& name) const
+    {
+        const int index = indexOf(name);
+        return index >= 0 ? entries[index].location : -1;
+    }
+
+    // position of an active uniform in the table, -1 if the program doesn't use it. Indices stay valid
+    // for the lifetime of the program, so hot paths can resolve them once and use the index overload of update.
+    int indexOf(const UniformName& name) const
+    {
+        auto it = std::lower_bound(entries.begin(), entries.end(), name.hash, [](const Entry& e, unsigned int hash) { return e.hash < hash; });
+        // different names can share a hash, the string only has to be compared on a hash match
+        for (; it != entries.end() && it->hash == name.hash; ++it)
+        {
+            if (it->name == name.name)
+                return static_cast<int>(it - entries.begin());
+        }
+        return -1;
+    }
+
+    // Looks name up and compares value with the shadow copy. Returns true, with the location, when the caller
+    // has to issue the glUniform call; false when the uniform is inactive or already holds this value.
+    bool update(const UniformName& name, const void* value, size_t bytes, GLint& location)
+    {
+        return update(indexOf(name), value, bytes, location);
+    }
+
+    // same as above for an index returned by indexOf
+    bool update(int index, const void* value, size_t bytes, GLint& location)
+    {
+        if (index < 0)
+        {
+            stats.misses++;
+            return false;
+        }
+        Entry& entry = entries[index].alias >= 0 ? entries[entries[index].alias] : entries[index];
+        stats.hits++;
+        if (entry.hasValue && std::memcmp(entry.value, value, bytes) == 0)
+        {
+            stats.skipped++;
+            return false;
+        }
+        std::memcpy(entry.value, value, bytes);
+        entry.hasValue = true;
+        stats.uploads++;
+        location = entry.location;
+        return true;
+    }
+
+    // forgets the shadow values, for when uniforms were written behind the table's back (e.g. a relink)
+    void invalidate()
+    {
+        for (Entry& entry : entries)
+            entry.hasValue = false;
+    }
+
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+private:
+    std::vector<Entry> entries; // sorted by hash
+
+    void addEntry(const std::string& name, GLint location)
+    {
+        if (location < 0)
+            return;
+        Entry entry;
+        entry.hash = uniformHash(name.c_str());
+        entry.location = location;
+        entry.name = name;
+        entries.push_back(entry);
+    }
+};
+#endif
@@ -0,0 +1,205 @@
+#ifndef VISIBILITY_H
+#define VISIBILITY_H
+
+#include <learnopengl/entity.h>
+#include <learnopengl/indirect_renderer.h>
+#include <learnopengl/job_system.h>
+#include <learnopengl/lod.h>
+#include <learnopengl/render_queue.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// entities tested by one job, fixed so the partitions don't depend on the thread count
+#define VISIBILITY_PARTITION_SIZE 512
+
+// The visibility half of Entity::addSelfAndChild and its siblings, separated from the GL calls. The tree is
+// flattened once in the order those functions visit it, then build tests fixed size partitions of it against
+// the frustum, picks their levels of detail and merges the partitions in order. The draw list is the same
+// whatever the number of threads, and the GL thread only has to walk it.
+//
+// The tests are the coherent ones of BoundingVolume. Before the partitions, the subtree boxes of the entities
+// with children are tested top down: a subtree outside the frustum is skipped whole, and the planes a subtree
+// box is fully inside of aren't tested again below it.
+class DrawList
+{
+public:
+    struct Item
+    {
+        Entity* entity = nullptr;
+        unsigned int lod = 0;
+    };
+
+    // visible entities of the last build, in the order drawSelfAndChild would draw them
+    std::vector<Item> items;
+    LodStats stats;
+    CullingStats culling;
+
+    // flattens the tree below root, needed again whenever entities are added or removed
+    void setScene(Entity& root)
+    {
+        entities.clear();
+        parents.clear();
+        collect(root, -1);
+        subtreePlanes.assign(entities.size(), BoundingVolume::allPlanes);
+        parentNodes.clear();
+        for (size_t i = 0; i < entities.size(); i++)
+        {
+            if (!entities[i]->children.empty())
+                parentNodes.push_back(static_cast<uint32_t>(i));
+        }
+        partitions.resize((entities.size() + VISIBILITY_PARTITION_SIZE - 1) / VISIBILITY_PARTITION_SIZE);
+    }
+
+    size_t entityCount() const
+    {
+        return entities.size();
+    }
+
+    // replaces items with the entities on the frustum, the transforms have to be up to date
+    void build(const Frustum& frustum, const LodView& view, JobSystem* jobs = nullptr)
+    {
+        currentFrustum = &frustum;
+        currentView = &view;
+        culling.reset();
+        cullSubtrees();
+        // captures nothing but this, so the std::function doesn't allocate
+        const auto cullPartitions = [this](size_t first, size_t last)
+        {
+            for (size_t partition = first; partition < last; partition++)
+                cullPartition(partition);
+        };
+        if (jobs)
+            jobs->parallelFor(partitions.size(), 1, cullPartitions);
+        else
+            cullPartitions(0, partitions.size());
+
+        size_t count = 0;
+        for (const Partition& partition : partitions)
+            count += partition.items.size();
+        items.resize(count);
+        stats.reset();
+        auto out = items.begin();
+        for (const Partition& partition : partitions)
+        {
+            out = std::copy(partition.items.begin(), partition.items.end(), out);
+            culling.add(partition.culling);
+            stats.triangles += partition.stats.triangles;
+            for (unsigned int lod = 0; lod < MAX_MESH_LODS; lod++)
+                stats.drawsPerLod[lod] += partition.stats.drawsPerLod[lod];
+        }
+    }
+
+    // one draw per item with the model matrix set on shader
+    void draw(Shader& shader) const
+    {
+        static constexpr UniformName modelUniform("model");
+        for (const Item& item : items)
+        {
+            shader.setMat4(modelUniform, item.entity->transform.getModelMatrix());
+            item.entity->pModel->Draw(shader, item.lod);
+        }
+    }
+
+    void submit(RenderQueue& queue, Shader& shader) const
+    {
+        for (const Item& item : items)
+        {
+            DrawPacket packet;
+            packet.model = item.entity->transform.getModelMatrix();
+            item.entity->pModel->Submit(queue, shader, packet, item.lod);
+        }
+    }
+
+    void add(IndirectRenderer& renderer) const
+    {
+        for (const Item& item : items)
+            renderer.add(*item.entity->pModel, item.lod, item.entity->transform.getModelMatrix());
+    }
+
+private:
+    // the output of one job, kept between frames so building doesn't allocate once the lists have grown
+    struct Partition
+    {
+        std::vector<Item> items;
+        LodStats stats;
+        CullingStats culling;
+    };
+
+    // set in subtreePlanes when the subtree box is outside the frustum
+    static constexpr unsigned char CULLED_SUBTREE = 0x80;
+
+    std::vector<Entity*> entities;
+    std::vector<int32_t> parents;         // index of the parent of every entity, -1 for the root
+    std::vector<uint32_t> parentNodes;    // the entities with children, parents before their children
+    std::vector<unsigned char> subtreePlanes; // planes left to test below every parent node, or CULLED_SUBTREE
+    std::vector<Partition> partitions;
+    const Frustum* currentFrustum = nullptr;
+    const LodView* currentView = nullptr;
+
+    void collect(Entity& entity, int32_t parent)
+    {
+        const int32_t index = static_cast<int32_t>(entities.size());
+        entities.push_back(&entity);
+        parents.push_back(parent);
+        for (auto&& child : entity.children)
+            collect(*child, index);
+    }
+
+    // the planes an entity starts with, those its parent's subtree box wasn't fully inside of
+    unsigned int inheritedPlanes(size_t index) const
+    {
+        return parents[index] < 0 ? BoundingVolume::allPlanes : subtreePlanes[parents[index]];
+    }
+
+    // tests the subtree boxes top down, on the calling thread: there are few of them and the partitions read the result
+    void cullSubtrees()
+    {
+        for (uint32_t index : parentNodes)
+        {
+            Entity& entity = *entities[index];
+            unsigned int planes = inheritedPlanes(index);
+            if (planes & CULLED_SUBTREE)
+                subtreePlanes[index] = CULLED_SUBTREE;
+            else if (!entity.subtreeAABB.isOnFrustum(*currentFrustum, planes, entity.subtreeCullPlane, culling))
+                subtreePlanes[index] = CULLED_SUBTREE;
+            else
+                subtreePlanes[index] = static_cast<unsigned char>(planes);
+        }
+    }
+
+    // each entity belongs to one partition, so writing its lod needs no lock
+    void cullPartition(size_t index)
+    {
+        Partition& partition = partitions[index];
+        partition.items.clear();
+        partition.stats.reset();
+        partition.culling.reset();
+        const size_t begin = index * VISIBILITY_PARTITION_SIZE;
+        const size_t end = std::min(begin + VISIBILITY_PARTITION_SIZE, entities.size());
+        for (size_t i = begin; i < end; i++)
+        {
+            Entity& entity = *entities[i];
+            partition.culling.entities++;
+            // a parent node starts from its own subtree box, which holds its volume
+            unsigned int planes = entity.children.empty() ? inheritedPlanes(i) : subtreePlanes[i];
+            if (planes & CULLED_SUBTREE)
+            {
+                partition.culling.culledBySubtree++;
+                continue;
+            }
+            if (!entity.boundingVolume->isOnFrustum(*currentFrustum, entity.transform, planes, entity.cullPlane, partition.culling))
+                continue;
+            const AABB globalAABB = entity.getGlobalAABB();
+            const float screenSize = projectedSphereSize(globalAABB.center, glm::length(globalAABB.extents),
+                                                         currentView->cameraPosition, currentView->fovY);
+            entity.lod = selectLod(entity.lod, entity.pModel->lodCount(), screenSize, currentView->settings);
+
+            partition.items.push_back({ &entity, entity.lod });
+            partition.stats.triangles += static_cast<unsigned int>(entity.pModel->triangleCount(entity.lod));
+            partition.stats.drawsPerLod[entity.lod]++;
+        }
+    }
+};
+#endif
@@ -0,0 +1,587 @@
+#ifndef WORLD_STREAMING_H
+#define WORLD_STREAMING_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// square cell of the world grid on the xz plane
+struct CellCoord
+{
+    int x = 0;
+    int z = 0;
+
+    bool operator==(const CellCoord& other) const
+    {
+        return x == other.x && z == other.z;
+    }
+};
+
+// one object of a cell: the mesh and texture it uses and where it stands
+struct ManifestObject
+{
+    std::string mesh;
+    std::string texture;
+    glm::vec3 position{ 0.0f };
+    float yaw = 0.0f; // degrees around +y
+    float scale = 1.0f;
+};
+
+// what a cell holds, known without loading it, so the streamer can budget memory before asking for it
+struct CellManifest
+{
+    CellCoord coord;
+    size_t estimatedBytes = 0;
+    std::vector<ManifestObject> objects;
+};
+
+// The cells of a world and their contents. Saved as text, one line per cell and per object:
+//
+//   cellsize 50
+//   cell <x> <z> <estimated bytes>
+//   object <mesh> <texture> <x> <y> <z> <yaw> <scale>
+//
+// objects belong to the cell above them, names can't contain spaces.
+class WorldManifest
+{
+public:
+    float cellSize = 50.0f;
+    std::vector<CellManifest> cells;
+
+    CellCoord cellAt(const glm::vec3& position) const
+    {
+        return { static_cast<int>(std::floor(position.x / cellSize)), static_cast<int>(std::floor(position.z / cellSize)) };
+    }
+
+    // index of the cell in cells, -1 if the world has none there
+    int indexOf(const CellCoord& coord) const
+    {
+        auto found = indexByKey.find(key(coord));
+        return found == indexByKey.end() ? -1 : static_cast<int>(found->second);
+    }
+
+    // adds a cell, replacing the one at the same coordinates
+    void add(CellManifest cell)
+    {
+        const int existing = indexOf(cell.coord);
+        if (existing >= 0)
+        {
+            cells[existing] = std::move(cell);
+            return;
+        }
+        indexByKey[key(cell.coord)] = cells.size();
+        cells.push_back(std::move(cell));
+    }
+
+    void clear()
+    {
+        cells.clear();
+        indexByKey.clear();
+    }
+
+    // distance on the xz plane from position to the nearest point of a cell, 0 inside it
+    float distanceTo(const CellCoord& coord, const glm::vec3& position) const
+    {
+        const glm::vec2 min(coord.x * cellSize, coord.z * cellSize);
+        const glm::vec2 point(position.x, position.z);
+        const glm::vec2 nearest = glm::clamp(point, min, min + glm::vec2(cellSize));
+        return glm::length(point - nearest);
+    }
+
+    void write(std::ostream& out) const
+    {
+        out << "cellsize " << cellSize << "\n";
+        for (const CellManifest& cell : cells)
+        {
+            out << "cell " << cell.coord.x << " " << cell.coord.z << " " << cell.estimatedBytes << "\n";
+            for (const ManifestObject& object : cell.objects)
+            {
+                out << "object " << object.mesh << " " << object.texture << " " << object.position.x << " " << object.position.y
+                    << " " << object.position.z << " " << object.yaw << " " << object.scale << "\n";
+            }
+        }
+    }
+
+    // replaces the cells with the ones read from in, false (and an error printed) if a line can't be parsed
+    bool read(std::istream& in)
+    {
+        clear();
+        std::string line;
+        CellManifest cell;
+        bool inCell = false;
+        unsigned int lineNumber = 0;
+        while (std::getline(in, line))
+        {
+            lineNumber++;
+            std::istringstream words(line);
+            std::string keyword;
+            if (!(words >> keyword))
+                continue;
+            bool parsed = false;
+            if (keyword == "cellsize")
+            {
+                parsed = static_cast<bool>(words >> cellSize) && cellSize > 0.0f;
+            }
+            else if (keyword == "cell")
+            {
+                if (inCell)
+                    add(std::move(cell));
+                cell = CellManifest();
+                parsed = static_cast<bool>(words >> cell.coord.x >> cell.coord.z >> cell.estimatedBytes);
+                inCell = parsed;
+            }
+            else if (keyword == "object" && inCell)
+            {
+                ManifestObject object;
+                parsed = static_cast<bool>(words >> object.mesh >> object.texture >> object.position.x >> object.position.y
+                                                 >> object.position.z >> object.yaw >> object.scale);
+                cell.objects.push_back(object);
+            }
+            if (!parsed)
+            {
+                std::cout << "ERROR::WORLD_MANIFEST::PARSE line " << lineNumber << ": " << line << std::endl;
+                clear();
+                return false;
+            }
+        }
+        if (inCell)
+            add(std::move(cell));
+        return true;
+    }
+
+    bool save(const std::string& path) const
+    {
+        std::ofstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::WORLD_MANIFEST::FILE_NOT_WRITTEN " << path << std::endl;
+            return false;
+        }
+        write(file);
+        return static_cast<bool>(file);
+    }
+
+    bool load(const std::string& path)
+    {
+        std::ifstream file(path);
+        if (!file)
+        {
+            std::cout << "ERROR::WORLD_MANIFEST::FILE_NOT_SUCCESSFULLY_READ " << path << std::endl;
+            return false;
+        }
+        return read(file);
+    }
+
+private:
+    std::unordered_map<uint64_t, size_t> indexByKey;
+
+    static uint64_t key(const CellCoord& coord)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(coord.x)) << 32) | static_cast<uint32_t>(coord.z);
+    }
+};
+
+// what a CellLoader read for one cell, kept by the streamer until the cell is unloaded
+struct CellPayload
+{
+    virtual ~CellPayload() = default;
+
+    // memory the cell takes now, counted against the budget instead of the manifest's estimate once loaded
+    virtual size_t bytes() const = 0;
+};
+
+// Does the work of loading a cell in two halves. load runs on the streaming thread and must not touch GL or
+// anything finish and unload change: it reads the files and decodes them. finish and unload run on the thread
+// calling WorldStreamer::update, the GL thread, and turn the payload into buffers, textures and entities and
+// back. load may run while the other two do, for a different cell.
+class CellLoader
+{
+public:
+    virtual ~CellLoader() = default;
+
+    virtual std::unique_ptr<CellPayload> load(const CellManifest& cell) = 0;
+
+    // does as much of the remaining work as fits before deadline and returns whether the cell is complete,
+    // it's called again on later frames until it is
+    virtual bool finish(const CellManifest& cell, CellPayload& payload, std::chrono::steady_clock::time_point deadline) = 0;
+
+    // releases what finish made, also for a cell whose finish didn't complete
+    virtual void unload(const CellManifest& cell, CellPayload& payload) = 0;
+};
+
+struct StreamingSettings
+{
+    float loadRadius = 150.0f;     // cells closer than this to the camera are loaded
+    float unloadRadius = 200.0f;   // and unloaded once farther than this, the gap keeps a cell on the border from flickering
+    size_t memoryBudget = 256u << 20; // bytes of every cell queued, loading or loaded together
+    double frameMilliseconds = 2.0;   // time update may spend finishing cells each frame
+};
+
+// counters since the last reset, cells are counted when they complete a transition
+struct StreamingStats
+{
+    unsigned int frames = 0;
+    unsigned int requested = 0;       // cells queued for loading
+    unsigned int loaded = 0;          // cells finished and resident
+    unsigned int unloaded = 0;
+    unsigned int dropped = 0;         // loads thrown away because the camera left before they were finished
+    unsigned int evicted = 0;         // resident cells unloaded early to make room for nearer ones
+    unsigned int budgetLimited = 0;   // frames where a wanted cell didn't fit in the memory budget
+    unsigned int framesOverBudget = 0; // frames where update took longer than frameMilliseconds
+    double updateMilliseconds = 0.0;
+    double maxUpdateMilliseconds = 0.0;
+    size_t peakBytes = 0;
+
+    void reset()
+    {
+        *this = StreamingStats();
+    }
+
+    void print(std::ostream& out, const char* label) const
+    {
+        out << label << ": " << requested << " requested, " << loaded << " loaded, " << unloaded << " unloaded, " << dropped
+            << " dropped, " << evicted << " evicted, " << budgetLimited << " frames at the memory budget, update "
+            << updateMilliseconds / std::max(1u, frames) << " ms average, " << maxUpdateMilliseconds << " ms max, "
+            << framesOverBudget << " frames over the time budget, peak " << peakBytes / 1024 << " kB" << std::endl;
+    }
+};
+
+// Keeps the cells around the camera loaded. Every update the cells within loadRadius that aren't loaded are
+// queued nearest first, as long as the memory budget allows, and a thread of the streamer loads them one after
+// the other through the CellLoader. Loaded cells are finished nearest first on the calling thread for at most
+// frameMilliseconds per frame, and cells beyond unloadRadius are unloaded. update, the destructor and unloadAll
+// have to be called from the thread finish may use GL on.
+class WorldStreamer
+{
+public:
+    StreamingSettings settings;
+    StreamingStats stats;
+
+    WorldStreamer(const WorldManifest& manifest, CellLoader& loader, const StreamingSettings& settings = StreamingSettings())
+        : settings(settings), manifest(manifest), loader(loader), cells(manifest.cells.size())
+    {
+        thread = std::thread([this]() { streamingLoop(); });
+    }
+
+    ~WorldStreamer()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        thread.join();
+        unloadAll();
+    }
+
+    WorldStreamer(const WorldStreamer&) = delete;
+    WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+    void update(const glm::vec3& cameraPosition)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(settings.frameMilliseconds));
+        stats.frames++;
+        camera = cameraPosition;
+        for (size_t index : active)
+            cells[index].distance = manifest.distanceTo(manifest.cells[index].coord, camera);
+
+        unloadFarCells();
+        receiveLoads();
+        requestNearCells();
+        finishCells(deadline);
+
+        size_t bytes = 0;
+        for (size_t index : active)
+            bytes += cells[index].bytes;
+        stats.peakBytes = std::max(stats.peakBytes, bytes);
+        const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats.updateMilliseconds += milliseconds;
+        stats.maxUpdateMilliseconds = std::max(stats.maxUpdateMilliseconds, milliseconds);
+        if (milliseconds > settings.frameMilliseconds)
+            stats.framesOverBudget++;
+    }
+
+    // unloads every cell and cancels the queue, a load already on the streaming thread finishes as usual
+    void unloadAll()
+    {
+        for (size_t i = active.size(); i-- > 0;)
+            unload(active[i]);
+    }
+
+    bool isResident(const CellCoord& coord) const
+    {
+        const int index = manifest.indexOf(coord);
+        return index >= 0 && cells[index].state == CELL_RESIDENT;
+    }
+
+    size_t residentCount() const
+    {
+        size_t count = 0;
+        for (size_t index : active)
+            count += cells[index].state == CELL_RESIDENT ? 1 : 0;
+        return count;
+    }
+
+    // bytes of every cell queued, loading or loaded
+    size_t bytes() const
+    {
+        size_t total = 0;
+        for (size_t index : active)
+            total += cells[index].bytes;
+        return total;
+    }
+
+    // whether every cell is either resident or unloaded
+    bool idle() const
+    {
+        for (size_t index : active)
+        {
+            if (cells[index].state != CELL_RESIDENT)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    enum CellState
+    {
+        CELL_UNLOADED,
+        CELL_QUEUED,    // waiting for the streaming thread
+        CELL_LOADING,   // on the streaming thread
+        CELL_FINISHING, // loaded, finish not complete yet
+        CELL_RESIDENT
+    };
+
+    struct Cell
+    {
+        CellState state = CELL_UNLOADED;
+        size_t bytes = 0;    // estimate until loaded, then what the payload reports
+        float distance = 0.0f;
+        std::unique_ptr<CellPayload> payload;
+    };
+
+    const WorldManifest& manifest;
+    CellLoader& loader;
+    std::vector<Cell> cells;      // one per cell of the manifest
+    std::vector<size_t> active;   // the cells that aren't unloaded
+    std::vector<std::pair<float, size_t>> wanted; // scratch, cells within loadRadius by distance
+    glm::vec3 camera{ 0.0f };
+
+    // shared with the streaming thread
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::pair<float, size_t>> queue; // distance and index, the nearest is loaded next
+    std::vector<std::pair<size_t, std::unique_ptr<CellPayload>>> completed;
+    bool stopping = false;
+
+    void streamingLoop()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping)
+                return;
+            const auto nearest = std::min_element(queue.begin(), queue.end());
+            const size_t index = nearest->second;
+            queue.erase(nearest);
+            lock.unlock();
+            std::unique_ptr<CellPayload> payload = loader.load(manifest.cells[index]);
+            lock.lock();
+            completed.emplace_back(index, std::move(payload));
+        }
+    }
+
+    void setState(size_t index, CellState state)
+    {
+        Cell& cell = cells[index];
+        if (cell.state == CELL_UNLOADED && state != CELL_UNLOADED)
+            active.push_back(index);
+        else if (cell.state != CELL_UNLOADED && state == CELL_UNLOADED)
+            active.erase(std::find(active.begin(), active.end(), index));
+        cell.state = state;
+    }
+
+    // unloads or cancels index, false for a cell on the streaming thread: it's dropped once it arrives
+    bool unload(size_t index)
+    {
+        Cell& cell = cells[index];
+        if (cell.state == CELL_LOADING)
+            return false;
+        if (cell.state == CELL_QUEUED)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto entry = std::find_if(queue.begin(), queue.end(), [index](const std::pair<float, size_t>& queued) { return queued.second == index; });
+            // not in the queue any more, the streaming thread took it
+            if (entry == queue.end())
+            {
+                cell.state = CELL_LOADING;
+                return false;
+            }
+            queue.erase(entry);
+        }
+        if (cell.state == CELL_RESIDENT)
+            stats.unloaded++;
+        else if (cell.state == CELL_FINISHING)
+            stats.dropped++;
+        if (cell.payload)
+            loader.unload(manifest.cells[index], *cell.payload);
+        cell.payload.reset();
+        cell.bytes = 0;
+        setState(index, CELL_UNLOADED);
+        return true;
+    }
+
+    void unloadFarCells()
+    {
+        for (size_t i = active.size(); i-- > 0;)
+        {
+            const size_t index = active[i];
+            if (cells[index].distance > settings.unloadRadius)
+                unload(index);
+        }
+    }
+
+    // takes the cells the streaming thread is done with, drops those the camera left meanwhile
+    void receiveLoads()
+    {
+        std::vector<std::pair<size_t, std::unique_ptr<CellPayload>>> arrived;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            arrived.swap(completed);
+            // the queue is picked from by distance, refresh it
+            for (std::pair<float, size_t>& entry : queue)
+                entry.first = cells[entry.second].distance;
+        }
+        for (auto& entry : arrived)
+        {
+            Cell& cell = cells[entry.first];
+            cell.payload = std::move(entry.second);
+            if (!cell.payload)
+            {
+                // resident and empty, so it isn't asked for again while the camera stays around
+                const CellCoord& coord = manifest.cells[entry.first].coord;
+                std::cout << "ERROR::WORLD_STREAMING::CELL_NOT_LOADED " << coord.x << " " << coord.z << std::endl;
+                cell.bytes = 0;
+                cell.state = CELL_RESIDENT;
+                continue;
+            }
+            cell.bytes = cell.payload->bytes();
+            cell.state = CELL_FINISHING;
+            if (cell.distance > settings.unloadRadius)
+                unload(entry.first);
+        }
+    }
+
+    // queues the unloaded cells within loadRadius nearest first, making room by evicting cells farther away
+    void requestNearCells()
+    {
+        wanted.clear();
+        const CellCoord center = manifest.cellAt(camera);
+        const int reach = static_cast<int>(std::ceil(settings.loadRadius / manifest.cellSize));
+        for (int z = center.z - reach; z <= center.z + reach; z++)
+        {
+            for (int x = center.x - reach; x <= center.x + reach; x++)
+            {
+                const int index = manifest.indexOf({ x, z });
+                if (index < 0 || cells[index].state != CELL_UNLOADED)
+                    continue;
+                const float distance = manifest.distanceTo({ x, z }, camera);
+                if (distance <= settings.loadRadius)
+                    wanted.emplace_back(distance, static_cast<size_t>(index));
+            }
+        }
+        std::sort(wanted.begin(), wanted.end());
+
+        size_t used = bytes();
+        bool limited = false;
+        for (const std::pair<float, size_t>& entry : wanted)
+        {
+            const size_t needed = manifest.cells[entry.second].estimatedBytes;
+            while (used + needed > settings.memoryBudget && evictFarthest(entry.first, used))
+                ;
+            if (used + needed > settings.memoryBudget)
+            {
+                limited = true;
+                break;
+            }
+            Cell& cell = cells[entry.second];
+            cell.distance = entry.first;
+            cell.bytes = needed;
+            used += needed;
+            setState(entry.second, CELL_QUEUED);
+            stats.requested++;
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.emplace_back(entry.first, entry.second);
+        }
+        if (limited)
+            stats.budgetLimited++;
+        wake.notify_one();
+    }
+
+    // unloads the farthest cell that is farther than distance, subtracting its bytes from used. False when there
+    // is none left, a cell found on the streaming thread counts as tried.
+    bool evictFarthest(float distance, size_t& used)
+    {
+        size_t farthest = cells.size();
+        for (size_t index : active)
+        {
+            const Cell& cell = cells[index];
+            if (cell.state != CELL_LOADING && cell.distance > distance && (farthest == cells.size() || cell.distance > cells[farthest].distance))
+                farthest = index;
+        }
+        if (farthest == cells.size())
+            return false;
+        const size_t bytes = cells[farthest].bytes;
+        const bool resident = cells[farthest].state == CELL_RESIDENT;
+        if (unload(farthest))
+        {
+            used -= bytes;
+            stats.evicted += resident ? 1 : 0;
+        }
+        return true;
+    }
+
+    // finishes loaded cells nearest first until deadline, at least one step per frame so a slow cell still completes
+    void finishCells(std::chrono::steady_clock::time_point deadline)
+    {
+        bool first = true;
+        while (first || std::chrono::steady_clock::now() < deadline)
+        {
+            size_t nearest = cells.size();
+            for (size_t index : active)
+            {
+                if (cells[index].state == CELL_FINISHING && (nearest == cells.size() || cells[index].distance < cells[nearest].distance))
+                    nearest = index;
+            }
+            if (nearest == cells.size())
+                return;
+            first = false;
+            Cell& cell = cells[nearest];
+            if (!loader.finish(manifest.cells[nearest], *cell.payload, deadline))
+                return;
+            cell.bytes = cell.payload->bytes();
+            cell.state = CELL_RESIDENT;
+            stats.loaded++;
+        }
+    }
+};
+#endif
@@ -83,6 +83,7 @@ int main()
   std::array<float, 3> v2 = {0.0f, 0.9f, 0.0f};
   std::vector<float> vertices;
   int depth = 0;
+  int uploadedDepth = -1;
 
   GLuint VAO, VBO;
   glGenVertexArrays(1, &VAO);
@@ -103,11 +104,16 @@ int main()
   {
     // input
     processInput(window, &depth);
-    vertices.clear();
-    
-    sierpinski(vertices, v0, v1, v2, depth);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
+
+    // the triangle only changes with depth, rebuild and upload it then instead of every frame
+    if (depth != uploadedDepth)
+    {
+      vertices.clear();
+      sierpinski(vertices, v0, v1, v2, depth);
+      glBindBuffer(GL_ARRAY_BUFFER, VBO);
+      glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+      uploadedDepth = depth;
+    }
 
     glClearColor(0.07f, 0.13f, 0.17f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
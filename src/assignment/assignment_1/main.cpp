@@ -308,6 +308,9 @@ glm::vec3 getBarColor(int i) {
 }
 
 void renderBars(Shader &shader, unsigned int VAO, float barWidth) {
+    // hashed at compile time, set through the shader's uniform table instead of a location query per bar
+    static constexpr UniformName transformUniform("transform");
+    static constexpr UniformName colorUniform("ourColor");
     shader.use();
     glBindVertexArray(VAO);
 
@@ -337,12 +340,8 @@ void renderBars(Shader &shader, unsigned int VAO, float barWidth) {
         model = glm::translate(model, glm::vec3(xpos, -1.0f, 0.0f));
         model = glm::scale(model, glm::vec3(barWidth, height * 2.0f, 1.0f));
 
-        unsigned int transformLoc = glGetUniformLocation(shader.ID, "transform");
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-        glm::vec3 color = getBarColor(i);
-        int colorLoc = glGetUniformLocation(shader.ID, "ourColor");
-        glUniform3f(colorLoc, color.r, color.g, color.b);
+        shader.setMat4(transformUniform, model);
+        shader.setVec3(colorUniform, getBarColor(i));
 
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     }
@@ -356,10 +355,8 @@ void renderBars(Shader &shader, unsigned int VAO, float barWidth) {
         glm::mat4 model = glm::mat4(1.0f);
         model = glm::translate(model, glm::vec3(BTN_X, BTN_Y, 0.0f));
         model = glm::scale(model, glm::vec3(BTN_W, BTN_H, 1.0f));
-        unsigned int transformLoc = glGetUniformLocation(shader.ID, "transform");
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(model));
-        int colorLoc = glGetUniformLocation(shader.ID, "ourColor");
-        glUniform3f(colorLoc, btnColor.r, btnColor.g, btnColor.b);
+        shader.setMat4(transformUniform, model);
+        shader.setVec3(colorUniform, btnColor);
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
     }
 }
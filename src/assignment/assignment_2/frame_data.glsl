@@ -0,0 +1,41 @@
+// lights and camera shared by every program, filled once per frame by FrameUniforms (frame_uniforms.h).
+// Included by both stages, the block has to be declared the same way in each.
+struct DirLight {
+    vec3 direction;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;
+    float constant;
+    float linear;
+    float quadratic;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct SpotLight {
+    vec3 position;
+    vec3 direction;
+    float cutOff;
+    float outerCutOff;
+    float constant;
+    float linear;
+    float quadratic;
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+layout (std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+    DirLight dirLight;
+    PointLight pointLights[4];
+    SpotLight spotLight;
+    DirLight bgLight; // additional background directional light (e.g., top-right of the screen)
+};
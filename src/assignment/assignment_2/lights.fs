@@ -1,82 +1,70 @@
 #version 330 core
 out vec4 FragColor;
 
+// permutation keys, set through ShaderDefines (shader_builder.h):
+//   NR_POINT_LIGHTS   point lights evaluated, at most the 4 of the FrameData block
+//   FACE_TEXTURE      blend in the face textures where the surface looks at the camera,
+//                     from dot(normal, viewDir) >= FACE_THRESHOLD on
+//   RUNTIME_BRANCHES  choose the face textures per draw from the useFace, forceUseBody and faceThreshold
+//                     uniforms instead, one program for every object at the cost of the unused work
+// Without FACE_TEXTURE and RUNTIME_BRANCHES only the body textures are sampled.
+#ifndef NR_POINT_LIGHTS
+#define NR_POINT_LIGHTS 4
+#endif
+#ifndef FACE_THRESHOLD
+#define FACE_THRESHOLD 0.6
+#endif
+
 struct Material {
     sampler2D diffuse;
     sampler2D specular;
     float shininess;
 }; 
 
-struct DirLight {
-    vec3 direction;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct PointLight {
-    vec3 position;
-    
-    float constant;
-    float linear;
-    float quadratic;
-	
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
-};
-
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    float cutOff;
-    float outerCutOff;
-  
-    float constant;
-    float linear;
-    float quadratic;
-  
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;       
-};
-
-#define NR_POINT_LIGHTS 4
-
 in vec3 FragPos;
 in vec3 Normal;
 in vec2 TexCoords;
 
-uniform vec3 viewPos;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLight;
-uniform DirLight bgLight; // additional background directional light (e.g., top-right of the screen)
+#include "frame_data.glsl"
+
 uniform Material material;
+#if defined(FACE_TEXTURE) || defined(RUNTIME_BRANCHES)
 uniform sampler2D faceDiffuse;
 uniform sampler2D faceSpecular;
+#endif
+#ifdef RUNTIME_BRANCHES
 uniform float faceThreshold; // dot(normal, viewDir) threshold to select face texture
 uniform float useFace; // 0.0 = disable face texture, 1.0 = allow face texture selection
 uniform float forceUseBody; // when 1.0, force using body textures only (disable face)
+#endif
 uniform vec3 glowColor;
 uniform float glowStrength;
 uniform float glowPower;
 
 // function prototypes
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float faceMix);
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float faceMix);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float faceMix);
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffTex, vec3 specTex);
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffTex, vec3 specTex);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffTex, vec3 specTex);
 
 void main()
 {    
     // properties
     vec3 norm = normalize(Normal);
     vec3 viewDir = normalize(viewPos - FragPos);
+    // the textures are sampled once here and shared by every light
+    vec3 diffTex = vec3(texture(material.diffuse, TexCoords));
+    vec3 specTex = vec3(texture(material.specular, TexCoords));
+#if defined(RUNTIME_BRANCHES)
     // per-fragment selector: 1 => use face texture, 0 => use body texture
-    // faceMix = 1.0 when this fragment should use the face texture.
     // forceUseBody overrides and forces the body textures when set to 1.0.
     float faceMix = step(faceThreshold, dot(norm, viewDir)) * useFace * (1.0 - forceUseBody);
+    diffTex = mix(diffTex, vec3(texture(faceDiffuse, TexCoords)), faceMix);
+    specTex = mix(specTex, vec3(texture(faceSpecular, TexCoords)), faceMix);
+#elif defined(FACE_TEXTURE)
+    float faceMix = step(FACE_THRESHOLD, dot(norm, viewDir));
+    diffTex = mix(diffTex, vec3(texture(faceDiffuse, TexCoords)), faceMix);
+    specTex = mix(specTex, vec3(texture(faceSpecular, TexCoords)), faceMix);
+#endif
     
     // == =====================================================
     // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
@@ -85,14 +73,14 @@ void main()
     // this fragment's final color.
     // == =====================================================
     // phase 1: directional lighting
-    vec3 result = CalcDirLight(dirLight, norm, viewDir, faceMix);
+    vec3 result = CalcDirLight(dirLight, norm, viewDir, diffTex, specTex);
     // phase 2: point lights
     for(int i = 0; i < NR_POINT_LIGHTS; i++)
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir, faceMix);    
+        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir, diffTex, specTex);    
     // phase 3: spot light
-    result += CalcSpotLight(spotLight, norm, FragPos, viewDir, faceMix);
+    result += CalcSpotLight(spotLight, norm, FragPos, viewDir, diffTex, specTex);
     // additional background directional light (top-right-ish) to add a highlight
-    result += CalcDirLight(bgLight, norm, viewDir, faceMix);
+    result += CalcDirLight(bgLight, norm, viewDir, diffTex, specTex);
 
     // emissive / rim glow: stronger on edges where viewDir is nearly perpendicular to the surface normal
     float ndotv = max(dot(norm, viewDir), 0.0);
@@ -104,7 +92,7 @@ void main()
 }
 
 // calculates the color when using a directional light.
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float faceMix)
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 diffTex, vec3 specTex)
 {
     vec3 lightDir = normalize(-light.direction);
     // diffuse shading
@@ -113,12 +101,6 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float faceMix)
     vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
     // combine results
-    vec3 bodyDiffuse = vec3(texture(material.diffuse, TexCoords));
-    vec3 bodySpec = vec3(texture(material.specular, TexCoords));
-    vec3 faceDiff = vec3(texture(faceDiffuse, TexCoords));
-    vec3 faceSpec = vec3(texture(faceSpecular, TexCoords));
-    vec3 diffTex = mix(bodyDiffuse, faceDiff, faceMix);
-    vec3 specTex = mix(bodySpec, faceSpec, faceMix);
     vec3 ambient = light.ambient * diffTex;
     vec3 diffuse = light.diffuse * diff * diffTex;
     vec3 specular = light.specular * spec * specTex;
@@ -126,7 +108,7 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, float faceMix)
 }
 
 // calculates the color when using a point light.
-vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float faceMix)
+vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffTex, vec3 specTex)
 {
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
@@ -138,12 +120,6 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, f
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
     // combine results
-    vec3 bodyDiffuse = vec3(texture(material.diffuse, TexCoords));
-    vec3 bodySpec = vec3(texture(material.specular, TexCoords));
-    vec3 faceDiff = vec3(texture(faceDiffuse, TexCoords));
-    vec3 faceSpec = vec3(texture(faceSpecular, TexCoords));
-    vec3 diffTex = mix(bodyDiffuse, faceDiff, faceMix);
-    vec3 specTex = mix(bodySpec, faceSpec, faceMix);
     vec3 ambient = light.ambient * diffTex;
     vec3 diffuse = light.diffuse * diff * diffTex;
     vec3 specular = light.specular * spec * specTex;
@@ -154,7 +130,7 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir, f
 }
 
 // calculates the color when using a spot light.
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float faceMix)
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, vec3 diffTex, vec3 specTex)
 {
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
@@ -170,12 +146,6 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, flo
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    vec3 bodyDiffuse = vec3(texture(material.diffuse, TexCoords));
-    vec3 bodySpec = vec3(texture(material.specular, TexCoords));
-    vec3 faceDiff = vec3(texture(faceDiffuse, TexCoords));
-    vec3 faceSpec = vec3(texture(faceSpecular, TexCoords));
-    vec3 diffTex = mix(bodyDiffuse, faceDiff, faceMix);
-    vec3 specTex = mix(bodySpec, faceSpec, faceMix);
     vec3 ambient = light.ambient * diffTex;
     vec3 diffuse = light.diffuse * diff * diffTex;
     vec3 specular = light.specular * spec * specTex;
@@ -183,4 +153,4 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, flo
     diffuse *= attenuation * intensity;
     specular *= attenuation * intensity;
     return (ambient + diffuse + specular);
-}
\ No newline at end of file
+}
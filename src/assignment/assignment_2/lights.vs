@@ -7,9 +7,9 @@ out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
+#include "frame_data.glsl"
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
@@ -8,8 +8,12 @@
 
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/frame_uniforms.h>
+#include <learnopengl/shader_builder.h>
 
+#include <chrono>
 #include <iostream>
+#include <string>
 #include <vector>
 #include <cmath>
 
@@ -37,7 +41,7 @@ float lastFrame = 0.0f;
 // lighting
 glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
-int main()
+int main(int argc, char* argv[])
 {
     // glfw: initialize and configure
     // ------------------------------
@@ -78,8 +82,23 @@ int main()
     // -----------------------------
     glEnable(GL_DEPTH_TEST);
 
-    Shader lightingShader("lights.vs", "lights.fs");
+    // --benchmark alternates between the specialised programs and the runtime-branch one and prints the frame
+    // time of each, run it on a software GL (LIBGL_ALWAYS_SOFTWARE=1) to see the fragment cost
+    const bool benchmark = argc > 1 && std::string(argv[1]) == "--benchmark";
+    if (benchmark)
+        glfwSwapInterval(0);
+
+    // one lighting program per material, the face texture selection is compiled in or out instead of branched
+    // on per fragment: body and tentacles only sample the body textures, the head blends in the face
+    ShaderVariants<Shader> lighting("lights.vs", "lights.fs");
+    Shader& bodyShader = lighting.get();
+    Shader& headShader = lighting.get(ShaderDefines().set("FACE_TEXTURE").set("FACE_THRESHOLD", 0.6f));
+    // the former all-in-one shader, deciding per draw from useFace and forceUseBody
+    Shader& runtimeShader = lighting.get(ShaderDefines().set("RUNTIME_BRANCHES"));
+    Shader* lightingShaders[] = { &bodyShader, &headShader, &runtimeShader };
     Shader bgShader("bg.vs", "bg.fs");
+    // programs built from a binary of an earlier run skip GLSL compilation
+    ProgramCache::stats.print(std::cout, "program cache");
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -188,39 +207,81 @@ int main()
 
     // shader configuration
     // --------------------
-    lightingShader.use();
-    lightingShader.setInt("material.diffuse", 0);
-    lightingShader.setInt("material.specular", 1);
-    // bind additional samplers for face textures
-    lightingShader.setInt("faceDiffuse", 2);
-    lightingShader.setInt("faceSpecular", 3);
+    for (Shader* lightingShader : lightingShaders)
+    {
+        lightingShader->use();
+        lightingShader->setInt("material.diffuse", 0);
+        lightingShader->setInt("material.specular", 1);
+        // bind additional samplers for face textures, programs without them ignore these
+        lightingShader->setInt("faceDiffuse", 2);
+        lightingShader->setInt("faceSpecular", 3);
+        lightingShader->setFloat("material.shininess", 32.0f);
+        // rim/glow parameters (subtle emissive rim)
+        lightingShader->setVec3("glowColor", glm::vec3(0.5f, 0.6f, 0.9f));
+        lightingShader->setFloat("glowStrength", 0.25f);
+        lightingShader->setFloat("glowPower", 2.5f);
+    }
     // threshold: when dot(normal, viewDir) >= faceThreshold use face texture
-    lightingShader.setFloat("faceThreshold", 0.6f);
-    // default to using face textures (we'll toggle it before drawing body/tentacles vs head)
-    lightingShader.setFloat("useFace", 1.0f);
-    // default: don't force body-only in case shaders expect the uniform
-    lightingShader.setFloat("forceUseBody", 0.0f);
-
+    runtimeShader.use();
+    runtimeShader.setFloat("faceThreshold", 0.6f);
+
+    // camera and lights live in one uniform buffer shared by all programs, uploaded once per frame
+    FrameUniforms frame;
+    // directional light
+    frame.data.dirLight.direction = glm::vec3(-0.2f, -1.0f, -0.3f);
+    frame.data.dirLight.ambient = glm::vec3(0.05f);
+    frame.data.dirLight.diffuse = glm::vec3(0.4f);
+    frame.data.dirLight.specular = glm::vec3(0.5f);
+    // point lights
+    for (int i = 0; i < FRAME_MAX_POINT_LIGHTS; i++)
+    {
+        FramePointLight& light = frame.data.pointLights[i];
+        light.position = pointLightPositions[i];
+        light.ambient = glm::vec3(0.05f);
+        light.diffuse = glm::vec3(0.8f);
+        light.specular = glm::vec3(1.0f);
+        light.constant = 1.0f;
+        light.linear = 0.09f;
+        light.quadratic = 0.032f;
+    }
+    // spotLight, it follows the camera every frame
+    frame.data.spotLight.ambient = glm::vec3(0.0f);
+    frame.data.spotLight.diffuse = glm::vec3(1.0f);
+    frame.data.spotLight.specular = glm::vec3(1.0f);
+    frame.data.spotLight.constant = 1.0f;
+    frame.data.spotLight.linear = 0.09f;
+    frame.data.spotLight.quadratic = 0.032f;
+    frame.data.spotLight.cutOff = glm::cos(glm::radians(12.5f));
+    frame.data.spotLight.outerCutOff = glm::cos(glm::radians(15.0f));
     // background/top-right directional light (soft bluish rim light)
-    lightingShader.setVec3("bgLight.direction", glm::vec3(-0.6f, -0.8f, -0.2f)); // coming from top-right toward center
-    lightingShader.setVec3("bgLight.ambient", 0.02f, 0.03f, 0.06f);
-    lightingShader.setVec3("bgLight.diffuse", 0.18f, 0.22f, 0.35f);
-    lightingShader.setVec3("bgLight.specular", 0.25f, 0.3f, 0.45f);
-
-    // rim/glow parameters (subtle emissive rim)
-    lightingShader.setVec3("glowColor", glm::vec3(0.5f, 0.6f, 0.9f));
-    lightingShader.setFloat("glowStrength", 0.25f);
-    lightingShader.setFloat("glowPower", 2.5f);
+    frame.data.bgLight.direction = glm::vec3(-0.6f, -0.8f, -0.2f); // coming from top-right toward center
+    frame.data.bgLight.ambient = glm::vec3(0.02f, 0.03f, 0.06f);
+    frame.data.bgLight.diffuse = glm::vec3(0.18f, 0.22f, 0.35f);
+    frame.data.bgLight.specular = glm::vec3(0.25f, 0.3f, 0.45f);
 
     // bioluminescence parameters (tweakable)
     glm::vec3 biolumColor = glm::vec3(0.2f, 0.9f, 0.8f);
     float biolumStrength = 0.9f;
 
 
+    // benchmark state: which programs draw the octopus and the frame times of the current run
+    bool specialised = true;
+    const int benchmarkFrames = 200;
+    int benchmarkFrame = 0;
+    double benchmarkMilliseconds = 0.0;
+
+    // names set every frame, hashed at compile time
+    static constexpr UniformName glowStrengthUniform("glowStrength");
+    static constexpr UniformName glowColorUniform("glowColor");
+    static constexpr UniformName useFaceUniform("useFace");
+    static constexpr UniformName forceUseBodyUniform("forceUseBody");
+    static constexpr UniformName modelUniform("model");
+
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window))
     {
+        const auto frameStart = std::chrono::steady_clock::now();
         // per-frame time logic
         // --------------------
         float currentFrame = static_cast<float>(glfwGetTime());
@@ -247,10 +308,6 @@ int main()
         glDepthMask(GL_TRUE);
 
         // then 3D scene
-        lightingShader.use();
-        lightingShader.setVec3("viewPos", camera.Position);
-        lightingShader.setFloat("material.shininess", 32.0f);
-
         // per-frame fantasy animations for the octopus sculpture
         // bobbing + slow twist + pulsing scale to give it life
         glm::mat4 octopusBase = glm::mat4(1.0f);
@@ -262,73 +319,21 @@ int main()
 
         // animated glow (pulse) and slightly shifting glow color for fantasy look
         float glowPulse = 0.25f * (1.0f + 0.6f * sin(currentFrame * 2.0f));
-        lightingShader.setFloat("glowStrength", glowPulse);
-        lightingShader.setVec3("glowColor", glm::vec3(0.4f + 0.15f * sin(currentFrame * 1.3f), 0.55f, 0.8f + 0.08f * cos(currentFrame * 1.7f)));
-
-        /*
-           Here we set all the uniforms for the 5/6 types of lights we have. We have to set them manually and index 
-           the proper PointLight struct in the array to set each uniform variable. This can be done more code-friendly
-           by defining light types as classes and set their values in there, or by using a more efficient uniform approach
-           by using 'Uniform buffer objects', but that is something we'll discuss in the 'Advanced GLSL' tutorial.
-        */
-        // directional light
-        lightingShader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
-        lightingShader.setVec3("dirLight.ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
-        lightingShader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-        // point light 1
-        lightingShader.setVec3("pointLights[0].position", pointLightPositions[0]);
-        lightingShader.setVec3("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[0].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[0].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[0].constant", 1.0f);
-        lightingShader.setFloat("pointLights[0].linear", 0.09f);
-        lightingShader.setFloat("pointLights[0].quadratic", 0.032f);
-        // point light 2
-        lightingShader.setVec3("pointLights[1].position", pointLightPositions[1]);
-        lightingShader.setVec3("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[1].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[1].constant", 1.0f);
-        lightingShader.setFloat("pointLights[1].linear", 0.09f);
-        lightingShader.setFloat("pointLights[1].quadratic", 0.032f);
-        // point light 3
-        lightingShader.setVec3("pointLights[2].position", pointLightPositions[2]);
-        lightingShader.setVec3("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[2].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[2].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[2].constant", 1.0f);
-        lightingShader.setFloat("pointLights[2].linear", 0.09f);
-        lightingShader.setFloat("pointLights[2].quadratic", 0.032f);
-        // point light 4
-        lightingShader.setVec3("pointLights[3].position", pointLightPositions[3]);
-        lightingShader.setVec3("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-        lightingShader.setVec3("pointLights[3].diffuse", 0.8f, 0.8f, 0.8f);
-        lightingShader.setVec3("pointLights[3].specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("pointLights[3].constant", 1.0f);
-        lightingShader.setFloat("pointLights[3].linear", 0.09f);
-        lightingShader.setFloat("pointLights[3].quadratic", 0.032f);
-        // spotLight
-        lightingShader.setVec3("spotLight.position", camera.Position);
-        lightingShader.setVec3("spotLight.direction", camera.Front);
-        lightingShader.setVec3("spotLight.ambient", 0.0f, 0.0f, 0.0f);
-        lightingShader.setVec3("spotLight.diffuse", 1.0f, 1.0f, 1.0f);
-        lightingShader.setVec3("spotLight.specular", 1.0f, 1.0f, 1.0f);
-        lightingShader.setFloat("spotLight.constant", 1.0f);
-        lightingShader.setFloat("spotLight.linear", 0.09f);
-        lightingShader.setFloat("spotLight.quadratic", 0.032f);
-        lightingShader.setFloat("spotLight.cutOff", glm::cos(glm::radians(12.5f)));
-        lightingShader.setFloat("spotLight.outerCutOff", glm::cos(glm::radians(15.0f)));     
-
-        // view/projection transformations
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        lightingShader.setMat4("projection", projection);
-        lightingShader.setMat4("view", view);
-
-        // world transformation
-        glm::mat4 model = glm::mat4(1.0f);
-        lightingShader.setMat4("model", model);
+        const glm::vec3 glowColor(0.4f + 0.15f * sin(currentFrame * 1.3f), 0.55f, 0.8f + 0.08f * cos(currentFrame * 1.7f));
+        for (Shader* lightingShader : lightingShaders)
+        {
+            lightingShader->use();
+            lightingShader->setFloat(glowStrengthUniform, glowPulse);
+            lightingShader->setVec3(glowColorUniform, glowColor);
+        }
+
+        // camera dependent frame data, one upload for every program drawn this frame
+        frame.data.projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        frame.data.view = camera.GetViewMatrix();
+        frame.data.viewPos = camera.Position;
+        frame.data.spotLight.position = camera.Position;
+        frame.data.spotLight.direction = camera.Front;
+        frame.upload();
 
         // bind diffuse map
         glActiveTexture(GL_TEXTURE0);
@@ -347,9 +352,14 @@ int main()
         glm::mat4 bodyModel = octopusBase;
         bodyModel = glm::translate(bodyModel, bodyCenter);
         bodyModel = glm::scale(bodyModel, glm::vec3(bodyScaleXZ * pulse, bodyScaleY * pulse, bodyScaleXZ * pulse));
-        lightingShader.setFloat("useFace", 0.0f); // don't apply face texture to the body
-        lightingShader.setFloat("forceUseBody", 1.0f); // ensure body uses body textures only
-        lightingShader.setMat4("model", bodyModel);
+        Shader& body = specialised ? bodyShader : runtimeShader;
+        body.use();
+        if (!specialised)
+        {
+            body.setFloat(useFaceUniform, 0.0f); // don't apply face texture to the body
+            body.setFloat(forceUseBodyUniform, 1.0f); // ensure body uses body textures only
+        }
+        body.setMat4(modelUniform, bodyModel);
         glDrawArrays(GL_TRIANGLES, 0, 36);
         float bodyTopY = bodyCenter.y + bodyScaleY * 0.5f;
         float bodyBottomY_local = bodyCenter.y - bodyScaleY * 0.5f;
@@ -363,13 +373,22 @@ int main()
         headModel = glm::translate(headModel, headPos);
         headModel = glm::rotate(headModel, -headYaw + glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
         headModel = glm::scale(headModel, glm::vec3(0.9f * pulse, 0.7f * pulse, 0.9f * pulse));
-        lightingShader.setFloat("forceUseBody", 0.0f); // allow face texture for head
-        lightingShader.setFloat("useFace", 1.0f); // enable face texture for head
-        lightingShader.setMat4("model", headModel);
+        Shader& head = specialised ? headShader : runtimeShader;
+        head.use();
+        if (!specialised)
+        {
+            head.setFloat(forceUseBodyUniform, 0.0f); // allow face texture for head
+            head.setFloat(useFaceUniform, 1.0f); // enable face texture for head
+        }
+        head.setMat4(modelUniform, headModel);
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
-        lightingShader.setFloat("useFace", 0.0f);
-        lightingShader.setFloat("forceUseBody", 1.0f);
+        body.use();
+        if (!specialised)
+        {
+            body.setFloat(useFaceUniform, 0.0f);
+            body.setFloat(forceUseBodyUniform, 1.0f);
+        }
         glBindVertexArray(cubeVAO);
             for (int t = 0; t < NUM_TENTACLES; ++t)
             {
@@ -421,7 +440,7 @@ int main()
                     // scale Y by length and X/Z by radius to taper
                     segmentModel = glm::scale(segmentModel, glm::vec3(radius, length, radius));
 
-                    lightingShader.setMat4("model", segmentModel);
+                    body.setMat4(modelUniform, segmentModel);
                     // bind tentacle mesh and draw
                     glBindVertexArray(tentVAO);
                     glDrawElements(GL_TRIANGLES, tentIndexCount, GL_UNSIGNED_INT, 0);
@@ -432,6 +451,21 @@ int main()
                 glBindVertexArray(0);
             }
 
+            if (benchmark)
+            {
+                // wait for the GPU so the time covers the fragment work and not just the submission
+                glFinish();
+                benchmarkMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+                if (++benchmarkFrame == benchmarkFrames)
+                {
+                    std::cout << (specialised ? "specialised programs: " : "runtime branches:     ")
+                              << benchmarkMilliseconds / benchmarkFrames << " ms/frame" << std::endl;
+                    specialised = !specialised;
+                    benchmarkFrame = 0;
+                    benchmarkMilliseconds = 0.0;
+                }
+            }
+
             glfwSwapBuffers(window);
             glfwPollEvents();
     }
@@ -443,6 +477,7 @@ int main()
     if (tentVAO) glDeleteVertexArrays(1, &tentVAO);
     if (tentVBO) glDeleteBuffers(1, &tentVBO);
     if (tentEBO) glDeleteBuffers(1, &tentEBO);
+    frame.release();
     glfwTerminate();
     return 0;
 }
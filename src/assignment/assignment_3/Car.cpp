@@ -1,6 +1,5 @@
 #include "Car.h"
 #include <glm/gtc/type_ptr.hpp>
-#include <cfloat>
 
 Car::Car()
         : Position(0.0f, 0.0f, 0.0f), Yaw(0.0f), Front(1.0f,0.0f, 0.0f),
@@ -11,59 +10,16 @@ Car::Car()
 
 void Car::init(const Model &model)
 {
-    // compute AABB center
-    bool any = false;
-    glm::vec3 minp(FLT_MAX), maxp(-FLT_MAX);
-    for (auto &mesh : model.meshes) {
-        for (auto &v : mesh.vertices) {
-            glm::vec3 p = v.Position;
-            minp = glm::min(minp, p);
-            maxp = glm::max(maxp, p);
-            any = true;
-        }
-    }
-    if (any) ModelCenter = (minp + maxp) * 0.5f;
+    // the model measured its box, radius and principal axis once at load
+    const ModelBounds &bounds = model.bounds;
+    if (bounds.vertexCount > 0) ModelCenter = bounds.center();
 
-    // compute model-space radius (max distance from center to vertex)
-    {
-        float maxd = 0.0f;
-        for (auto &mesh : model.meshes) {
-            for (auto &v : mesh.vertices) {
-                float d = glm::length(v.Position - ModelCenter);
-                if (d > maxd) maxd = d;
-            }
-        }
-        if (maxd > 0.0f) ModelRadius = maxd;
-    }
+    // model-space radius (max distance from center to vertex)
+    if (bounds.boxCenterRadius > 0.0f) ModelRadius = bounds.boxCenterRadius;
 
-    {
-        glm::mat3 cov(0.0f);
-        size_t count = 0;
-        for (auto &mesh : model.meshes) {
-            for (auto &v : mesh.vertices) {
-                glm::vec3 d = v.Position - ModelCenter;
-                cov[0][0] += d.x * d.x; cov[0][1] += d.x * d.y; cov[0][2] += d.x * d.z;
-                cov[1][0] += d.y * d.x; cov[1][1] += d.y * d.y; cov[1][2] += d.y * d.z;
-                cov[2][0] += d.z * d.x; cov[2][1] += d.z * d.y; cov[2][2] += d.z * d.z;
-                ++count;
-            }
-        }
-        if (count > 0) {
-            cov /= (float)count;
-            glm::vec3 axis(1.0f, 0.0f, 0.0f);
-            for (int it = 0; it < 20; ++it) {
-                glm::vec3 next;
-                next.x = cov[0][0]*axis.x + cov[0][1]*axis.y + cov[0][2]*axis.z;
-                next.y = cov[1][0]*axis.x + cov[1][1]*axis.y + cov[1][2]*axis.z;
-                next.z = cov[2][0]*axis.x + cov[2][1]*axis.y + cov[2][2]*axis.z;
-                float len = glm::length(next);
-                if (len < 1e-6f) break;
-                axis = next / len;
-            }
-            axis.y = 0.0f;
-            if (glm::length(axis) > 1e-3f) ModelForwardLocal = glm::normalize(axis);
-        }
-    }
+    glm::vec3 axis = bounds.principalAxis;
+    axis.y = 0.0f;
+    if (glm::length(axis) > 1e-3f) ModelForwardLocal = glm::normalize(axis);
 }
 
 void Car::handleInput(GLFWwindow* window, float deltaTime)
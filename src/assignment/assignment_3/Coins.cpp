@@ -85,15 +85,18 @@ int Coins::remaining() const
     return rem;
 }
 
-void Coins::draw(Shader &shader, unsigned int fallbackTexture)
+void Coins::submit(RenderQueue &queue, Shader &instancedShader, unsigned int fallbackTexture)
 {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, fallbackTexture);
-    shader.setInt("texture_diffuse1", 0);
+    if (!coinModel)
+        return;
+    float t = static_cast<float>(glfwGetTime());
+    float baseLift = BASE_HALF_HEIGHT * COIN_SCALE;
+    float spin = t * 180.0f;
+
+    instanceData.clear();
     for (size_t i = 0; i < positions.size(); ++i) {
         if (collected[i]) continue;
         glm::mat4 m(1.0f);
-        float t = static_cast<float>(glfwGetTime());
 
         float amp = 0.08f;
         float freq = 3.0f;
@@ -104,27 +107,24 @@ void Coins::draw(Shader &shader, unsigned int fallbackTexture)
 
         float bounce = sinf(t * freq + phase) * amp;
         float bounceAbs = fabsf(bounce);
-        float baseLift = BASE_HALF_HEIGHT * COIN_SCALE;
         m = glm::translate(m, positions[i] + glm::vec3(0.0f, baseLift + bounceAbs, 0.0f));
-
-        m = glm::rotate(m, glm::radians(0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-        float spin = t * 180.0f;
         m = glm::rotate(m, glm::radians(spin), glm::vec3(0.0f, 1.0f, 0.0f));
         m = glm::scale(m, glm::vec3(COIN_SCALE));
 
-        shader.setBool("useColor", true);
+        InstanceData instance;
+        instance.model = m;
         if (i < value.size() && value[i] == 2) {
-            shader.setVec3("objectColor", glm::vec3(1.0f, 0.85f, 0.0f));
+            instance.color = glm::vec4(1.0f, 0.85f, 0.0f, 1.0f);
         } else {
-            shader.setVec3("objectColor", glm::vec3(1.0f, 1.0f, 0.0f));
-        }
-
-        shader.setMat4("model", m);
-        if (coinModel) {
-            coinModel->Draw(shader);
+            instance.color = glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
         }
+        instanceData.push_back(instance);
     }
-    shader.setBool("useColor", false);
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    instances.upload(instanceData);
+
+    // one packet for all coins, the queue draws every mesh of the coin model once with all instances
+    DrawPacket packet;
+    packet.texture = fallbackTexture;
+    packet.instances = &instances;
+    coinModel->Submit(queue, instancedShader, packet);
 }
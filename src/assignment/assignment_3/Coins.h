@@ -4,7 +4,9 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include <learnopengl/shader_m.h>
+#include <learnopengl/instance_buffer.h>
 #include <learnopengl/model.h>
+#include <learnopengl/render_queue.h>
 #include <memory>
 
 class Coins {
@@ -13,9 +15,12 @@ public:
     void init();
     void spawnRandom(int count);
     int updateCollect(const glm::vec3 &carPos, float carRadius);
-    void draw(Shader &shader, unsigned int fallbackTexture);
+    // queues every remaining coin as one instanced draw, tinted by its value. instancedShader reads the
+    // transform and colour from the instance attributes (instanced.vs)
+    void submit(RenderQueue &queue, Shader &instancedShader, unsigned int fallbackTexture);
     int remaining() const;
     void setModel(Model *m) { coinModel = m; }
+    StreamBufferStats &uploadStats() { return instances.stream.stats; }
     
 private:
     Model *coinModel = nullptr;
@@ -26,6 +31,10 @@ private:
     std::vector<float> bobAmplitude;
     std::vector<float> bobFrequency;
     std::vector<float> bobPhase;    
+
+    // rebuilt every frame from the remaining coins
+    std::vector<InstanceData> instanceData;
+    InstanceBuffer instances;
 };
 
 #endif
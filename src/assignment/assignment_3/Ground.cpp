@@ -97,20 +97,19 @@ void Ground::init(const std::string &texturePath)
     glBindVertexArray(0);
 }
 
-void Ground::draw(Shader &shader)
+void Ground::submit(RenderQueue &queue, Shader &shader)
 {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    shader.setInt("texture_diffuse1", 0);
-    glm::mat4 groundModel = glm::mat4(1.0f);
-    shader.setMat4("model", groundModel);
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    DrawPacket packet;
+    packet.shader = &shader;
+    packet.texture = texture;
 
-    // draw border walls around the plane
-    glBindVertexArray(wallVAO);
+    packet.VAO = VAO;
+    packet.count = 6;
+    queue.submit(packet);
+
+    // border walls around the plane
+    packet.VAO = wallVAO;
+    packet.count = 36;
     // wall parameters
     float planeSize = 50.0f;
     float wallHeight = 6.0f;
@@ -120,27 +119,25 @@ void Ground::draw(Shader &shader)
     glm::mat4 m1 = glm::mat4(1.0f);
     m1 = glm::translate(m1, glm::vec3(0.0f, wallHeight * 0.5f, -planeSize - wallThickness * 0.5f));
     m1 = glm::scale(m1, glm::vec3(planeSize * 2.0f, wallHeight, wallThickness));
-    shader.setMat4("model", m1);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    packet.model = m1;
+    queue.submit(packet);
 
     glm::mat4 m2 = glm::mat4(1.0f);
     m2 = glm::translate(m2, glm::vec3(0.0f, wallHeight * 0.5f, planeSize + wallThickness * 0.5f));
     m2 = glm::scale(m2, glm::vec3(planeSize * 2.0f, wallHeight, wallThickness));
-    shader.setMat4("model", m2);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    packet.model = m2;
+    queue.submit(packet);
 
     // left/right walls (along Z, at X = +/- planeSize)
     glm::mat4 m3 = glm::mat4(1.0f);
     m3 = glm::translate(m3, glm::vec3(-planeSize - wallThickness * 0.5f, wallHeight * 0.5f, 0.0f));
     m3 = glm::scale(m3, glm::vec3(wallThickness, wallHeight, planeSize * 2.0f));
-    shader.setMat4("model", m3);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    packet.model = m3;
+    queue.submit(packet);
 
     glm::mat4 m4 = glm::mat4(1.0f);
     m4 = glm::translate(m4, glm::vec3(planeSize + wallThickness * 0.5f, wallHeight * 0.5f, 0.0f));
     m4 = glm::scale(m4, glm::vec3(wallThickness, wallHeight, planeSize * 2.0f));
-    shader.setMat4("model", m4);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
-
-    glBindVertexArray(0);
+    packet.model = m4;
+    queue.submit(packet);
 }
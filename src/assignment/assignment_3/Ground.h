@@ -4,12 +4,14 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <learnopengl/shader_m.h>
+#include <learnopengl/render_queue.h>
 
 class Ground {
 public:
     Ground();
     void init(const std::string &texturePath);
-    void draw(Shader &shader);
+    // queues the plane and the four border walls
+    void submit(RenderQueue &queue, Shader &shader);
     unsigned int getTexture() const { return texture; }
 private:
     unsigned int VAO, VBO;
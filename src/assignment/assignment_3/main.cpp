@@ -10,12 +10,17 @@
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/frame_uniforms.h>
+#include <learnopengl/gl_counters.h>
 
 #include "Car.h"
 #include "Ground.h"
 #include "Coins.h"
 #include "Utils.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
@@ -71,8 +76,13 @@ void processInput(GLFWwindow *window, Car &car) {
     car.handleInput(window, deltaTime);
 }
 
-int main()
+int main(int argc, char* argv[])
 {
+    // an optional coin count turns the game into a draw call benchmark, e.g. "assignment_3 10000"
+    const bool benchmark = argc > 1;
+    if (benchmark)
+        randomCoins = std::max(1, std::atoi(argv[1]));
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -101,8 +111,12 @@ int main()
     glEnable(GL_DEPTH_TEST);
 
     Shader ourShader("shader.vs", "shader.fs");
-    Model carModel(FileSystem::getPath("resources/objects/f1/f1.obj"));
-    Model coinModel(FileSystem::getPath("resources/objects/coin/Coin.obj"));
+    Shader instancedShader("instanced.vs", "instanced.fs");
+    FrameUniforms frame;
+    Model carModel(FileSystem::getPath("resources/objects/f1/f1.obj"), false, MODEL_OPTIMIZE_INDICES | MODEL_MERGE_MESHES);
+    Model coinModel(FileSystem::getPath("resources/objects/coin/Coin.obj"), false, MODEL_OPTIMIZE_INDICES);
+    carModel.cacheStatsBefore.print(std::cout, "f1 vertex cache", carModel.cacheStatsAfter);
+    coinModel.cacheStatsBefore.print(std::cout, "coin vertex cache", coinModel.cacheStatsAfter);
 
     Car car;
     car.init(carModel);
@@ -118,8 +132,18 @@ int main()
 
     unsigned int whiteTexture = utils::createWhiteTexture();
 
+    RenderQueue queue;
+    if (benchmark)
+        GLCallCounter::install();
+    double statsTime = glfwGetTime();
+    double frameTimeSum = 0.0;
+    unsigned int frames = 0;
+
     int score = 0;
 
+    // names set every frame, hashed at compile time
+    static constexpr UniformName useColorUniform("useColor");
+
     while (!glfwWindowShouldClose(window)) {
         float currentFrame = static_cast<float>(glfwGetTime());
         deltaTime = currentFrame - lastFrame;
@@ -165,24 +189,41 @@ int main()
             std::cout << "All coins collected! Respawning...\n";
         }
 
+        // the camera is uploaded once and read by both programs through their FrameData block
+        frame.data.projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        frame.data.view = camera.GetViewMatrix();
+        frame.data.viewPos = camera.Position;
+        frame.upload();
         ourShader.use();
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        ourShader.setMat4("projection", projection);
-        ourShader.setMat4("view", view);
-        ourShader.setBool("useColor", false);
-
-        ground.draw(ourShader);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, whiteTexture);
-        ourShader.setInt("texture_diffuse1", 0);
-    ourShader.setMat4("model", car.getModelMatrix());
-    carModel.Draw(ourShader);
-
-        glBindTexture(GL_TEXTURE_2D, 0);
-
-        coins.draw(ourShader, whiteTexture);
+        ourShader.setBool(useColorUniform, false);
+        GLCallCounter::counters.reset();
+
+        // everything is queued first and drawn sorted by shader, texture and vertex array
+        queue.setCamera(camera.Position, 100.0f);
+        ground.submit(queue, ourShader);
+
+        DrawPacket carPacket;
+        carPacket.model = car.getModelMatrix();
+        carPacket.texture = whiteTexture; // for car meshes without textures
+        carModel.Submit(queue, ourShader, carPacket);
+
+        coins.submit(queue, instancedShader, whiteTexture);
+        queue.flush();
+
+        if (benchmark) {
+            glFinish();
+            frameTimeSum += glfwGetTime() - currentFrame;
+            frames++;
+            if (glfwGetTime() - statsTime >= 1.0) {
+                std::cout << coins.remaining() << " coins, " << frameTimeSum * 1000.0 / frames << " ms/frame" << std::endl;
+                GLCallCounter::counters.print(std::cout, "  last frame");
+                coins.uploadStats().print(std::cout, "  coin instances");
+                coins.uploadStats().reset();
+                statsTime = glfwGetTime();
+                frameTimeSum = 0.0;
+                frames = 0;
+            }
+        }
 
         if (cameraAttached) {
             glm::vec3 carFront = car.getFront();
@@ -224,6 +265,7 @@ int main()
         glfwPollEvents();
     }
 
+    frame.release();
     glfwTerminate();
     return 0;
 }
@@ -8,9 +8,13 @@ layout(location = 4) in vec3 bitangent;
 layout(location = 5) in ivec4 boneIds; 
 layout(location = 6) in vec4 weights;
 
-uniform mat4 projection;
-uniform mat4 view;
 uniform mat4 model;
+// camera shared by every program (FrameUniforms in frame_uniforms.h), the lights declared after it aren't needed here
+layout (std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
 
 const int MAX_BONES = 100;
 const int MAX_BONE_INFLUENCE = 4;
@@ -8,6 +8,7 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/frame_uniforms.h>
 #include <learnopengl/animator.h>
 #include <learnopengl/model_animation.h>
 
@@ -111,12 +112,15 @@ int main()
 	// build and compile shaders
 	// -------------------------
 	Shader ourShader("anim_model.vs", "anim_model.fs");
+	FrameUniforms frame;
+	ProgramCache::stats.print(std::cout, "program cache");
 
 	
 	// load models
 	// -----------
 	// idle 3.3, walk 2.06, run 0.83, punch 1.03, kick 1.6
-	Model ourModel(FileSystem::getPath("resources/objects/lewis/lewis.dae"));
+	Model ourModel(FileSystem::getPath("resources/objects/lewis/lewis.dae"), false, MODEL_OPTIMIZE_INDICES);
+	ourModel.cacheStatsBefore.print(std::cout, "lewis vertex cache", ourModel.cacheStatsAfter);
 	Animation idleAnimation(FileSystem::getPath("resources/objects/lewis/idle.dae"),&ourModel);
 	Animation walkAnimation(FileSystem::getPath("resources/objects/lewis/walk.dae"), &ourModel);
 	Animation runAnimation(FileSystem::getPath("resources/objects/lewis/run.dae"), &ourModel);
@@ -130,6 +134,14 @@ int main()
 	// draw in wireframe
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
+	// table positions of the bone matrices, resolved once instead of building every element name each frame
+	std::vector<int> boneUniforms;
+	for (size_t i = 0; i < animator.GetFinalBoneMatrices().size(); ++i)
+		boneUniforms.push_back(ourShader.uniforms.indexOf("finalBonesMatrices[" + std::to_string(i) + "]"));
+
+	// names set every frame, hashed at compile time
+	static constexpr UniformName modelUniform("model");
+
 	// render loop
 	// -----------
 	while (!glfwWindowShouldClose(window))
@@ -449,23 +461,23 @@ int main()
 		// don't forget to enable shader before setting uniforms
 		ourShader.use();
 
-		// view/projection transformations
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+		// view/projection transformations, uploaded once for the FrameData block
+		frame.data.projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
 		// third-person follow camera: compute camera position relative to model
 		glm::vec3 camOffsetLocal = glm::vec3(0.0f, 1.5f, 3.0f);
 		glm::mat4 rot = glm::rotate(glm::mat4(1.0f), modelYaw, glm::vec3(0.0f, 1.0f, 0.0f));
 		glm::vec3 camOffset = glm::vec3(rot * glm::vec4(camOffsetLocal, 1.0f));
 		glm::vec3 camPos = modelPosition + camOffset;
-		glm::mat4 view = glm::lookAt(camPos, modelPosition + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		frame.data.view = glm::lookAt(camPos, modelPosition + glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
 		// update camera struct so zoom & mouse still operate reasonably
 		camera.Position = camPos;
 		camera.Front = glm::normalize(modelPosition - camPos);
-		ourShader.setMat4("projection", projection);
-		ourShader.setMat4("view", view);
+		frame.data.viewPos = camPos;
+		frame.upload();
 
-        auto transforms = animator.GetFinalBoneMatrices();
-		for (int i = 0; i < transforms.size(); ++i)
-			ourShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+		const std::vector<glm::mat4>& transforms = animator.GetFinalBoneMatrices();
+		for (size_t i = 0; i < transforms.size(); ++i)
+			ourShader.setMat4(boneUniforms[i], transforms[i]);
 
 
 		// render the loaded model at the character position and rotation
@@ -473,7 +485,7 @@ int main()
 		model = glm::translate(model, modelPosition);
 		model = glm::rotate(model, modelYaw, glm::vec3(0.0f, 1.0f, 0.0f));
 		model = glm::scale(model, glm::vec3(.5f, .5f, .5f));	// scale down
-		ourShader.setMat4("model", model);
+		ourShader.setMat4(modelUniform, model);
 		ourModel.Draw(ourShader);
 
 
@@ -483,6 +495,7 @@ int main()
 		glfwPollEvents();
 	}
 
+	frame.release();
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
@@ -0,0 +1,1218 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader_m.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/bvh.h>
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/frame_uniforms.h>
+#include <learnopengl/gl_counters.h>
+#include <learnopengl/gl_stub.h>
+#include <learnopengl/gl_state.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/memory_usage.h>
+#include <learnopengl/transform_system.h>
+#include <learnopengl/visibility.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <new>
+#include <random>
+#include <thread>
+#include <vector>
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow *window);
+bool compareMergedDraws(Shader &shader, Model &separate, Model &merged, const string &name);
+void compareModelMemory(const string &directory);
+void compareTransformUpdates(Model &model, size_t nodeCount);
+bool compareTransformMatrices(size_t count);
+bool compareFrustumCulling(Entity &root, const Frustum &frustum);
+bool compareSpatialQueries(const AABB &instanceBox, const Frustum &frustum);
+bool compareVisibility(DrawList &drawList, const Frustum &frustum, const LodView &view);
+void addGrid(Entity &root, Model &model);
+int checkDrawAllocations(unsigned int drawCount);
+int checkStateCache();
+int checkMergedDraws();
+int checkCpu(size_t nodeCount);
+
+// every heap allocation of the program is counted, the draw path is expected not to make any
+static size_t allocationCount = 0;
+void* operator new(size_t size)
+{
+    allocationCount++;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// far-field scene: a square grid of models spread over a large area, the entity count can be passed on the command line
+int gridSize = 30;
+const float GRID_SPACING = 12.0f;
+
+// camera
+Camera camera(glm::vec3(0.0f, 8.0f, 40.0f));
+float lastX = SCR_WIDTH / 2.0f;
+float lastY = SCR_HEIGHT / 2.0f;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+// toggles
+bool useLod = true;
+bool useQueue = true;
+bool useIndirect = true;
+bool useDrawList = true;
+bool cullingRequested = false;
+bool spatialRequested = false;
+bool visibilityRequested = false;
+
+// usage: 11_scene_stress [entities] [nodes]                 draws the grid, nodes also times the transform updates
+//        11_scene_stress --check-allocations [draws]     binds and draws a mesh on stubbed GL, fails on any allocation
+//        11_scene_stress --check-state-cache             runs scripted binds through GLStateCache on stubbed GL
+//        11_scene_stress --check-merged-draws            draws a model mesh by mesh and merged on stubbed GL
+//        11_scene_stress --check-cpu [entities] [nodes]  transform, culling, spatial query and draw list checks
+int main(int argc, char* argv[])
+{
+    // checks that run without a window, they exit with 1 when they fail
+    if (argc > 1 && std::strcmp(argv[1], "--check-allocations") == 0)
+        return checkDrawAllocations(argc > 2 ? static_cast<unsigned int>(std::max(1, std::atoi(argv[2]))) : 1000);
+    if (argc > 1 && std::strcmp(argv[1], "--check-state-cache") == 0)
+        return checkStateCache();
+    if (argc > 1 && std::strcmp(argv[1], "--check-merged-draws") == 0)
+        return checkMergedDraws();
+    if (argc > 1 && std::strcmp(argv[1], "--check-cpu") == 0)
+    {
+        if (argc > 2)
+            gridSize = std::max(1, static_cast<int>(std::ceil(std::sqrt(std::atof(argv[2])))));
+        return checkCpu(argc > 3 ? static_cast<size_t>(std::max(1L, std::atol(argv[3]))) : 100000);
+    }
+
+    if (argc > 1)
+        gridSize = std::max(1, static_cast<int>(std::ceil(std::sqrt(std::atof(argv[1])))));
+
+    // glfw: initialize and configure
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // glfw window creation
+    // --------------------
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Scene stress", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+    glfwSwapInterval(0); // measure the real frame cost, not the refresh rate
+
+    // tell GLFW to capture our mouse
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // glad: load all OpenGL function pointers
+    // ---------------------------------------
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    // configure global opengl state
+    // -----------------------------
+    glEnable(GL_DEPTH_TEST);
+
+    // build and compile shaders
+    // -------------------------
+    Shader ourShader("scene.vs", "scene.fs");
+    Shader indirectShader("scene_instanced.vs", "scene.fs");
+    // camera data every program reads, bound before the first draw
+    FrameUniforms frame;
+    frame.upload();
+
+    // count GL calls for the rest of the run, the state cache goes on top so only the binds it lets through are counted
+    // ------------------------------------------------------------------------------------------------------------
+    GLCallCounter::install();
+    GLStateCache::install();
+
+    // draw calls and binds of one model drawn mesh by mesh and merged per material
+    // ----------------------------------------------------------------------------
+    {
+        const string path = FileSystem::getPath("resources/objects/f1/f1.obj");
+        Model separate(path);
+        Model merged(path, false, MODEL_MERGE_MESHES);
+        compareMergedDraws(ourShader, separate, merged, path);
+    }
+
+    // what every bundled model costs in RSS with its CPU geometry kept and released
+    // -----------------------------------------------------------------------------
+    compareModelMemory(FileSystem::getPath("resources/objects"));
+
+    // load models
+    // -----------
+    const MemoryUsage beforeLoad = MemoryUsage::query();
+    Model ourModel(FileSystem::getPath("resources/objects/maria/maria.dae"), false,
+                   MODEL_OPTIMIZE_INDICES | MODEL_GENERATE_LODS | MODEL_RELEASE_CPU_GEOMETRY | MODEL_MERGE_MESHES);
+    const MemoryUsage afterLoad = MemoryUsage::query();
+    std::cout << "RSS before load " << beforeLoad.currentBytes / 1024 << " kB, after load " << afterLoad.currentBytes / 1024
+              << " kB, peak " << afterLoad.peakBytes / 1024 << " kB, CPU geometry kept " << ourModel.cpuGeometryBytes() / 1024 << " kB" << std::endl;
+    std::cout << "LOD triangles:";
+    for (unsigned int lod = 0; lod < ourModel.lodCount(); lod++)
+        std::cout << " " << ourModel.triangleCount(lod);
+    std::cout << std::endl;
+    std::cout << "bounds of " << ourModel.bounds.vertexCount << " vertices: sphere radius " << ourModel.bounds.sphereRadius
+              << ", box corner " << glm::length(ourModel.bounds.extents()) << std::endl;
+
+    // time the Entity tree against TransformSystem on a hierarchy of argv[2] nodes, and the Transform matrices
+    // against the euler angle matrices they replaced
+    // --------------------------------------------------------------------------------------------------------
+    if (argc > 2)
+    {
+        const size_t nodeCount = static_cast<size_t>(std::max(1L, std::atol(argv[2])));
+        compareTransformUpdates(ourModel, nodeCount);
+        compareTransformMatrices(nodeCount);
+    }
+
+    // build the scene graph, the first instance is the root and every other one is its child
+    // ---------------------------------------------------------------------------------------
+    Entity ourEntity(ourModel);
+    addGrid(ourEntity, ourModel);
+    // the flattened tree the visibility jobs split between them
+    DrawList drawList;
+    drawList.setScene(ourEntity);
+
+    LodView lodView;
+    LodStats lodStats;
+    RenderQueue queue;
+    IndirectRenderer indirect;
+    double submitTimeSum = 0.0;
+    double statsTime = glfwGetTime();
+    double frameTimeSum = 0.0;
+    unsigned int frames = 0;
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window))
+    {
+        // per-frame time logic
+        // --------------------
+        float currentFrame = static_cast<float>(glfwGetTime());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        // input
+        // -----
+        processInput(window);
+
+        // render
+        // ------
+        glClearColor(0.55f, 0.65f, 0.75f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        GLCallCounter::counters.reset();
+        GLStateCache::stats.reset();
+        const float aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
+        const float fovY = glm::radians(camera.Zoom);
+        // one camera upload serves both programs
+        frame.data.projection = glm::perspective(fovY, aspect, 0.1f, 1000.0f);
+        frame.data.view = camera.GetViewMatrix();
+        frame.data.viewPos = camera.Position;
+        frame.upload();
+        ourShader.use();
+
+        const Frustum camFrustum = createFrustumFromCamera(camera, aspect, fovY, 0.1f, 1000.0f);
+        if (cullingRequested)
+        {
+            compareFrustumCulling(ourEntity, camFrustum);
+            cullingRequested = false;
+        }
+        if (spatialRequested)
+        {
+            compareSpatialQueries(ourEntity.getGlobalAABB(), camFrustum);
+            spatialRequested = false;
+        }
+        unsigned int display = 0, total = 0;
+        lodStats.reset();
+        const size_t allocationsBeforeDraw = allocationCount;
+        const double submitStart = glfwGetTime();
+        if (useLod)
+        {
+            lodView.cameraPosition = camera.Position;
+            lodView.fovY = fovY;
+            if (visibilityRequested)
+            {
+                compareVisibility(drawList, camFrustum, lodView);
+                visibilityRequested = false;
+            }
+            if (useDrawList)
+            {
+                // culled and leveled on every core, the GL calls stay on this thread
+                drawList.build(camFrustum, lodView, &JobSystem::shared());
+                lodStats = drawList.stats;
+                display = static_cast<unsigned int>(drawList.items.size());
+                total = static_cast<unsigned int>(drawList.entityCount());
+                if (useIndirect)
+                {
+                    drawList.add(indirect);
+                    indirect.flush(indirectShader);
+                }
+                else if (useQueue)
+                {
+                    queue.setCamera(camera.Position, 1000.0f);
+                    drawList.submit(queue, ourShader);
+                    queue.flush();
+                }
+                else
+                    drawList.draw(ourShader);
+            }
+            else if (useIndirect)
+            {
+                ourEntity.addSelfAndChild(camFrustum, indirect, lodView, lodStats, display, total);
+                indirect.flush(indirectShader);
+            }
+            else if (useQueue)
+            {
+                queue.setCamera(camera.Position, 1000.0f);
+                ourEntity.submitSelfAndChild(camFrustum, queue, ourShader, lodView, lodStats, display, total);
+                queue.flush();
+            }
+            else
+                ourEntity.drawSelfAndChild(camFrustum, ourShader, lodView, lodStats, display, total);
+        }
+        else
+        {
+            ourEntity.drawSelfAndChild(camFrustum, ourShader, display, total);
+            lodStats.triangles = display * static_cast<unsigned int>(ourModel.triangleCount());
+            lodStats.drawsPerLod[0] = display;
+        }
+
+        // print the averaged frame cost and what was drawn once per second
+        // ----------------------------------------------------------------
+        // CPU time spent traversing the scene and issuing GL calls, before waiting for the GPU
+        submitTimeSum += glfwGetTime() - submitStart;
+        const GLCounters frameCounters = GLCallCounter::counters;
+        const GLStateStats frameState = GLStateCache::stats;
+        const size_t drawAllocations = allocationCount - allocationsBeforeDraw;
+        glFinish();
+        frameTimeSum += glfwGetTime() - currentFrame;
+        frames++;
+        if (glfwGetTime() - statsTime >= 1.0)
+        {
+            const char* path = !useLod ? "" : (useIndirect ? "[indirect] " : (useQueue ? "[queue] " : ""));
+            std::cout << (useLod ? "[lod] " : "[full] ") << (useLod && useDrawList ? "[jobs] " : "") << path
+                      << frameTimeSum * 1000.0 / frames << " ms/frame, " << submitTimeSum * 1000.0 / frames << " ms submit, "
+                      << display << "/" << total << " entities, "
+                      << lodStats.triangles << " triangles, per lod:";
+            for (unsigned int lod = 0; lod < MAX_MESH_LODS; lod++)
+                std::cout << " " << lodStats.drawsPerLod[lod];
+            std::cout << std::endl;
+            frameCounters.print(std::cout, "  last frame");
+            if (useLod && useDrawList)
+                drawList.culling.print(std::cout, "  last frame culling");
+            frameState.print(std::cout, "  state cache");
+            if (useLod && useIndirect)
+            {
+                std::cout << "  indirect: " << indirect.stats.instances << " instances, " << indirect.stats.commands << " commands in "
+                          << indirect.stats.drawCalls << " draw calls" << std::endl;
+                indirect.instanceUploadStats().print(std::cout, "  instance uploads");
+                indirect.instanceUploadStats().reset();
+            }
+            else if (useLod && useQueue)
+                std::cout << "  queue: " << queue.stats.packets << " packets, " << queue.stats.programChanges << " program, "
+                          << queue.stats.materialChanges << " material and " << queue.stats.vertexArrayChanges << " vertex array changes" << std::endl;
+            const UniformStats& uniformStats = ourShader.uniforms.stats;
+            std::cout << "  uniforms per frame: " << uniformStats.hits / frames << " set, " << uniformStats.skipped / frames
+                      << " skipped as unchanged, " << uniformStats.uploads / frames << " uploaded" << std::endl;
+            ourShader.uniforms.stats.reset();
+            std::cout << "  heap allocations while drawing the last frame: " << drawAllocations << std::endl;
+            statsTime = glfwGetTime();
+            frameTimeSum = 0.0;
+            submitTimeSum = 0.0;
+            frames = 0;
+        }
+
+        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        // -------------------------------------------------------------------------------
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    frame.release();
+    glfwTerminate();
+    return 0;
+}
+
+// the scene graph of a gridSize x gridSize grid: root is the first instance and every other one is its child
+// ---------------------------------------------------------------------------------------------------------
+void addGrid(Entity &root, Model &model)
+{
+    root.transform.setLocalScale(glm::vec3(0.05f));
+    for (int z = 0; z < gridSize; z++)
+    {
+        for (int x = 0; x < gridSize; x++)
+        {
+            if (x == 0 && z == 0)
+                continue;
+            root.addChild(model);
+            Entity* lastEntity = root.children.back().get();
+            // children inherit the root scale, so undo it for the placement
+            lastEntity->transform.setLocalPosition(glm::vec3(x * GRID_SPACING, 0.0f, -z * GRID_SPACING) / 0.05f);
+        }
+    }
+    root.updateSelfAndChild();
+}
+
+// draws a model loaded as separate meshes and the same model merged with MODEL_MERGE_MESHES once each
+// and prints the GL calls they took. False, with the reason printed, unless the merged copy issued one
+// multi draw per material and fewer texture binds than the separate meshes.
+// ----------------------------------------------------------------------------------------------------
+bool compareMergedDraws(Shader &shader, Model &separate, Model &merged, const string &name)
+{
+    shader.use();
+    shader.setMat4("model", glm::mat4(1.0f));
+    GLCallCounter::counters.reset();
+    separate.Draw(shader);
+    const GLCounters separateCounters = GLCallCounter::counters;
+    GLCallCounter::counters.reset();
+    merged.Draw(shader);
+    const GLCounters mergedCounters = GLCallCounter::counters;
+
+    const size_t materialCount = merged.batch.materials.size();
+    std::cout << name << ": " << separate.meshes.size() << " meshes, " << materialCount << " materials" << std::endl;
+    separateCounters.print(std::cout, "  per mesh");
+    mergedCounters.print(std::cout, "  merged  ");
+
+    // one multi draw per material, and each material's textures bound once instead of once per mesh
+    bool failed = false;
+    if (mergedCounters.drawCalls != materialCount)
+    {
+        std::cout << "FAILED: the merged model issued " << mergedCounters.drawCalls << " draws, expected one per material ("
+                  << materialCount << ")" << std::endl;
+        failed = true;
+    }
+    if (mergedCounters.textureBinds >= separateCounters.textureBinds)
+    {
+        std::cout << "FAILED: the merged model bound " << mergedCounters.textureBinds << " textures, drawn mesh by mesh "
+                  << separateCounters.textureBinds << std::endl;
+        failed = true;
+    }
+    return !failed;
+}
+
+// loads every model file below directory twice, keeping its CPU geometry and with MODEL_RELEASE_CPU_GEOMETRY, and
+// prints the RSS each load added, the RSS and peak RSS of the process after it and the CPU geometry the copy kept.
+// Each copy frees its GL objects before the next load, the allocator may keep the freed CPU memory resident.
+// ---------------------------------------------------------------------------------------------------------------
+void compareModelMemory(const string &directory)
+{
+    std::vector<string> paths;
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(directory))
+    {
+        const string extension = entry.path().extension().string();
+        if (entry.is_regular_file() && (extension == ".obj" || extension == ".dae" || extension == ".fbx" || extension == ".gltf"))
+            paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    for (const string &path : paths)
+    {
+        std::cout << path.substr(directory.size() + 1) << ":";
+        for (unsigned int flags : { 0u, static_cast<unsigned int>(MODEL_RELEASE_CPU_GEOMETRY) })
+        {
+            const MemoryUsage before = MemoryUsage::query();
+            Model model(path, false, flags);
+            const MemoryUsage after = MemoryUsage::query();
+            std::cout << (flags ? " released " : " kept ") << (after.currentBytes - std::min(before.currentBytes, after.currentBytes)) / 1024
+                      << " kB (RSS " << after.currentBytes / 1024 << " kB, peak " << after.peakBytes / 1024 << " kB, geometry "
+                      << model.cpuGeometryBytes() / 1024 << " kB)";
+            model.releaseGpuResources();
+        }
+        std::cout << std::endl;
+    }
+}
+
+// builds the same hierarchy of nodeCount nodes, every node i > 0 a child of node (i - 1) / 8, once as an Entity
+// tree and once in a TransformSystem, then times a full update and an update after moving one node in a hundred
+// -------------------------------------------------------------------------------------------------------------
+void compareTransformUpdates(Model &model, size_t nodeCount)
+{
+    typedef std::chrono::steady_clock Clock;
+    auto milliseconds = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    };
+
+    Entity root(model);
+    std::vector<Entity*> entities;
+    entities.reserve(nodeCount);
+    entities.push_back(&root);
+    TransformSystem system;
+    system.reserve(nodeCount);
+    system.add();
+    for (size_t i = 1; i < nodeCount; i++)
+    {
+        Entity* parent = entities[(i - 1) / 8];
+        parent->addChild(model);
+        entities.push_back(parent->children.back().get());
+        const TransformHandle node = system.add(static_cast<TransformHandle>((i - 1) / 8));
+
+        const glm::vec3 position(static_cast<float>(i % 8), 1.0f, 0.0f);
+        const glm::vec3 rotation(static_cast<float>(i % 30), static_cast<float>(i % 360), 0.0f);
+        entities[i]->transform.setLocalPosition(position);
+        entities[i]->transform.setLocalRotation(rotation);
+        system.setLocalPosition(node, position);
+        system.setLocalRotation(node, rotation);
+    }
+
+    Clock::time_point start = Clock::now();
+    root.forceUpdateSelfAndChild();
+    const double entityFull = milliseconds(start);
+    start = Clock::now();
+    system.update();
+    const double systemFull = milliseconds(start);
+    system.invalidate();
+    start = Clock::now();
+    system.update(&JobSystem::shared());
+    const double parallelFull = milliseconds(start);
+
+    // both sides have to agree before their timings mean anything
+    float maxError = 0.0f;
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        const glm::mat4 difference = entities[i]->transform.getModelMatrix() - system.getModelMatrix(static_cast<TransformHandle>(i));
+        for (int column = 0; column < 4; column++)
+            maxError = std::max(maxError, glm::length(difference[column]));
+    }
+
+    // a few nodes move, their subtrees follow
+    unsigned int moves = 0;
+    auto moveNodes = [&]() {
+        moves++;
+        for (size_t i = 1; i < nodeCount; i += 100)
+        {
+            const glm::vec3 position(static_cast<float>(i % 8), 1.0f + moves, 0.0f);
+            entities[i]->transform.setLocalPosition(position);
+            system.setLocalPosition(static_cast<TransformHandle>(i), position);
+        }
+    };
+    moveNodes();
+    start = Clock::now();
+    root.updateSelfAndChild();
+    const double entityPartial = milliseconds(start);
+    moveNodes();
+    start = Clock::now();
+    system.update();
+    const double systemPartial = milliseconds(start);
+    moveNodes();
+    start = Clock::now();
+    system.update(&JobSystem::shared());
+    const double parallelPartial = milliseconds(start);
+
+    std::cout << nodeCount << " transforms, " << JobSystem::shared().threadCount() << " threads, max difference " << maxError << std::endl;
+    std::cout << "  full update:    Entity " << entityFull << " ms, TransformSystem " << systemFull << " ms, parallel " << parallelFull << " ms" << std::endl;
+    std::cout << "  1% moved:       Entity " << entityPartial << " ms, TransformSystem " << systemPartial << " ms, parallel " << parallelPartial << " ms" << std::endl;
+}
+
+// the local matrix Transform built before it kept a quaternion: three glm::rotate and four 4x4 products
+glm::mat4 eulerModelMatrix(const glm::vec3& position, const glm::vec3& eulerDegrees, const glm::vec3& scale)
+{
+    const glm::mat4 transformX = glm::rotate(glm::mat4(1.0f), glm::radians(eulerDegrees.x), glm::vec3(1.0f, 0.0f, 0.0f));
+    const glm::mat4 transformY = glm::rotate(glm::mat4(1.0f), glm::radians(eulerDegrees.y), glm::vec3(0.0f, 1.0f, 0.0f));
+    const glm::mat4 transformZ = glm::rotate(glm::mat4(1.0f), glm::radians(eulerDegrees.z), glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::translate(glm::mat4(1.0f), position) * (transformY * transformX * transformZ) * glm::scale(glm::mat4(1.0f), scale);
+}
+
+// gives count transforms random local values below random parents, then compares the world matrices of
+// Transform with the euler angle matrices times the parent: largest difference and time to compute them all
+// -------------------------------------------------------------------------------------------------------------
+bool compareTransformMatrices(size_t count)
+{
+    typedef std::chrono::steady_clock Clock;
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    auto randomVector = [&](float low, float high) {
+        return glm::vec3(low + unit(random) * (high - low), low + unit(random) * (high - low), low + unit(random) * (high - low));
+    };
+
+    std::vector<glm::vec3> positions(count), rotations(count), scales(count);
+    std::vector<glm::mat4> parents(count), eulerMatrices(count);
+    std::vector<Transform> transforms(count);
+    float eulerError = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        positions[i] = randomVector(-100.0f, 100.0f);
+        // x stays off +-90 degrees, where euler angles lose a degree of freedom and the round trip is ambiguous
+        rotations[i] = glm::vec3(-89.0f + unit(random) * 178.0f, -179.0f + unit(random) * 358.0f, -179.0f + unit(random) * 358.0f);
+        scales[i] = randomVector(0.1f, 4.0f);
+        parents[i] = eulerModelMatrix(randomVector(-100.0f, 100.0f), randomVector(-180.0f, 180.0f), randomVector(0.1f, 4.0f));
+
+        transforms[i].setLocalPosition(positions[i]);
+        transforms[i].setLocalRotation(rotations[i]);
+        transforms[i].setLocalScale(scales[i]);
+        // the quaternion setter has to give back the same euler angles
+        Transform roundTrip;
+        roundTrip.setLocalRotation(transforms[i].getLocalOrientation());
+        eulerError = std::max(eulerError, glm::length(roundTrip.getLocalRotation() - rotations[i]));
+    }
+
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < count; i++)
+        eulerMatrices[i] = parents[i] * eulerModelMatrix(positions[i], rotations[i], scales[i]);
+    const double eulerTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    start = Clock::now();
+    for (size_t i = 0; i < count; i++)
+        transforms[i].computeModelMatrix(parents[i]);
+    const double quaternionTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+    // relative to the size of the matrix, positions reach a few hundred units
+    float matrixError = 0.0f;
+    for (size_t i = 0; i < count; i++)
+    {
+        const glm::mat4& matrix = transforms[i].getModelMatrix();
+        for (int column = 0; column < 4; column++)
+        {
+            const float scale = std::max(1.0f, glm::length(eulerMatrices[i][column]));
+            matrixError = std::max(matrixError, glm::length(matrix[column] - eulerMatrices[i][column]) / scale);
+        }
+    }
+    std::cout << count << " world matrices: euler angles " << eulerTime << " ms, quaternion " << quaternionTime
+              << " ms, largest relative difference " << matrixError << ", euler round trip " << eulerError << " degrees" << std::endl;
+    if (matrixError > 1e-5f)
+    {
+        std::cout << "FAILED: the world matrices differ by more than 1e-5" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// culls every entity of the scene against frustum, once through the virtual BoundingVolume of each entity and
+// once with the SIMD kernel over world boxes in arrays, and prints the throughput of both. Returns false when the
+// two don't keep the same entities.
+// -------------------------------------------------------------------------------------------------------------
+bool compareFrustumCulling(Entity &root, const Frustum &frustum)
+{
+    typedef std::chrono::steady_clock Clock;
+    auto nanoseconds = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    };
+    // a small scene culls in microseconds, repeat it to get above the clock resolution
+    const int repeats = 100;
+
+    std::vector<Entity*> entities{ &root };
+    for (size_t i = 0; i < entities.size(); i++)
+    {
+        for (auto&& child : entities[i]->children)
+            entities.push_back(child.get());
+    }
+
+    unsigned int virtualVisible = 0;
+    Clock::time_point start = Clock::now();
+    for (int repeat = 0; repeat < repeats; repeat++)
+    {
+        virtualVisible = 0;
+        for (Entity* entity : entities)
+            virtualVisible += entity->boundingVolume->isOnFrustum(frustum, entity->transform) ? 1 : 0;
+    }
+    const double virtualTime = nanoseconds(start);
+    // kept apart from the timed loop, which only counts
+    std::vector<uint32_t> virtualIndices;
+    for (size_t i = 0; i < entities.size(); i++)
+    {
+        if (entities[i]->boundingVolume->isOnFrustum(frustum, entities[i]->transform))
+            virtualIndices.push_back(static_cast<uint32_t>(i));
+    }
+
+    // the world boxes only change with the transforms, a scene that keeps them in arrays pays this once per move
+    CullingBoxes boxes;
+    start = Clock::now();
+    for (Entity* entity : entities)
+        boxes.add(*entity->boundingVolume, entity->transform.getModelMatrix());
+    const double buildTime = nanoseconds(start);
+
+    std::vector<uint32_t> visible;
+    start = Clock::now();
+    for (int repeat = 0; repeat < repeats; repeat++)
+        FrustumCulling::cull(frustum, boxes, visible);
+    const double kernelTime = nanoseconds(start);
+
+    const double tested = static_cast<double>(entities.size()) * repeats;
+    std::cout << "culling " << entities.size() << " boxes: virtual " << tested / virtualTime << " boxes/ns (" << virtualVisible
+              << " visible), SIMD x" << SIMD_LANES << " " << tested / kernelTime << " boxes/ns (" << visible.size()
+              << " visible), world boxes built in " << buildTime / 1000000.0 << " ms" << std::endl;
+    if (visible != virtualIndices)
+    {
+        std::cout << "FAILED: the SIMD kernel doesn't keep the same boxes as the virtual test" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// scatters 10k, 100k and 1M copies of instanceBox over a grid as dense as the scene's, then times frustum,
+// sphere and ray queries through a DynamicBVH against scanning every box, and updating the tree after one
+// box in a hundred moved. Returns false when a query through the tree doesn't find what the scan finds.
+// -------------------------------------------------------------------------------------------------------------
+bool compareSpatialQueries(const AABB &instanceBox, const Frustum &frustum)
+{
+    typedef std::chrono::steady_clock Clock;
+    auto microseconds = [](Clock::time_point start) {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    };
+    const float radius = 50.0f;
+    const glm::vec3 inverseFront = 1.0f / camera.Front;
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    bool same = true;
+
+    for (size_t count : { 10000, 100000, 1000000 })
+    {
+        // the same cost per query whatever the count, repeat the small ones to get above the clock resolution
+        const int repeats = static_cast<int>(std::max<size_t>(1, 1000000 / count));
+        const float side = std::sqrt(static_cast<float>(count)) * GRID_SPACING;
+        std::vector<BVHBox> boxes(count);
+        CullingBoxes soaBoxes;
+        for (BVHBox& box : boxes)
+        {
+            const glm::vec3 center(unit(random) * side, instanceBox.center.y, -unit(random) * side);
+            box = BVHBox(center - instanceBox.extents, center + instanceBox.extents);
+            soaBoxes.add(center, instanceBox.extents);
+        }
+
+        DynamicBVH tree;
+        std::vector<int32_t> proxies(count);
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < count; i++)
+            proxies[i] = tree.insert(boxes[i], static_cast<uint32_t>(i));
+        const double buildTime = microseconds(start) / 1000.0;
+
+        unsigned int treeVisible = 0;
+        tree.stats.reset();
+        start = Clock::now();
+        for (int repeat = 0; repeat < repeats; repeat++)
+        {
+            treeVisible = 0;
+            tree.queryFrustum(frustum, [&](uint32_t) { treeVisible++; });
+        }
+        const double treeFrustum = microseconds(start) / repeats;
+        const unsigned int frustumNodes = tree.stats.nodesVisited / repeats;
+        std::vector<uint32_t> visible;
+        start = Clock::now();
+        for (int repeat = 0; repeat < repeats; repeat++)
+            FrustumCulling::cull(frustum, soaBoxes, visible);
+        const double scanFrustum = microseconds(start) / repeats;
+
+        unsigned int treeNear = 0, scanNear = 0;
+        start = Clock::now();
+        for (int repeat = 0; repeat < repeats; repeat++)
+        {
+            treeNear = 0;
+            tree.querySphere(camera.Position, radius, [&](uint32_t) { treeNear++; });
+        }
+        const double treeSphere = microseconds(start) / repeats;
+        start = Clock::now();
+        for (int repeat = 0; repeat < repeats; repeat++)
+        {
+            scanNear = 0;
+            for (const BVHBox& box : boxes)
+                scanNear += box.overlapsSphere(camera.Position, radius) ? 1 : 0;
+        }
+        const double scanSphere = microseconds(start) / repeats;
+
+        // closest box along the view direction
+        float treeHit = std::numeric_limits<float>::max(), scanHit = treeHit;
+        start = Clock::now();
+        for (int repeat = 0; repeat < repeats; repeat++)
+        {
+            treeHit = std::numeric_limits<float>::max();
+            tree.raycast(camera.Position, camera.Front, treeHit, [&](uint32_t, float distance) {
+                treeHit = std::min(treeHit, distance);
+                return distance;
+            });
+        }
+        const double treeRay = microseconds(start) / repeats;
+        start = Clock::now();
+        for (int repeat = 0; repeat < repeats; repeat++)
+        {
+            scanHit = std::numeric_limits<float>::max();
+            for (const BVHBox& box : boxes)
+            {
+                float distance = 0.0f;
+                if (box.intersectsRay(camera.Position, inverseFront, scanHit, distance))
+                    scanHit = std::min(scanHit, distance);
+            }
+        }
+        const double scanRay = microseconds(start) / repeats;
+
+        // most moves stay inside the fat boxes, a few leave them and are reinserted
+        for (size_t i = 0; i < count; i += 100)
+        {
+            const glm::vec3 offset = glm::vec3(unit(random) - 0.5f, 0.0f, unit(random) - 0.5f) * (i % 1000 == 0 ? GRID_SPACING : 0.5f);
+            boxes[i] = BVHBox(boxes[i].min + offset, boxes[i].max + offset);
+        }
+        tree.stats.reset();
+        start = Clock::now();
+        for (size_t i = 0; i < count; i += 100)
+            tree.update(proxies[i], boxes[i]);
+        const double updateTime = microseconds(start);
+
+        std::cout << count << " entities: BVH built in " << buildTime << " ms, height " << tree.height() << std::endl;
+        std::cout << "  frustum: BVH " << treeFrustum << " us (" << treeVisible << " visible, " << frustumNodes << " nodes), SIMD scan "
+                  << scanFrustum << " us (" << visible.size() << " visible)" << std::endl;
+        std::cout << "  sphere:  BVH " << treeSphere << " us, scan " << scanSphere << " us (" << treeNear << "/" << scanNear << " boxes)" << std::endl;
+        std::cout << "  ray:     BVH " << treeRay << " us, scan " << scanRay << " us (closest " << treeHit << "/" << scanHit << ")" << std::endl;
+        std::cout << "  1% moved: " << updateTime << " us, " << tree.stats.reinserts << " reinserts" << std::endl;
+
+        // the tree tests the same boxes as the scans, so it has to find exactly what they find, after the move too
+        unsigned int movedVisible = 0;
+        tree.queryFrustum(frustum, [&](uint32_t) { movedVisible++; });
+        soaBoxes.clear();
+        for (const BVHBox& box : boxes)
+            soaBoxes.add(box.center(), box.extents());
+        std::vector<uint32_t> scanMovedVisible;
+        FrustumCulling::cull(frustum, soaBoxes, scanMovedVisible);
+        if (treeVisible != visible.size() || treeNear != scanNear || treeHit != scanHit || movedVisible != scanMovedVisible.size())
+        {
+            std::cout << "FAILED: the BVH queries of " << count << " entities don't match the scans (" << movedVisible << "/"
+                      << scanMovedVisible.size() << " visible after the move)" << std::endl;
+            same = false;
+        }
+    }
+    return same;
+}
+
+// builds the draw list of the current view with 1 to N threads, each thread count with its own JobSystem,
+// and prints the time per build and whether the list matches the single threaded one item for item. Returns
+// false if any thread count gave a different list.
+// --------------------------------------------------------------------------------------------------------
+bool compareVisibility(DrawList &drawList, const Frustum &frustum, const LodView &view)
+{
+    typedef std::chrono::steady_clock Clock;
+    const int repeats = 20;
+
+    // the first build settles the lod hysteresis, later builds of the same view pick the same levels
+    drawList.build(frustum, view);
+    const std::vector<DrawList::Item> reference = drawList.items;
+    double serialTime = 0.0;
+    bool allSame = true;
+    // a machine with fewer cores still builds it threaded
+    const unsigned int maxThreads = std::max(4u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; threads <= maxThreads; threads++)
+    {
+        JobSystem jobs(threads - 1);
+        const Clock::time_point start = Clock::now();
+        for (int repeat = 0; repeat < repeats; repeat++)
+            drawList.build(frustum, view, &jobs);
+        const double time = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / repeats;
+        if (threads == 1)
+            serialTime = time;
+
+        bool same = drawList.items.size() == reference.size();
+        for (size_t i = 0; same && i < reference.size(); i++)
+            same = drawList.items[i].entity == reference[i].entity && drawList.items[i].lod == reference[i].lod;
+        std::cout << "draw list of " << drawList.entityCount() << " entities on " << threads << " threads: " << time << " ms, x"
+                  << serialTime / time << ", " << drawList.items.size() << " visible, " << (same ? "same" : "DIFFERENT")
+                  << " as 1 thread" << std::endl;
+        allSame = allSame && same;
+    }
+    if (!allSame)
+        std::cout << "FAILED: the draw list depends on the thread count" << std::endl;
+    return allSame;
+}
+
+// Draws a quad with stubbed GL entry points (gl_stub.h), so no window or context is needed. Once the first draw
+// with each of two shaders resolved the material, alternating MaterialCache::get(...).bind(...) and Mesh::Draw
+// between them must not allocate.
+// -------------------------------------------------------------------------------------------------------------
+int checkDrawAllocations(unsigned int drawCount)
+{
+    // the uniforms of the scene shaders, the specular texture has no sampler in them and is left out
+    GLStub::activeUniforms = { "model", "texture_diffuse1" };
+    GLStub::install();
+    Shader shader("scene.vs", "scene.fs");
+    Shader instancedShader("scene_instanced.vs", "scene.fs");
+
+    vector<Vertex> vertices(4);
+    for (unsigned int i = 0; i < vertices.size(); i++)
+    {
+        vertices[i].Position = glm::vec3(static_cast<float>(i & 1), static_cast<float>(i >> 1), 0.0f);
+        vertices[i].Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+        vertices[i].TexCoords = glm::vec2(vertices[i].Position);
+    }
+    vector<Texture> textures = { { 1, TEXTURE_DIFFUSE, "diffuse.png" }, { 2, TEXTURE_SPECULAR, "specular.png" } };
+    Mesh mesh(std::move(vertices), { 0, 1, 2, 2, 1, 3 }, std::move(textures));
+    mesh.Draw(shader);
+    mesh.Draw(instancedShader);
+
+    const size_t allocationsBefore = allocationCount;
+    for (unsigned int i = 0; i < drawCount; i++)
+    {
+        Shader &program = i % 2 == 0 ? shader : instancedShader;
+        mesh.material.get(program, mesh.textures).bind(program);
+        mesh.Draw(program);
+    }
+    const size_t allocations = allocationCount - allocationsBefore;
+
+    const unsigned int samplerUploads = shader.uniforms.stats.uploads + instancedShader.uniforms.stats.uploads;
+    std::cout << drawCount << " binds and draws: " << allocations << " heap allocations, " << samplerUploads
+              << " sampler uploads in total" << std::endl;
+    bool failed = allocations != 0;
+    // a binding without its diffuse slot would pass without binding anything
+    for (const MaterialBinding &binding : mesh.material.bindings)
+    {
+        if (binding.slots.size() != 1)
+        {
+            std::cout << "FAILED: " << binding.slots.size() << " samplers resolved for shader " << binding.shaderId << ", expected 1" << std::endl;
+            failed = true;
+        }
+    }
+    if (mesh.material.bindings.size() != 2)
+    {
+        std::cout << "FAILED: " << mesh.material.bindings.size() << " material bindings, expected 2" << std::endl;
+        failed = true;
+    }
+    if (allocations != 0)
+        std::cout << "FAILED: the draw path allocated" << std::endl;
+    return failed ? 1 : 0;
+}
+
+// binds that got past the state cache to the stubs below it
+unsigned int driverBinds = 0;
+void APIENTRY countUseProgram(GLuint) { driverBinds++; }
+void APIENTRY countBindVertexArray(GLuint) { driverBinds++; }
+void APIENTRY countActiveTexture(GLenum) { driverBinds++; }
+void APIENTRY countBindTexture(GLenum, GLuint) { driverBinds++; }
+void APIENTRY countBindBuffer(GLenum, GLuint) { driverBinds++; }
+
+// Runs a scripted sequence of binds through GLStateCache installed over stubbed GL (gl_stub.h) and compares the
+// issued and filtered counts of every kind with the expected ones: repeated program, vertex array, texture and
+// buffer binds are dropped, the element buffer is bound again after a vertex array switch, and a deleted texture's
+// name is bound again. Every issued bind has to reach the stubs.
+// -----------------------------------------------------------------------------------------------------------------
+int checkStateCache()
+{
+    GLStub::install();
+    glad_glUseProgram = countUseProgram;
+    glad_glBindVertexArray = countBindVertexArray;
+    glad_glActiveTexture = countActiveTexture;
+    glad_glBindTexture = countBindTexture;
+    glad_glBindBuffer = countBindBuffer;
+    GLStateCache::install();
+    GLStateCache::stats.reset();
+
+    glUseProgram(1);
+    glUseProgram(1);                                // filtered
+    glUseProgram(2);
+
+    glBindVertexArray(10);
+    glBindVertexArray(10);                          // filtered
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 20);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 20);      // filtered
+    glBindBuffer(GL_ARRAY_BUFFER, 21);
+    glBindBuffer(GL_ARRAY_BUFFER, 21);              // filtered
+    glBindVertexArray(11);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 20);      // issued, the new vertex array has its own element buffer
+    glBindBuffer(GL_ARRAY_BUFFER, 21);              // filtered, not part of the vertex array
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 30);
+    glBindTexture(GL_TEXTURE_2D, 30);               // filtered
+    glActiveTexture(GL_TEXTURE0);                   // filtered
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 30);               // issued, another unit
+    const GLuint deleted = 30;
+    glDeleteTextures(1, &deleted);
+    glBindTexture(GL_TEXTURE_2D, 0);                // filtered, deleting reverted the binding to 0
+    glBindTexture(GL_TEXTURE_2D, 30);               // issued, the name may name a new texture now
+
+    struct Expected
+    {
+        const char* kind;
+        const GLStateCounter& counter;
+        unsigned int issued, filtered;
+    };
+    const GLStateStats& stats = GLStateCache::stats;
+    const Expected expected[] = {
+        { "program", stats.programs, 2, 1 },
+        { "vertex array", stats.vertexArrays, 2, 1 },
+        { "active texture", stats.activeTextures, 2, 1 },
+        { "texture", stats.textures, 3, 2 },
+        { "buffer", stats.buffers, 3, 3 },
+    };
+    stats.print(std::cout, "state cache");
+    bool failed = false;
+    unsigned int issued = 0;
+    for (const Expected& kind : expected)
+    {
+        issued += kind.counter.issued;
+        if (kind.counter.issued != kind.issued || kind.counter.filtered != kind.filtered)
+        {
+            std::cout << "FAILED: " << kind.kind << " binds " << kind.counter.issued << "/" << kind.counter.filtered
+                      << " issued/filtered, expected " << kind.issued << "/" << kind.filtered << std::endl;
+            failed = true;
+        }
+    }
+    if (driverBinds != issued)
+    {
+        std::cout << "FAILED: " << driverBinds << " binds reached GL, " << issued << " were issued" << std::endl;
+        failed = true;
+    }
+    GLStateCache::uninstall();
+    return failed ? 1 : 0;
+}
+
+// Runs compareMergedDraws on stubbed GL (gl_stub.h) with GLCallCounter on top, the model is a row of quads
+// alternating between two textured materials so the separate meshes rebind a texture on every draw.
+// -----------------------------------------------------------------------------------------------------------
+int checkMergedDraws()
+{
+    GLStub::activeUniforms = { "model", "texture_diffuse1" };
+    GLStub::install();
+    GLCallCounter::install();
+    Shader shader("scene.vs", "scene.fs");
+
+    const unsigned int meshCount = 8, materialCount = 2;
+    auto makeData = [&](unsigned int flags)
+    {
+        ModelData data;
+        data.flags = flags;
+        for (unsigned int i = 0; i < materialCount; i++)
+        {
+            ModelTextureData texture;
+            texture.path = "material" + std::to_string(i) + ".png";
+            texture.type = TEXTURE_DIFFUSE;
+            texture.decoded = true;
+            texture.width = texture.height = 1;
+            texture.components = 4;
+            texture.pixels.assign(4, static_cast<unsigned char>(255 * i));
+            data.textures.push_back(std::move(texture));
+        }
+        for (unsigned int i = 0; i < meshCount; i++)
+        {
+            data.meshes.emplace_back();
+            ModelMeshData &quad = data.meshes.back();
+            for (unsigned int corner = 0; corner < 4; corner++)
+            {
+                Vertex vertex;
+                vertex.Position = glm::vec3(static_cast<float>(i + (corner & 1)), static_cast<float>(corner >> 1), 0.0f);
+                vertex.Normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                vertex.TexCoords = glm::vec2(static_cast<float>(corner & 1), static_cast<float>(corner >> 1));
+                quad.vertices.push_back(vertex);
+            }
+            quad.indices = { 0, 1, 2, 2, 1, 3 };
+            quad.textures = { i % materialCount };
+        }
+        return data;
+    };
+    Model separate(makeData(0));
+    Model merged(makeData(MODEL_MERGE_MESHES));
+
+    const bool passed = compareMergedDraws(shader, separate, merged, "alternating quads");
+    if (merged.batch.materials.size() != materialCount)
+    {
+        std::cout << "FAILED: " << merged.batch.materials.size() << " merged materials, expected " << materialCount << std::endl;
+        return 1;
+    }
+    GLCallCounter::uninstall();
+    return passed ? 0 : 1;
+}
+
+// Runs the comparisons of the CPU side without a window. The grid is made of a sphere about as large as the scaled
+// model, with a level of detail chain, uploaded to stubbed GL (gl_stub.h) and seen from the start camera. Fails when
+// the Transform matrices differ from the euler angle ones by more than 1e-5, when the SIMD kernel or the BVH keep
+// other boxes than the scans they replace, or when a draw list built on more threads differs from the single
+// threaded one.
+// -----------------------------------------------------------------------------------------------------------------
+int checkCpu(size_t nodeCount)
+{
+    GLStub::install();
+    ModelData data;
+    data.flags = MODEL_GENERATE_LODS;
+    data.meshes.emplace_back();
+    ModelMeshData &sphere = data.meshes.back();
+    const unsigned int rings = 32, segments = 64;
+    const float radius = 20.0f;
+    for (unsigned int ring = 0; ring <= rings; ring++)
+    {
+        for (unsigned int segment = 0; segment <= segments; segment++)
+        {
+            const float theta = glm::pi<float>() * ring / rings, phi = glm::two_pi<float>() * segment / segments;
+            Vertex vertex;
+            vertex.Normal = glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            vertex.Position = vertex.Normal * radius + glm::vec3(0.0f, radius, 0.0f);
+            vertex.TexCoords = glm::vec2(static_cast<float>(segment) / segments, static_cast<float>(ring) / rings);
+            sphere.vertices.push_back(vertex);
+        }
+    }
+    for (unsigned int ring = 0; ring < rings; ring++)
+    {
+        for (unsigned int segment = 0; segment < segments; segment++)
+        {
+            const unsigned int first = ring * (segments + 1) + segment, below = first + segments + 1;
+            sphere.indices.insert(sphere.indices.end(), { first, below, first + 1, first + 1, below, below + 1 });
+        }
+    }
+    sphere.lodIndices = MeshSimplifier::generateLodChain(sphere.vertices, sphere.indices);
+    Model model(std::move(data));
+
+    Entity root(model);
+    addGrid(root, model);
+    DrawList drawList;
+    drawList.setScene(root);
+
+    // at the height of the boxes, looking diagonally across the grid, so the ray query hits one
+    camera.Position.y = 1.0f;
+    camera.ProcessMouseMovement(450.0f, 0.0f);
+    const float aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
+    const float fovY = glm::radians(camera.Zoom);
+    const Frustum frustum = createFrustumFromCamera(camera, aspect, fovY, 0.1f, 1000.0f);
+    LodView view;
+    view.cameraPosition = camera.Position;
+    view.fovY = fovY;
+
+    bool passed = compareTransformMatrices(nodeCount);
+    passed = compareFrustumCulling(root, frustum) && passed;
+    passed = compareSpatialQueries(root.getGlobalAABB(), frustum) && passed;
+    passed = compareVisibility(drawList, frustum, view) && passed;
+    return passed ? 0 : 1;
+}
+
+// process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+// ---------------------------------------------------------------------------------------------------------
+void processInput(GLFWwindow *window)
+{
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    camera.MovementSpeed = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS ? 60.0f : SPEED * 6.0f;
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    // L: toggle level of detail selection
+    static int lastLState = GLFW_RELEASE;
+    int lState = glfwGetKey(window, GLFW_KEY_L);
+    if (lState == GLFW_PRESS && lastLState == GLFW_RELEASE)
+        useLod = !useLod;
+    lastLState = lState;
+
+    // I: toggle multi draw indirect submission, it takes precedence over the queue (lod mode only)
+    static int lastIState = GLFW_RELEASE;
+    int iState = glfwGetKey(window, GLFW_KEY_I);
+    if (iState == GLFW_PRESS && lastIState == GLFW_RELEASE)
+        useIndirect = !useIndirect;
+    lastIState = iState;
+
+    // Q: toggle between drawing entities immediately and through the sorted render queue (lod mode only)
+    static int lastQState = GLFW_RELEASE;
+    int qState = glfwGetKey(window, GLFW_KEY_Q);
+    if (qState == GLFW_PRESS && lastQState == GLFW_RELEASE)
+        useQueue = !useQueue;
+    lastQState = qState;
+
+    // C: time frustum culling of the current view, per entity and with the SIMD kernel
+    static int lastCState = GLFW_RELEASE;
+    int cState = glfwGetKey(window, GLFW_KEY_C);
+    if (cState == GLFW_PRESS && lastCState == GLFW_RELEASE)
+        cullingRequested = true;
+    lastCState = cState;
+
+    // B: time BVH queries against scanning every box at 10k, 100k and 1M entities
+    static int lastBState = GLFW_RELEASE;
+    int bState = glfwGetKey(window, GLFW_KEY_B);
+    if (bState == GLFW_PRESS && lastBState == GLFW_RELEASE)
+        spatialRequested = true;
+    lastBState = bState;
+
+    // P: toggle between culling on the job system into a draw list and the recursive traversal (lod mode only)
+    static int lastPState = GLFW_RELEASE;
+    int pState = glfwGetKey(window, GLFW_KEY_P);
+    if (pState == GLFW_PRESS && lastPState == GLFW_RELEASE)
+        useDrawList = !useDrawList;
+    lastPState = pState;
+
+    // V: time building the draw list of the current view on 1 to N threads (lod mode only)
+    static int lastVState = GLFW_RELEASE;
+    int vState = glfwGetKey(window, GLFW_KEY_V);
+    if (vState == GLFW_PRESS && lastVState == GLFW_RELEASE)
+        visibilityRequested = true;
+    lastVState = vState;
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+// glfw: whenever the mouse moves, this callback is called
+// -------------------------------------------------------
+void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+    float xpos = static_cast<float>(xposIn);
+    float ypos = static_cast<float>(yposIn);
+
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // reversed since y-coordinates go from bottom to top
+
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// glfw: whenever the mouse scroll wheel scrolls, this callback is called
+// ----------------------------------------------------------------------
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    camera.ProcessMouseScroll(static_cast<float>(yoffset));
+}
@@ -0,0 +1,15 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Normal;
+in vec2 TexCoords;
+
+uniform sampler2D texture_diffuse1;
+
+void main()
+{
+    // fixed directional light so the silhouettes of the levels of detail stay readable
+    vec3 lightDir = normalize(vec3(0.4, 1.0, 0.3));
+    float diffuse = max(dot(normalize(Normal), lightDir), 0.0) * 0.8 + 0.2;
+    FragColor = vec4(texture(texture_diffuse1, TexCoords).rgb * diffuse, 1.0);
+}
@@ -0,0 +1,23 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+// per instance, see InstanceData in learnopengl/instance_buffer.h
+layout (location = 7) in mat4 aInstanceModel;
+
+out vec3 Normal;
+out vec2 TexCoords;
+
+// camera shared by every program (FrameUniforms in frame_uniforms.h), the lights declared after it aren't needed here
+layout (std140) uniform FrameData {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
+
+void main()
+{
+    Normal = mat3(aInstanceModel) * aNormal;
+    TexCoords = aTexCoords;
+    gl_Position = projection * view * aInstanceModel * vec4(aPos, 1.0);
+}
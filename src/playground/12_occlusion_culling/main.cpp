@@ -0,0 +1,195 @@
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/bvh.h>
+#include <learnopengl/frustum_culling.h>
+#include <learnopengl/occlusion_culling.h>
+#include <learnopengl/job_system.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Runs without a window or a GL context: a city of box buildings with small props in its streets, seen by a
+// camera walking down one of them. Every frame the buildings in view are rasterized into an OcclusionBuffer and
+// the boxes left by frustum culling are tested against it. The run is made twice, on one thread and spread over
+// a JobSystem, and prints the culled counts and the cost per frame of both.
+//
+// usage: 12_occlusion_culling [props] [frames] [depth.pgm]
+
+// settings
+const float ASPECT = 800.0f / 600.0f;
+const float FOV_Y = 45.0f;
+const float Z_NEAR = 0.1f;
+const float Z_FAR = 1000.0f;
+
+// city: CITY_BLOCKS x CITY_BLOCKS buildings with streets between them
+const int CITY_BLOCKS = 16;
+const float BLOCK_SPACING = 30.0f;
+const float BUILDING_SIZE = 20.0f;
+const float EYE_HEIGHT = 1.8f;
+
+struct City
+{
+    CullingBoxes boxes;        // the buildings first, then the props
+    size_t buildingCount = 0;
+};
+
+struct RunResult
+{
+    OcclusionStats occlusion;
+    double frustumMilliseconds = 0.0;
+    unsigned int inFrustum = 0;
+    unsigned int falselyOccluded = 0;
+};
+
+City buildCity(size_t propCount);
+Camera cameraAt(unsigned int frame, unsigned int frameCount);
+RunResult run(const City& city, unsigned int frameCount, JobSystem* jobs, bool verify, const char* imagePath);
+bool centerInSight(const City& city, const Frustum& frustum, const glm::vec3& eye, uint32_t box);
+
+int main(int argc, char* argv[])
+{
+    const size_t propCount = argc > 1 ? static_cast<size_t>(std::max(1, std::atoi(argv[1]))) : 20000;
+    const unsigned int frameCount = argc > 2 ? static_cast<unsigned int>(std::max(1, std::atoi(argv[2]))) : 240;
+    const char* imagePath = argc > 3 ? argv[3] : nullptr;
+
+    const City city = buildCity(propCount);
+    const OcclusionBuffer buffer;
+    std::cout << city.buildingCount << " buildings, " << propCount << " props, " << frameCount << " frames, "
+              << buffer.getWidth() << "x" << buffer.getHeight() << " depth buffer, " << SIMD_LANES << " SIMD lanes" << std::endl;
+
+    // the single threaded run also checks every occluded box against a ray cast through the buildings
+    const RunResult serial = run(city, frameCount, nullptr, true, imagePath);
+    const RunResult parallel = run(city, frameCount, &JobSystem::shared(), false, nullptr);
+
+    std::cout << "frustum culling: " << serial.inFrustum / frameCount << " boxes in view, "
+              << serial.frustumMilliseconds / frameCount << " ms" << std::endl;
+    serial.occlusion.print(std::cout, "occlusion, 1 thread");
+    const std::string label = "occlusion, " + std::to_string(JobSystem::shared().threadCount()) + " threads";
+    parallel.occlusion.print(std::cout, label.c_str());
+    std::cout << "occluded boxes whose center the eye can see: " << serial.falselyOccluded << std::endl;
+    return serial.falselyOccluded == 0 ? 0 : 1;
+}
+
+// buildings of random height on a grid, props scattered over the streets between them
+// -------------------------------------------------------------------------------------
+City buildCity(size_t propCount)
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    City city;
+    for (int z = 0; z < CITY_BLOCKS; z++)
+    {
+        for (int x = 0; x < CITY_BLOCKS; x++)
+        {
+            const float height = 8.0f + unit(random) * 52.0f;
+            const glm::vec3 min(x * BLOCK_SPACING, 0.0f, z * BLOCK_SPACING);
+            const glm::vec3 max = min + glm::vec3(BUILDING_SIZE, height, BUILDING_SIZE);
+            city.boxes.add((min + max) * 0.5f, (max - min) * 0.5f);
+        }
+    }
+    city.buildingCount = city.boxes.size();
+
+    const float side = CITY_BLOCKS * BLOCK_SPACING;
+    while (city.boxes.size() < city.buildingCount + propCount)
+    {
+        const glm::vec3 center(unit(random) * side, 1.0f, unit(random) * side);
+        if (std::fmod(center.x, BLOCK_SPACING) < BUILDING_SIZE + 0.5f && std::fmod(center.z, BLOCK_SPACING) < BUILDING_SIZE + 0.5f)
+            continue;
+        city.boxes.add(center, glm::vec3(0.5f, 1.0f, 0.5f));
+    }
+    return city;
+}
+
+// walks down the street between the middle columns of buildings, looking left and right
+// ---------------------------------------------------------------------------------------
+Camera cameraAt(unsigned int frame, unsigned int frameCount)
+{
+    const float t = static_cast<float>(frame) / frameCount;
+    const float street = (CITY_BLOCKS / 2 - 1) * BLOCK_SPACING + (BUILDING_SIZE + BLOCK_SPACING) * 0.5f;
+    const glm::vec3 position(street, EYE_HEIGHT, -10.0f + t * CITY_BLOCKS * BLOCK_SPACING);
+    const float yaw = 90.0f + 70.0f * std::sin(t * 4.0f * 3.14159265f);
+    return Camera(position, glm::vec3(0.0f, 1.0f, 0.0f), yaw, 0.0f);
+}
+
+RunResult run(const City& city, unsigned int frameCount, JobSystem* jobs, bool verify, const char* imagePath)
+{
+    RunResult result;
+    OcclusionBuffer occlusion;
+    std::vector<uint32_t> inFrustum, visible;
+    const glm::mat4 projection = glm::perspective(glm::radians(FOV_Y), ASPECT, Z_NEAR, Z_FAR);
+    for (unsigned int frame = 0; frame < frameCount; frame++)
+    {
+        Camera camera = cameraAt(frame, frameCount);
+        const auto start = std::chrono::steady_clock::now();
+        const Frustum frustum = createFrustumFromCamera(camera, ASPECT, glm::radians(FOV_Y), Z_NEAR, Z_FAR);
+        FrustumCulling::cull(frustum, city.boxes, inFrustum);
+        result.frustumMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        result.inFrustum += static_cast<unsigned int>(inFrustum.size());
+
+        // the buildings in view are the occluders, the indices come sorted so they are at the front
+        occlusion.beginFrame(projection * camera.GetViewMatrix());
+        for (uint32_t box : inFrustum)
+        {
+            if (box >= city.buildingCount)
+                break;
+            const glm::vec3 center(city.boxes.centerX[box], city.boxes.centerY[box], city.boxes.centerZ[box]);
+            const glm::vec3 extents(city.boxes.extentX[box], city.boxes.extentY[box], city.boxes.extentZ[box]);
+            occlusion.addBox(center - extents, center + extents);
+        }
+        occlusion.rasterize(jobs);
+        occlusion.cull(city.boxes, inFrustum, visible, jobs);
+
+        if (verify)
+        {
+            // visible comes sorted as well, every candidate missing from it was occluded
+            size_t next = 0;
+            for (uint32_t box : inFrustum)
+            {
+                if (next < visible.size() && visible[next] == box)
+                    next++;
+                else if (centerInSight(city, frustum, camera.Position, box))
+                    result.falselyOccluded++;
+            }
+        }
+    }
+    if (imagePath)
+        occlusion.writeImage(imagePath);
+    result.occlusion = occlusion.stats;
+    return result;
+}
+
+// whether the center of box is on screen and the segment from the eye to it passes no building, the box itself aside
+// -------------------------------------------------------------------------------------------------------------------
+bool centerInSight(const City& city, const Frustum& frustum, const glm::vec3& eye, uint32_t box)
+{
+    const glm::vec3 target(city.boxes.centerX[box], city.boxes.centerY[box], city.boxes.centerZ[box]);
+    for (const Plane* plane : { &frustum.leftFace, &frustum.rightFace, &frustum.topFace, &frustum.bottomFace, &frustum.nearFace, &frustum.farFace })
+    {
+        if (plane->getSignedDistanceToPlane(target) < 0.0f)
+            return false;
+    }
+    const glm::vec3 inverseDirection = 1.0f / (target - eye);
+    for (uint32_t building = 0; building < city.buildingCount; building++)
+    {
+        if (building == box)
+            continue;
+        const glm::vec3 center(city.boxes.centerX[building], city.boxes.centerY[building], city.boxes.centerZ[building]);
+        const glm::vec3 extents(city.boxes.extentX[building], city.boxes.extentY[building], city.boxes.extentZ[building]);
+        float distance = 0.0f;
+        // 1 is the whole segment
+        if (BVHBox(center - extents, center + extents).intersectsRay(eye, inverseDirection, 1.0f, distance))
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,14 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+flat in vec4 InstanceColor;
+
+uniform sampler2D texture_diffuse1;
+
+void main()
+{
+    vec4 sampled = texture(texture_diffuse1, TexCoords);
+    float alpha = (sampled.a == 0.0) ? 1.0 : sampled.a;
+    FragColor = vec4(sampled.rgb * InstanceColor.rgb, alpha * InstanceColor.a);
+}
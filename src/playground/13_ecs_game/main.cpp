@@ -0,0 +1,661 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/shader_m.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+#include <learnopengl/ecs.h>
+#include <learnopengl/ecs_systems.h>
+#include <learnopengl/frame_uniforms.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/job_system.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The assignment 3 game (drive the car over the coins) with every object an entity of a World: the ground, the
+// walls, the car and the coins are only components, and the frame is a list of systems over their chunks.
+//
+// usage: 13_ecs_game [coins]                  plays, printing the time of every system each second
+//        13_ecs_game --headless [coins] [frames]  runs the systems without a window on 1 to N threads
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// half size of the ground, the walls stand on its border
+const float PLANE_SIZE = 50.0f;
+const float WALL_HEIGHT = 6.0f;
+const float WALL_THICKNESS = 1.0f;
+
+// coins
+const float COIN_SCALE = 0.75f;
+const float COIN_RADIUS = 0.5f * COIN_SCALE;
+const float COIN_HEIGHT = 1.0f;
+
+// gameplay components
+// -------------------
+struct Vehicle
+{
+    glm::vec3 position{ 0.0f, 0.5f, 0.0f };
+    glm::vec3 front{ 1.0f, 0.0f, 0.0f };
+    float yaw = 0.0f;
+    float velocity = 0.0f;
+    float maxSpeed = 15.0f;
+    float accel = 16.0f;
+    float brake = 18.0f;
+    float friction = 2.5f;
+    float scale = 0.01f;
+    glm::vec3 modelCenter{ 0.0f };  // the model turns around it
+    glm::vec3 forwardLocal{ 0.0f }; // model space direction of travel
+    float radius = 0.01f;           // collection radius in world units
+};
+
+struct Coin
+{
+    int value = 1;
+};
+
+// what the systems cost, summed over the frames since the last print
+struct SystemTimes
+{
+    double animate = 0.0;
+    double gameplay = 0.0;
+    double transforms = 0.0;
+    double bounds = 0.0;
+    double culling = 0.0;
+    double extraction = 0.0;
+    unsigned int frames = 0;
+
+    void reset()
+    {
+        *this = SystemTimes();
+    }
+
+    void print(std::ostream& out, const char* label) const
+    {
+        const double n = std::max(1u, frames);
+        out << label << ": animate " << animate / n << " ms, gameplay " << gameplay / n << " ms, transforms " << transforms / n
+            << " ms, bounds " << bounds / n << " ms, culling " << culling / n << " ms, extraction " << extraction / n << " ms" << std::endl;
+    }
+};
+
+// milliseconds body takes
+template <typename Body>
+double timed(Body&& body)
+{
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void steerVehicle(GLFWwindow* window, Vehicle& vehicle, float deltaTime);
+void moveVehicle(World& world, EntityId car, float deltaTime);
+void spawnCoins(World& world, int count, const Renderable& renderable, const LocalBounds& bounds, std::mt19937& random);
+int collectCoins(World& world, const glm::vec3& position, float radius, std::vector<EntityId>& collected);
+void followVehicle(const Vehicle& vehicle, float deltaTime);
+int runHeadless(int coinCount, unsigned int frameCount);
+unsigned int createWhiteTexture();
+unsigned int createVertexArray(const float* vertices, size_t size);
+
+// camera
+Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
+bool cameraAttached = true;
+float lastX = SCR_WIDTH / 2.0f;
+float lastY = SCR_HEIGHT / 2.0f;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+enum CameraSide { SIDE_REAR = 0, SIDE_LEFT = 1, SIDE_RIGHT = 2 };
+CameraSide cameraSide = SIDE_REAR;
+bool lookBack = false;
+
+// position, normal, texture coordinates
+const float PLANE_VERTICES[] = {
+    -PLANE_SIZE, 0.0f, -PLANE_SIZE,  0.0f, 1.0f, 0.0f,  0.0f, PLANE_SIZE,
+     PLANE_SIZE, 0.0f, -PLANE_SIZE,  0.0f, 1.0f, 0.0f,  PLANE_SIZE, PLANE_SIZE,
+     PLANE_SIZE, 0.0f,  PLANE_SIZE,  0.0f, 1.0f, 0.0f,  PLANE_SIZE, 0.0f,
+
+    -PLANE_SIZE, 0.0f, -PLANE_SIZE,  0.0f, 1.0f, 0.0f,  0.0f, PLANE_SIZE,
+     PLANE_SIZE, 0.0f,  PLANE_SIZE,  0.0f, 1.0f, 0.0f,  PLANE_SIZE, 0.0f,
+    -PLANE_SIZE, 0.0f,  PLANE_SIZE,  0.0f, 1.0f, 0.0f,  0.0f, 0.0f
+};
+
+const float CUBE_VERTICES[] = {
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
+
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f, 0.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f, 0.0f,
+
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+     0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
+
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+     0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
+    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
+
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+     0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
+     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
+    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
+    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], "--headless") == 0)
+    {
+        const int coinCount = argc > 2 ? std::max(1, std::atoi(argv[2])) : 100000;
+        const unsigned int frameCount = argc > 3 ? static_cast<unsigned int>(std::max(1, std::atoi(argv[3]))) : 300;
+        return runHeadless(coinCount, frameCount);
+    }
+    // an optional coin count turns the game into a benchmark of its systems
+    const bool benchmark = argc > 1;
+    const int coinCount = benchmark ? std::max(1, std::atoi(argv[1])) : 50;
+
+    // glfw: initialize and configure
+    // ------------------------------
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "ECS game", NULL, NULL);
+    if (window == NULL)
+    {
+        std::cout << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+    if (benchmark)
+        glfwSwapInterval(0);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+
+    glEnable(GL_DEPTH_TEST);
+
+    // shaders, models and textures
+    // ----------------------------
+    Shader ourShader("shader.vs", "shader.fs");
+    Shader instancedShader("instanced.vs", "instanced.fs");
+    FrameUniforms frame;
+    Model carModel(FileSystem::getPath("resources/objects/f1/f1.obj"), false, MODEL_OPTIMIZE_INDICES | MODEL_MERGE_MESHES);
+    Model coinModel(FileSystem::getPath("resources/objects/coin/Coin.obj"), false, MODEL_OPTIMIZE_INDICES);
+    const unsigned int whiteTexture = createWhiteTexture();
+    const unsigned int groundTexture = TextureFromFile("smooth-stone.png", FileSystem::getPath("resources/textures"));
+    const unsigned int planeVAO = createVertexArray(PLANE_VERTICES, sizeof(PLANE_VERTICES));
+    const unsigned int cubeVAO = createVertexArray(CUBE_VERTICES, sizeof(CUBE_VERTICES));
+
+    // the world: ground, walls, car and coins
+    // ---------------------------------------
+    World world;
+    Renderable ground;
+    ground.shader = &ourShader;
+    ground.texture = groundTexture;
+    ground.VAO = planeVAO;
+    ground.count = 6;
+    world.create(LocalTransform(), WorldTransform(), LocalBounds{ glm::vec3(0.0f), glm::vec3(PLANE_SIZE, 0.0f, PLANE_SIZE) },
+                 WorldBounds(), Visibility(), ground);
+
+    Renderable wall = ground;
+    wall.VAO = cubeVAO;
+    wall.count = 36;
+    const float wallOffset = PLANE_SIZE + WALL_THICKNESS * 0.5f;
+    const glm::vec3 wallPositions[] = { { 0.0f, 0.0f, -wallOffset }, { 0.0f, 0.0f, wallOffset }, { -wallOffset, 0.0f, 0.0f }, { wallOffset, 0.0f, 0.0f } };
+    for (int i = 0; i < 4; i++)
+    {
+        LocalTransform transform;
+        transform.position = wallPositions[i] + glm::vec3(0.0f, WALL_HEIGHT * 0.5f, 0.0f);
+        transform.scale = i < 2 ? glm::vec3(PLANE_SIZE * 2.0f, WALL_HEIGHT, WALL_THICKNESS) : glm::vec3(WALL_THICKNESS, WALL_HEIGHT, PLANE_SIZE * 2.0f);
+        world.create(transform, WorldTransform(), LocalBounds{ glm::vec3(0.0f), glm::vec3(0.5f) }, WorldBounds(), Visibility(), wall);
+    }
+
+    // the model measured its center, radius and principal axis at load
+    Vehicle vehicle;
+    vehicle.modelCenter = carModel.bounds.center();
+    vehicle.radius = carModel.bounds.boxCenterRadius * vehicle.scale;
+    glm::vec3 axis = carModel.bounds.principalAxis;
+    axis.y = 0.0f;
+    if (glm::length(axis) > 1e-3f)
+        vehicle.forwardLocal = glm::normalize(axis);
+    Renderable car;
+    car.model = &carModel;
+    car.shader = &ourShader;
+    car.texture = whiteTexture; // for car meshes without textures
+    const EntityId carEntity = world.create(LocalTransform(), WorldTransform(), LocalBounds{ carModel.bounds.center(), carModel.bounds.extents() },
+                                            WorldBounds(), Visibility(), car, vehicle);
+
+    Renderable coin;
+    coin.model = &coinModel;
+    coin.shader = &instancedShader;
+    coin.texture = whiteTexture;
+    coin.instanced = true;
+    const LocalBounds coinBounds{ coinModel.bounds.center(), coinModel.bounds.extents() };
+    std::mt19937 random(static_cast<unsigned int>(std::time(nullptr)));
+    spawnCoins(world, coinCount, coin, coinBounds, random);
+
+    // systems
+    // -------
+    JobSystem& jobs = JobSystem::shared();
+    CullingSystem culling;
+    RenderExtraction extraction;
+    RenderQueue queue;
+    std::vector<EntityId> collected;
+    SystemTimes times;
+    double statsTime = glfwGetTime();
+    int score = 0;
+    int lastCState = GLFW_RELEASE;
+    int lastBState = GLFW_RELEASE;
+
+    // names set every frame, hashed at compile time
+    static constexpr UniformName useColorUniform("useColor");
+
+    while (!glfwWindowShouldClose(window))
+    {
+        const float currentFrame = static_cast<float>(glfwGetTime());
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        // input
+        // -----
+        if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(window, true);
+        const int cState = glfwGetKey(window, GLFW_KEY_C);
+        if (cState == GLFW_PRESS && lastCState == GLFW_RELEASE)
+            cameraSide = static_cast<CameraSide>((cameraSide + 1) % 3);
+        lastCState = cState;
+        const int bState = glfwGetKey(window, GLFW_KEY_B);
+        if (bState == GLFW_PRESS && lastBState == GLFW_RELEASE)
+            cameraAttached = !cameraAttached;
+        lastBState = bState;
+        lookBack = glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS; // held to look forward from camera
+        steerVehicle(window, *world.get<Vehicle>(carEntity), deltaTime);
+
+        // systems
+        // -------
+        times.animate += timed([&]() { EcsSystems::animate(world, currentFrame, &jobs); });
+        times.gameplay += timed([&]()
+        {
+            moveVehicle(world, carEntity, deltaTime);
+            const Vehicle& driven = *world.get<Vehicle>(carEntity);
+            const int newly = collectCoins(world, driven.position, driven.radius, collected);
+            if (newly > 0)
+            {
+                score += newly;
+                const std::string title = "ECS game - Score: " + std::to_string(score);
+                glfwSetWindowTitle(window, title.c_str());
+                std::cout << "Collected " << newly << " coin(s). Score=" << score << std::endl;
+            }
+            if (world.count<Coin>() == 0)
+            {
+                spawnCoins(world, coinCount, coin, coinBounds, random);
+                std::cout << "All coins collected! Respawning..." << std::endl;
+            }
+        });
+        times.transforms += timed([&]() { EcsSystems::updateTransforms(world, &jobs); });
+        times.bounds += timed([&]() { EcsSystems::updateBounds(world, &jobs); });
+        if (cameraAttached)
+            followVehicle(*world.get<Vehicle>(carEntity), deltaTime);
+        const float aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
+        const Frustum frustum = createFrustumFromCamera(camera, aspect, glm::radians(camera.Zoom), 0.1f, 100.0f);
+        times.culling += timed([&]() { culling.run(world, frustum, &jobs); });
+        times.extraction += timed([&]() { extraction.extract(world, &jobs); });
+        times.frames++;
+
+        // render
+        // ------
+        glClearColor(0.80f, 0.90f, 1.00f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        frame.data.projection = glm::perspective(glm::radians(camera.Zoom), aspect, 0.1f, 100.0f);
+        frame.data.view = camera.GetViewMatrix();
+        frame.data.viewPos = camera.Position;
+        frame.upload();
+        ourShader.use();
+        ourShader.setBool(useColorUniform, false);
+        queue.setCamera(camera.Position, 100.0f);
+        extraction.submit(queue);
+        queue.flush();
+
+        if (benchmark && glfwGetTime() - statsTime >= 1.0)
+        {
+            std::cout << world.size() << " entities in " << world.archetypeCount() << " archetypes, " << world.count<Coin>()
+                      << " coins, " << extraction.drawCount() << " drawn" << std::endl;
+            times.print(std::cout, "  systems");
+            culling.stats.print(std::cout, "  culling");
+            extraction.printUploadStats(std::cout, "  instances");
+            times.reset();
+            statsTime = glfwGetTime();
+        }
+
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    frame.release();
+    glfwTerminate();
+    return 0;
+}
+
+// throttle, brake and steering of the car
+// ---------------------------------------
+void steerVehicle(GLFWwindow* window, Vehicle& vehicle, float deltaTime)
+{
+    const bool pressW = glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS;
+    const bool pressS = glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS;
+    const bool pressA = glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS;
+    const bool pressD = glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS;
+
+    if (pressW)
+        vehicle.velocity += vehicle.accel * deltaTime;
+    else if (pressS)
+        vehicle.velocity -= (vehicle.velocity > 0.0f ? vehicle.brake : vehicle.brake * 0.5f) * deltaTime;
+    else if (vehicle.velocity > 0.0f)
+        vehicle.velocity = std::max(0.0f, vehicle.velocity - vehicle.friction * deltaTime);
+    else if (vehicle.velocity < 0.0f)
+        vehicle.velocity = std::min(0.0f, vehicle.velocity + vehicle.friction * deltaTime);
+
+    float steer = 0.0f;
+    if (pressA)
+        steer += 1.0f;
+    if (pressD)
+        steer -= 1.0f;
+    const float speedFactor = glm::clamp(std::fabs(vehicle.velocity) > 0.01f ? std::fabs(vehicle.velocity) / vehicle.maxSpeed : 0.0f, 0.05f, 1.0f);
+    vehicle.yaw += steer * 90.0f * speedFactor * deltaTime;
+}
+
+// moves the car inside the walls and writes its transform: turning around the model center and scaling the
+// model is a rotation about the origin plus the offset position + center - rotation * center
+// ------------------------------------------------------------------------------------------------------------
+void moveVehicle(World& world, EntityId car, float deltaTime)
+{
+    Vehicle& vehicle = *world.get<Vehicle>(car);
+    vehicle.velocity = glm::clamp(vehicle.velocity, -vehicle.maxSpeed * 0.5f, vehicle.maxSpeed);
+    const glm::quat rotation = glm::angleAxis(glm::radians(vehicle.yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::vec3 moveFront = rotation * vehicle.forwardLocal;
+    moveFront.y = 0.0f;
+    moveFront = glm::length(moveFront) < 1e-6f ? glm::vec3(0.0f, 0.0f, -1.0f) : glm::normalize(moveFront);
+    vehicle.position += -moveFront * vehicle.velocity * deltaTime;
+    vehicle.position.x = glm::clamp(vehicle.position.x, -PLANE_SIZE + 0.5f, PLANE_SIZE - 0.5f);
+    vehicle.position.z = glm::clamp(vehicle.position.z, -PLANE_SIZE + 0.5f, PLANE_SIZE - 0.5f);
+    vehicle.position.y = 0.5f;
+    vehicle.front = moveFront;
+
+    LocalTransform& transform = *world.get<LocalTransform>(car);
+    transform.rotation = rotation;
+    transform.scale = glm::vec3(vehicle.scale);
+    transform.position = vehicle.position + vehicle.modelCenter - rotation * vehicle.modelCenter;
+}
+
+// coins spread over the ground, one in five worth two
+// ---------------------------------------------------
+void spawnCoins(World& world, int count, const Renderable& renderable, const LocalBounds& bounds, std::mt19937& random)
+{
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int i = 0; i < count; i++)
+    {
+        const float x = unit(random) * 60.0f - 20.0f;
+        const float z = unit(random) * 60.0f - 20.0f;
+        Coin coin;
+        coin.value = unit(random) < 0.2f ? 2 : 1;
+        Bob bob;
+        bob.baseHeight = COIN_HEIGHT;
+        bob.amplitude = 0.04f + unit(random) * 0.08f;
+        bob.frequency = 2.0f + unit(random) * 3.0f;
+        bob.phase = unit(random) * 2.0f * glm::pi<float>();
+        Spin spin;
+        spin.degreesPerSecond = 180.0f;
+        LocalTransform transform;
+        transform.position = glm::vec3(x, COIN_HEIGHT, z);
+        transform.scale = glm::vec3(COIN_SCALE);
+        Renderable tinted = renderable;
+        tinted.color = coin.value == 2 ? glm::vec4(1.0f, 0.85f, 0.0f, 1.0f) : glm::vec4(1.0f, 1.0f, 0.0f, 1.0f);
+        world.create(transform, WorldTransform(), bounds, WorldBounds(), Visibility(), tinted, coin, bob, spin);
+    }
+}
+
+// destroys the coins the car touches and returns their value. They are collected while walking the chunks
+// and destroyed after, destroying moves rows around.
+// --------------------------------------------------------------------------------------------------------
+int collectCoins(World& world, const glm::vec3& position, float radius, std::vector<EntityId>& collected)
+{
+    const float threshold = radius + COIN_RADIUS + 0.05f;
+    const glm::vec2 carXZ(position.x, position.z);
+    int value = 0;
+    collected.clear();
+    world.each<LocalTransform, Coin>([&](size_t count, const EntityId* ids, const LocalTransform* transforms, const Coin* coins)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (glm::distance(carXZ, glm::vec2(transforms[i].position.x, transforms[i].position.z)) < threshold)
+            {
+                collected.push_back(ids[i]);
+                value += coins[i].value;
+            }
+        }
+    });
+    for (EntityId coin : collected)
+        world.destroy(coin);
+    return value;
+}
+
+// smoothly moves the camera behind or beside the car
+// --------------------------------------------------
+void followVehicle(const Vehicle& vehicle, float deltaTime)
+{
+    const glm::vec3 worldUp(0.0f, 1.0f, 0.0f);
+    const glm::vec3 carRight = glm::normalize(glm::cross(vehicle.front, worldUp));
+    const float rearDist = 6.0f;
+    const float sideDist = 4.0f;
+
+    glm::vec3 camOffset;
+    if (cameraSide == SIDE_REAR)
+        camOffset = (lookBack ? -vehicle.front : vehicle.front) * rearDist + glm::vec3(0.0f, 2.0f, 0.0f);
+    else if (cameraSide == SIDE_LEFT)
+        camOffset = -carRight * sideDist + glm::vec3(0.0f, 1.6f, 0.0f);
+    else
+        camOffset = carRight * sideDist + glm::vec3(0.0f, 1.6f, 0.0f);
+
+    const glm::vec3 desiredCamPos = vehicle.position + camOffset;
+    const float smoothTime = 0.09f;
+    const float alpha = deltaTime > 0.0f ? 1.0f - std::exp(-deltaTime / smoothTime) : 0.0f;
+    camera.Position = glm::mix(camera.Position, desiredCamPos, alpha);
+    const glm::vec3 desiredFront = lookBack ? glm::normalize(vehicle.front)
+                                            : glm::normalize((vehicle.position + worldUp) - desiredCamPos);
+    camera.Front = glm::normalize(glm::mix(camera.Front, desiredFront, alpha));
+    camera.Right = glm::normalize(glm::cross(camera.Front, camera.WorldUp));
+    camera.Up = glm::normalize(glm::cross(camera.Right, camera.Front));
+}
+
+// The systems of the game without a window: the car drives in circles over coinCount coins for frameCount
+// frames of 1/60 s, once per thread count from 1 to the hardware threads. Every run starts from the same
+// coins, so they all have to end with the same score and the same draw count.
+// --------------------------------------------------------------------------------------------------------
+int runHeadless(int coinCount, unsigned int frameCount)
+{
+    const unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    const float deltaTime = 1.0f / 60.0f;
+    const float aspect = (float)SCR_WIDTH / (float)SCR_HEIGHT;
+    int firstScore = -1;
+    size_t firstDraws = 0;
+    bool consistent = true;
+    for (unsigned int threads = 1; threads <= maxThreads; threads++)
+    {
+        JobSystem jobs(threads - 1);
+        World world;
+        Vehicle vehicle;
+        vehicle.forwardLocal = glm::vec3(1.0f, 0.0f, 0.0f);
+        vehicle.radius = 1.0f;
+        vehicle.velocity = vehicle.maxSpeed;
+        Renderable car;
+        const EntityId carEntity = world.create(LocalTransform(), WorldTransform(), LocalBounds{ glm::vec3(0.0f), glm::vec3(100.0f) },
+                                                WorldBounds(), Visibility(), car, vehicle);
+        // no model is loaded, the coins get the box of a unit coin
+        Renderable coin;
+        coin.instanced = true;
+        const LocalBounds coinBounds{ glm::vec3(0.0f), glm::vec3(0.5f, 0.05f, 0.5f) };
+        std::mt19937 random(1);
+        spawnCoins(world, coinCount, coin, coinBounds, random);
+
+        CullingSystem culling;
+        RenderExtraction extraction;
+        std::vector<EntityId> collected;
+        SystemTimes times;
+        int score = 0;
+        size_t draws = 0;
+        for (unsigned int frame = 0; frame < frameCount; frame++)
+        {
+            const float time = frame * deltaTime;
+            world.get<Vehicle>(carEntity)->yaw += 45.0f * deltaTime;
+            times.animate += timed([&]() { EcsSystems::animate(world, time, &jobs); });
+            times.gameplay += timed([&]()
+            {
+                moveVehicle(world, carEntity, deltaTime);
+                const Vehicle& driven = *world.get<Vehicle>(carEntity);
+                score += collectCoins(world, driven.position, driven.radius, collected);
+            });
+            times.transforms += timed([&]() { EcsSystems::updateTransforms(world, &jobs); });
+            times.bounds += timed([&]() { EcsSystems::updateBounds(world, &jobs); });
+            followVehicle(*world.get<Vehicle>(carEntity), deltaTime);
+            const Frustum frustum = createFrustumFromCamera(camera, aspect, glm::radians(45.0f), 0.1f, 100.0f);
+            times.culling += timed([&]() { culling.run(world, frustum, &jobs); });
+            times.extraction += timed([&]() { extraction.extract(world, &jobs); });
+            times.frames++;
+            draws += extraction.drawCount();
+        }
+        // the camera follows the car from where the previous run left it otherwise
+        camera = Camera(glm::vec3(0.0f, 0.0f, 3.0f));
+
+        if (threads == 1)
+        {
+            std::cout << world.size() << " entities in " << world.archetypeCount() << " archetypes, " << frameCount << " frames, "
+                      << score << " collected, " << draws / frameCount << " drawn per frame" << std::endl;
+            firstScore = score;
+            firstDraws = draws;
+        }
+        else if (score != firstScore || draws != firstDraws)
+        {
+            consistent = false;
+        }
+        const std::string label = std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+        times.print(std::cout, label.c_str());
+    }
+    std::cout << (consistent ? "every thread count gave the same result" : "ERROR::ECS:: thread counts disagree") << std::endl;
+    return consistent ? 0 : 1;
+}
+
+// a 1x1 white texture, for meshes without one
+// -------------------------------------------
+unsigned int createWhiteTexture()
+{
+    const unsigned char whitePixel[4] = { 255, 255, 255, 255 };
+    unsigned int texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, whitePixel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+// vertex array of interleaved position, normal and texture coordinates
+// --------------------------------------------------------------------
+unsigned int createVertexArray(const float* vertices, size_t size)
+{
+    unsigned int VAO, VBO;
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glBindVertexArray(VAO);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+    return VAO;
+}
+
+// glfw: whenever the window size changed (by OS or user resize) this callback function executes
+// ---------------------------------------------------------------------------------------------
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    glViewport(0, 0, width, height);
+}
+
+// glfw: whenever the mouse moves, this callback is called, the free camera looks around with it
+// ---------------------------------------------------------------------------------------------
+void mouse_callback(GLFWwindow* window, double xposIn, double yposIn)
+{
+    const float xpos = static_cast<float>(xposIn);
+    const float ypos = static_cast<float>(yposIn);
+    if (firstMouse)
+    {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+    const float xoffset = xpos - lastX;
+    const float yoffset = lastY - ypos;
+    lastX = xpos;
+    lastY = ypos;
+    if (!cameraAttached)
+        camera.ProcessMouseMovement(xoffset, yoffset);
+}
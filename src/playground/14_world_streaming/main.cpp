@@ -0,0 +1,453 @@
+#include <glm/glm.hpp>
+
+#include <learnopengl/ecs.h>
+#include <learnopengl/ecs_systems.h>
+#include <learnopengl/filesystem.h>
+#include <learnopengl/gl_stub.h>
+#include <learnopengl/model_cell_loader.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/world_streaming.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Runs without a window or a GL context: a world of WORLD_CELLS x WORLD_CELLS cells, each with a few dozen
+// objects of generated meshes and textures, streamed in and out around a camera flying a scripted figure of
+// eight over it. The loader builds the geometry and pixels on the streaming thread (after a simulated disk
+// read), and finish turns every object into an entity of a World. It prints what the streamer did and checks
+// that the memory budget held and that the entities match the resident cells.
+//
+// With --models the cells hold the bundled models instead, streamed by ModelCellLoader: the files are imported
+// and their textures decoded on the streaming thread, and finish uploads them through stubbed GL entry points
+// (gl_stub.h). Every frame the entities are extracted and drawn through a RenderQueue on the same stubs.
+//
+// usage: 14_world_streaming [frames] [memory budget in MB] [manifest]
+//        a manifest file is read instead of generating the world, and written when it doesn't exist
+//        14_world_streaming --models [frames] [memory budget in MB]
+
+// settings
+const int WORLD_CELLS = 64;
+const float CELL_SIZE = 50.0f;
+const float FRAME_SECONDS = 1.0f / 60.0f;
+const float CAMERA_SPEED = 40.0f;     // units per second along the path
+const int DISK_MILLISECONDS = 3;      // simulated read of one cell
+
+// floats per vertex: position, normal and texture coordinates
+const size_t VERTEX_FLOATS = 8;
+
+// the world of --models, smaller since every cell reads real files
+const int MODEL_WORLD_CELLS = 12;
+const char* const MODEL_PATHS[] = { "resources/objects/coin/Coin.obj", "resources/objects/maria/maria.dae", "resources/objects/mixamo/kachujin.dae" };
+const char* const TEXTURE_PATHS[] = { "-", "resources/textures/smooth-stone.png" };
+const unsigned int MODEL_FLAGS = MODEL_OPTIMIZE_INDICES | MODEL_RELEASE_CPU_GEOMETRY;
+
+// what the loader read for one cell. The meshes and pixels are released as objects are finished, the memory
+// of the cell is then what the GPU would hold for it.
+struct GeneratedCell : public CellPayload
+{
+    struct Object
+    {
+        std::vector<float> vertices;
+        std::vector<unsigned char> pixels;
+        LocalBounds bounds;
+        size_t uploadedBytes = 0;
+    };
+
+    std::vector<Object> objects;
+    std::vector<EntityId> entities;
+    size_t finished = 0;
+
+    size_t bytes() const override
+    {
+        size_t total = 0;
+        for (const Object& object : objects)
+            total += object.vertices.capacity() * sizeof(float) + object.pixels.capacity() + object.uploadedBytes;
+        return total;
+    }
+};
+
+// "box:<vertices>" meshes and "checker:<size>" textures, generated instead of read from files
+class GeneratedCellLoader : public CellLoader
+{
+public:
+    World& world;
+
+    explicit GeneratedCellLoader(World& world) : world(world)
+    {
+    }
+
+    std::unique_ptr<CellPayload> load(const CellManifest& cell) override
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(DISK_MILLISECONDS));
+        std::unique_ptr<GeneratedCell> payload(new GeneratedCell());
+        payload->objects.resize(cell.objects.size());
+        for (size_t i = 0; i < cell.objects.size(); i++)
+        {
+            GeneratedCell::Object& object = payload->objects[i];
+            generateMesh(cell.objects[i].mesh, object);
+            generateTexture(cell.objects[i].texture, object);
+        }
+        return payload;
+    }
+
+    // one object at a time: "uploads" its data and creates its entity
+    bool finish(const CellManifest& cell, CellPayload& payload, std::chrono::steady_clock::time_point deadline) override
+    {
+        GeneratedCell& generated = static_cast<GeneratedCell&>(payload);
+        while (generated.finished < generated.objects.size())
+        {
+            GeneratedCell::Object& object = generated.objects[generated.finished];
+            const ManifestObject& placement = cell.objects[generated.finished];
+            object.uploadedBytes = object.vertices.size() * sizeof(float) + object.pixels.size();
+            std::vector<float>().swap(object.vertices);
+            std::vector<unsigned char>().swap(object.pixels);
+
+            LocalTransform transform;
+            transform.position = placement.position;
+            transform.rotation = glm::angleAxis(glm::radians(placement.yaw), glm::vec3(0.0f, 1.0f, 0.0f));
+            transform.scale = glm::vec3(placement.scale);
+            generated.entities.push_back(world.create(transform, WorldTransform(), object.bounds, WorldBounds(), Visibility()));
+            generated.finished++;
+            if (std::chrono::steady_clock::now() >= deadline)
+                break;
+        }
+        return generated.finished == generated.objects.size();
+    }
+
+    void unload(const CellManifest&, CellPayload& payload) override
+    {
+        GeneratedCell& generated = static_cast<GeneratedCell&>(payload);
+        for (EntityId entity : generated.entities)
+            world.destroy(entity);
+        generated.entities.clear();
+    }
+
+private:
+    // vertices scattered in a unit box, the bounds are measured from them like a model's
+    static void generateMesh(const std::string& name, GeneratedCell::Object& object)
+    {
+        const size_t count = static_cast<size_t>(std::max(3, std::atoi(name.c_str() + name.find(':') + 1)));
+        std::mt19937 random(static_cast<unsigned int>(count));
+        std::uniform_real_distribution<float> unit(-0.5f, 0.5f);
+        object.vertices.resize(count * VERTEX_FLOATS);
+        glm::vec3 min(1.0f), max(-1.0f);
+        for (size_t i = 0; i < count; i++)
+        {
+            float* vertex = &object.vertices[i * VERTEX_FLOATS];
+            const glm::vec3 position(unit(random), unit(random) + 0.5f, unit(random));
+            const glm::vec3 normal = glm::normalize(position + glm::vec3(0.0f, -0.5f, 0.0f) + glm::vec3(1e-3f));
+            vertex[0] = position.x, vertex[1] = position.y, vertex[2] = position.z;
+            vertex[3] = normal.x, vertex[4] = normal.y, vertex[5] = normal.z;
+            vertex[6] = position.x + 0.5f, vertex[7] = position.z + 0.5f;
+            min = glm::min(min, position);
+            max = glm::max(max, position);
+        }
+        object.bounds.center = (min + max) * 0.5f;
+        object.bounds.extents = (max - min) * 0.5f;
+    }
+
+    static void generateTexture(const std::string& name, GeneratedCell::Object& object)
+    {
+        const size_t size = static_cast<size_t>(std::max(1, std::atoi(name.c_str() + name.find(':') + 1)));
+        object.pixels.resize(size * size * 4);
+        for (size_t y = 0; y < size; y++)
+        {
+            for (size_t x = 0; x < size; x++)
+            {
+                const unsigned char value = ((x / 8 + y / 8) % 2) ? 255 : 64;
+                unsigned char* pixel = &object.pixels[(y * size + x) * 4];
+                pixel[0] = pixel[1] = pixel[2] = value;
+                pixel[3] = 255;
+            }
+        }
+    }
+};
+
+WorldManifest generateWorld();
+WorldManifest generateModelWorld();
+int runModels(unsigned int frameCount, const StreamingSettings& settings);
+int stream(const WorldManifest& manifest, CellLoader& loader, World& world, const StreamingSettings& settings, unsigned int frameCount,
+           int worldCells, const std::function<void()>& draw);
+void printWorld(const WorldManifest& manifest, const StreamingSettings& settings);
+glm::vec3 cameraAt(float seconds, int worldCells);
+size_t manifestObjects(const WorldManifest& manifest, const WorldStreamer& streamer);
+
+int main(int argc, char* argv[])
+{
+    const bool models = argc > 1 && std::strcmp(argv[1], "--models") == 0;
+    if (models)
+    {
+        argc--;
+        argv++;
+    }
+    const unsigned int frameCount = argc > 1 ? static_cast<unsigned int>(std::max(1, std::atoi(argv[1]))) : 3600;
+    StreamingSettings settings;
+    // the model world is smaller, so is its default budget
+    settings.memoryBudget = static_cast<size_t>(argc > 2 ? std::max(1, std::atoi(argv[2])) : models ? 32 : 160) << 20;
+    if (models)
+        return runModels(frameCount, settings);
+
+    // the generated world goes through the text format, so what is streamed is what a file would hold
+    WorldManifest manifest;
+    if (argc > 3 && manifest.load(argv[3]))
+    {
+        std::cout << "manifest read from " << argv[3] << std::endl;
+    }
+    else
+    {
+        std::stringstream text;
+        generateWorld().write(text);
+        if (!manifest.read(text))
+            return 1;
+        if (argc > 3)
+            manifest.save(argv[3]);
+    }
+    printWorld(manifest, settings);
+
+    World world;
+    GeneratedCellLoader loader(world);
+    return stream(manifest, loader, world, settings, frameCount, WORLD_CELLS, nullptr);
+}
+
+// streams the bundled models on stubbed GL and draws them every frame
+// -------------------------------------------------------------------
+int runModels(unsigned int frameCount, const StreamingSettings& settings)
+{
+    // the uniforms of model.vs and model.fs
+    GLStub::activeUniforms = { "model", "texture_diffuse1", "useColor", "objectColor" };
+    GLStub::install();
+    Shader shader("model.vs", "model.fs");
+
+    const WorldManifest manifest = generateModelWorld();
+    printWorld(manifest, settings);
+
+    World world;
+    ModelCellLoader loader(world, shader, FileSystem::getPath(""), MODEL_FLAGS);
+    RenderExtraction extraction;
+    RenderQueue queue;
+    size_t draws = 0;
+    const int result = stream(manifest, loader, world, settings, frameCount, MODEL_WORLD_CELLS, [&]()
+    {
+        extraction.extract(world);
+        extraction.submit(queue);
+        queue.flush();
+        draws += queue.stats.packets;
+    });
+    std::cout << draws / frameCount << " packets drawn per frame" << std::endl;
+    return result;
+}
+
+// Flies the camera over the world for frameCount frames, updating the streamer and the systems every frame and
+// calling draw when it is set. Returns 1 if the entities don't match the resident cells once the streamer settled,
+// or when the memory budget was exceeded.
+// ----------------------------------------------------------------------------------------------------------------
+int stream(const WorldManifest& manifest, CellLoader& loader, World& world, const StreamingSettings& settings, unsigned int frameCount,
+           int worldCells, const std::function<void()>& draw)
+{
+    unsigned int framesWithoutCameraCell = 0;
+    bool withinBudget = true;
+    {
+        WorldStreamer streamer(manifest, loader, settings);
+        StreamingStats total;
+        for (unsigned int frame = 0; frame < frameCount; frame++)
+        {
+            const glm::vec3 position = cameraAt(frame * FRAME_SECONDS, worldCells);
+            streamer.update(position);
+            // the streamed entities are live, the systems run over them like over any other
+            EcsSystems::updateTransforms(world);
+            EcsSystems::updateBounds(world);
+            if (draw)
+                draw();
+
+            // the first second is allowed to load the start
+            if (frame > 60 && !streamer.isResident(manifest.cellAt(position)))
+                framesWithoutCameraCell++;
+            withinBudget = withinBudget && streamer.bytes() <= settings.memoryBudget;
+            if (streamer.stats.frames == 600 || frame + 1 == frameCount)
+            {
+                std::cout << "frame " << frame + 1 << ": " << streamer.residentCount() << " cells resident, " << world.size()
+                          << " entities, " << streamer.bytes() / 1024 << " kB" << std::endl;
+                streamer.stats.print(std::cout, "  streaming");
+                total.requested += streamer.stats.requested;
+                total.loaded += streamer.stats.loaded;
+                total.unloaded += streamer.stats.unloaded;
+                total.dropped += streamer.stats.dropped;
+                total.evicted += streamer.stats.evicted;
+                total.peakBytes = std::max(total.peakBytes, streamer.stats.peakBytes);
+                streamer.stats.reset();
+            }
+            // paced like a game at 60 frames per second, so the streaming thread keeps up as it would there
+            std::this_thread::sleep_for(std::chrono::microseconds(static_cast<int>(FRAME_SECONDS * 1e6f) / 4));
+        }
+
+        // stop where the path ended and wait for the streamer to settle
+        const glm::vec3 position = cameraAt(frameCount * FRAME_SECONDS, worldCells);
+        for (int wait = 0; wait < 10000 && !streamer.idle(); wait++)
+        {
+            streamer.update(position);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const size_t expected = manifestObjects(manifest, streamer);
+        std::cout << "settled: " << streamer.residentCount() << " cells resident with " << expected << " objects, " << world.size()
+                  << " entities" << std::endl;
+        std::cout << "in all: " << total.requested << " requested, " << total.loaded << " loaded, " << total.unloaded << " unloaded, "
+                  << total.dropped << " dropped, " << total.evicted << " evicted, peak " << total.peakBytes / 1024 << " kB, "
+                  << framesWithoutCameraCell << " frames with the camera's cell missing" << std::endl;
+        if (expected != world.size())
+        {
+            std::cout << "ERROR::WORLD_STREAMING:: entities don't match the resident cells" << std::endl;
+            return 1;
+        }
+    }
+    if (world.size() != 0)
+    {
+        std::cout << "ERROR::WORLD_STREAMING:: entities left after the streamer was destroyed" << std::endl;
+        return 1;
+    }
+    if (!withinBudget)
+    {
+        std::cout << "ERROR::WORLD_STREAMING:: memory budget exceeded" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+void printWorld(const WorldManifest& manifest, const StreamingSettings& settings)
+{
+    size_t objectCount = 0, worldBytes = 0;
+    for (const CellManifest& cell : manifest.cells)
+    {
+        objectCount += cell.objects.size();
+        worldBytes += cell.estimatedBytes;
+    }
+    std::cout << manifest.cells.size() << " cells, " << objectCount << " objects, " << worldBytes / (1024 * 1024) << " MB in all, budget "
+              << settings.memoryBudget / (1024 * 1024) << " MB, " << settings.frameMilliseconds << " ms per frame" << std::endl;
+}
+
+// every cell gets 20 to 60 objects, each with its own mesh and texture size
+// -------------------------------------------------------------------------
+WorldManifest generateWorld()
+{
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    WorldManifest manifest;
+    manifest.cellSize = CELL_SIZE;
+    for (int z = 0; z < WORLD_CELLS; z++)
+    {
+        for (int x = 0; x < WORLD_CELLS; x++)
+        {
+            CellManifest cell;
+            cell.coord = { x, z };
+            const int count = 20 + static_cast<int>(unit(random) * 41.0f);
+            for (int i = 0; i < count; i++)
+            {
+                const int vertices = 500 + static_cast<int>(unit(random) * 4000.0f);
+                const int textureSize = 32 << static_cast<int>(unit(random) * 3.0f);
+                ManifestObject object;
+                object.mesh = "box:" + std::to_string(vertices);
+                object.texture = "checker:" + std::to_string(textureSize);
+                object.position = glm::vec3((x + unit(random)) * CELL_SIZE, 0.0f, (z + unit(random)) * CELL_SIZE);
+                object.yaw = unit(random) * 360.0f;
+                object.scale = 1.0f + unit(random) * 4.0f;
+                cell.objects.push_back(object);
+                cell.estimatedBytes += vertices * VERTEX_FLOATS * sizeof(float) + textureSize * textureSize * 4;
+            }
+            manifest.add(cell);
+        }
+    }
+    return manifest;
+}
+
+// every cell gets 4 to 12 of the bundled models, some with a texture of their own. The estimate of a cell is what
+// its files take once read, each file measured once here.
+// -------------------------------------------------------------------------------------------------------------
+WorldManifest generateModelWorld()
+{
+    const std::string root = FileSystem::getPath("");
+    std::vector<size_t> modelBytes, textureBytes;
+    for (const char* path : MODEL_PATHS)
+    {
+        ModelData data;
+        data.read(root + "/" + path, MODEL_FLAGS, true);
+        modelBytes.push_back(data.bytes());
+    }
+    for (const char* path : TEXTURE_PATHS)
+    {
+        ModelTextureData texture;
+        texture.path = path;
+        if (texture.path != "-")
+            texture.decode(root);
+        textureBytes.push_back(texture.pixels.size());
+    }
+
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    const size_t modelCount = sizeof(MODEL_PATHS) / sizeof(MODEL_PATHS[0]);
+    const size_t textureCount = sizeof(TEXTURE_PATHS) / sizeof(TEXTURE_PATHS[0]);
+    WorldManifest manifest;
+    manifest.cellSize = CELL_SIZE;
+    for (int z = 0; z < MODEL_WORLD_CELLS; z++)
+    {
+        for (int x = 0; x < MODEL_WORLD_CELLS; x++)
+        {
+            CellManifest cell;
+            cell.coord = { x, z };
+            std::vector<bool> modelUsed(modelCount, false), textureUsed(textureCount, false);
+            const int count = 4 + static_cast<int>(unit(random) * 9.0f);
+            for (int i = 0; i < count; i++)
+            {
+                const size_t model = std::min(modelCount - 1, static_cast<size_t>(unit(random) * modelCount));
+                const size_t texture = std::min(textureCount - 1, static_cast<size_t>(unit(random) * textureCount));
+                ManifestObject object;
+                object.mesh = MODEL_PATHS[model];
+                object.texture = TEXTURE_PATHS[texture];
+                object.position = glm::vec3((x + unit(random)) * CELL_SIZE, 0.0f, (z + unit(random)) * CELL_SIZE);
+                object.yaw = unit(random) * 360.0f;
+                object.scale = 1.0f + unit(random) * 4.0f;
+                cell.objects.push_back(object);
+                if (!modelUsed[model])
+                    cell.estimatedBytes += modelBytes[model];
+                if (!textureUsed[texture])
+                    cell.estimatedBytes += textureBytes[texture];
+                modelUsed[model] = textureUsed[texture] = true;
+            }
+            manifest.add(cell);
+        }
+    }
+    return manifest;
+}
+
+// a figure of eight over most of a world of worldCells x worldCells cells
+// -------------------------------------------------------------------------
+glm::vec3 cameraAt(float seconds, int worldCells)
+{
+    const float half = worldCells * CELL_SIZE * 0.5f;
+    const float radius = half * 0.8f;
+    // the parameter advances at about CAMERA_SPEED units per second along the curve
+    const float t = seconds * CAMERA_SPEED / (radius * 1.5f);
+    return glm::vec3(half + radius * std::sin(t), 10.0f, half + radius * std::sin(t) * std::cos(t));
+}
+
+// objects of the resident cells
+// -----------------------------
+size_t manifestObjects(const WorldManifest& manifest, const WorldStreamer& streamer)
+{
+    size_t count = 0;
+    for (const CellManifest& cell : manifest.cells)
+    {
+        if (streamer.isResident(cell.coord))
+            count += cell.objects.size();
+    }
+    return count;
+}
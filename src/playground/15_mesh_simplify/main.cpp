@@ -0,0 +1,179 @@
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/mesh_simplify.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Runs without a window or a GL context: a rolling heightfield with a uv seam down its middle is turned into a
+// LOD chain by MeshSimplifier, and every level is checked. A level has to stay within its triangle target, no
+// triangle may flip (on a heightfield every triangle faces up), and every border and seam vertex has to still be
+// used, so the outline and the seam are where they were. Prints the triangles of each level and the time of the
+// chain, and exits with 1 when a check fails. Triangles squeezed edge-on, seen from above, are counted but not a failure.
+//
+// usage: 15_mesh_simplify [grid]
+
+// settings
+const float CELL_SIZE = 1.0f;
+const float HEIGHT = 4.0f;
+
+struct Heightfield
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    std::vector<bool> locked; // what the simplifier has to keep: the border and both sides of the seam
+};
+
+Heightfield buildHeightfield(int grid);
+unsigned int checkLevel(const Heightfield& field, const std::vector<unsigned int>& level, size_t target);
+
+int main(int argc, char* argv[])
+{
+    // below 32 cells the locked border alone holds more triangles than the coarsest target
+    const int grid = argc > 1 ? std::max(32, std::atoi(argv[1])) : 100;
+
+    const Heightfield field = buildHeightfield(grid);
+    std::cout << grid << "x" << grid << " heightfield, " << field.vertices.size() << " vertices, "
+              << field.indices.size() / 3 << " triangles" << std::endl;
+
+    unsigned int failures = 0;
+    const std::vector<bool> locked = MeshSimplifier::findLockedVertices(field.vertices, field.indices);
+    if (locked != field.locked)
+    {
+        std::cout << "FAILED: the locked vertices are not the border and the seam" << std::endl;
+        failures++;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<std::vector<unsigned int>> chain = MeshSimplifier::generateLodChain(field.vertices, field.indices);
+    const double chainMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (chain.size() != MAX_MESH_LODS - 1)
+    {
+        std::cout << "FAILED: " << chain.size() << " of " << MAX_MESH_LODS - 1 << " levels generated" << std::endl;
+        failures++;
+    }
+    for (size_t level = 0; level < chain.size(); level++)
+    {
+        const size_t target = (field.indices.size() >> (level + 1)) / 3 * 3;
+        std::cout << "level " << level + 1 << ": " << chain[level].size() / 3 << " triangles, target " << target / 3 << std::endl;
+        failures += checkLevel(field, chain[level], target);
+    }
+    std::cout << "chain: " << chainMilliseconds << " ms" << std::endl;
+
+    // without an error budget the simplifier has to reach a much lower target and still keep the outline
+    const size_t coarseTarget = (field.indices.size() / 64) / 3 * 3;
+    const std::vector<unsigned int> coarse = MeshSimplifier::simplify(field.vertices, field.indices, coarseTarget, 1e30f);
+    std::cout << "unbounded error: " << coarse.size() / 3 << " triangles, target " << coarseTarget / 3 << std::endl;
+    failures += checkLevel(field, coarse, field.indices.size());
+
+    std::cout << (failures == 0 ? "all checks passed" : "checks failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+// (grid + 1) x (grid + 1) vertices over rolling hills, the column in the middle is split in two vertices with
+// different texture coordinates the way an uv seam comes out of an importer
+// -------------------------------------------------------------------------------------------------------------
+Heightfield buildHeightfield(int grid)
+{
+    Heightfield field;
+    const int seam = grid / 2;
+    std::vector<unsigned int> left((grid + 1) * (grid + 1)), right((grid + 1) * (grid + 1));
+    for (int z = 0; z <= grid; z++)
+    {
+        for (int x = 0; x <= grid; x++)
+        {
+            Vertex vertex = {};
+            vertex.Position = glm::vec3(x * CELL_SIZE, 0.0f, z * CELL_SIZE);
+            vertex.Position.y = HEIGHT * std::sin(x * 0.11f) * std::cos(z * 0.07f) + 0.5f * HEIGHT * std::sin((x + z) * 0.05f);
+            vertex.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            vertex.TexCoords = glm::vec2(static_cast<float>(x) / grid, static_cast<float>(z) / grid);
+            const bool border = x == 0 || z == 0 || x == grid || z == grid;
+
+            const unsigned int index = static_cast<unsigned int>(field.vertices.size());
+            left[z * (grid + 1) + x] = right[z * (grid + 1) + x] = index;
+            field.vertices.push_back(vertex);
+            field.locked.push_back(border || x == seam);
+            if (x == seam)
+            {
+                // the right half maps to a separate part of the texture
+                vertex.TexCoords.x += 1.0f;
+                right[z * (grid + 1) + x] = index + 1;
+                field.vertices.push_back(vertex);
+                field.locked.push_back(true);
+            }
+        }
+    }
+
+    // two triangles per cell, counter-clockwise seen from above
+    for (int z = 0; z < grid; z++)
+    {
+        for (int x = 0; x < grid; x++)
+        {
+            const std::vector<unsigned int>& corners = x < seam ? left : right;
+            const unsigned int a = corners[z * (grid + 1) + x];
+            const unsigned int b = corners[z * (grid + 1) + x + 1];
+            const unsigned int c = corners[(z + 1) * (grid + 1) + x];
+            const unsigned int d = corners[(z + 1) * (grid + 1) + x + 1];
+            field.indices.insert(field.indices.end(), { a, c, b, b, c, d });
+        }
+    }
+    return field;
+}
+
+// the number of failed checks of one level, each one is printed
+// ---------------------------------------------------------------
+unsigned int checkLevel(const Heightfield& field, const std::vector<unsigned int>& level, size_t target)
+{
+    unsigned int failures = 0;
+    if (level.size() > target || level.size() % 3 != 0)
+    {
+        std::cout << "FAILED: " << level.size() / 3 << " triangles, over the target of " << target / 3 << std::endl;
+        failures++;
+    }
+
+    unsigned int flipped = 0, edgeOn = 0, degenerate = 0;
+    std::vector<bool> used(field.vertices.size(), false);
+    for (size_t i = 0; i + 2 < level.size(); i += 3)
+    {
+        const unsigned int a = level[i], b = level[i + 1], c = level[i + 2];
+        if (a == b || b == c || a == c)
+        {
+            degenerate++;
+            continue;
+        }
+        used[a] = used[b] = used[c] = true;
+        const glm::vec3& p0 = field.vertices[a].Position;
+        const glm::vec3 normal = glm::cross(field.vertices[b].Position - p0, field.vertices[c].Position - p0);
+        if (normal.y < 0.0f)
+            flipped++;
+        else if (normal.y == 0.0f)
+            edgeOn++;
+    }
+    if (edgeOn > 0)
+        std::cout << "  " << edgeOn << " triangles standing on edge" << std::endl;
+    if (flipped > 0 || degenerate > 0)
+    {
+        std::cout << "FAILED: " << flipped << " flipped and " << degenerate << " degenerate triangles" << std::endl;
+        failures++;
+    }
+
+    unsigned int lost = 0;
+    for (size_t v = 0; v < field.vertices.size(); v++)
+    {
+        if (field.locked[v] && !used[v])
+            lost++;
+    }
+    if (lost > 0)
+    {
+        std::cout << "FAILED: " << lost << " border or seam vertices were collapsed" << std::endl;
+        failures++;
+    }
+    return failures;
+}
@@ -0,0 +1,145 @@
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/mesh_optimizer.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Runs without a window or a GL context: a flat grid is run through MeshOptimizer::optimizeMesh twice, once in the
+// row by row order a generator writes it and once with its triangles shuffled the way a poorly ordered import comes
+// in. Both times the ACMR and the ATVR of the simulated vertex cache have to go down, and the optimized mesh has to
+// hold exactly the triangles it was given with the same winding: reordering may rotate a triangle's corners and
+// move vertices around, nothing else. Prints the ratios before and after and the time of each run, and exits with
+// 1 when a check fails.
+//
+// usage: 16_mesh_optimize [grid]
+
+struct Grid
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// a triangle by the positions of its corners, in winding order
+typedef std::array<float, 9> Triangle;
+
+Grid buildGrid(int grid);
+std::vector<Triangle> triangles(const Grid& mesh);
+unsigned int checkOptimize(const char* label, const Grid& input);
+
+int main(int argc, char* argv[])
+{
+    // two rows of a smaller grid fit in the simulated cache, in row order there is nothing left to improve
+    const int grid = argc > 1 ? std::max(16, std::atoi(argv[1])) : 100;
+    const Grid rows = buildGrid(grid);
+    std::cout << grid << "x" << grid << " grid, " << rows.vertices.size() << " vertices, "
+              << rows.indices.size() / 3 << " triangles" << std::endl;
+
+    unsigned int failures = checkOptimize("row order", rows);
+
+    // whole triangles are shuffled, each keeps its corners in order
+    Grid shuffled = rows;
+    std::vector<unsigned int> order(shuffled.indices.size() / 3);
+    for (unsigned int i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(1));
+    for (size_t i = 0; i < order.size(); i++)
+        std::copy(rows.indices.begin() + order[i] * 3, rows.indices.begin() + order[i] * 3 + 3, shuffled.indices.begin() + i * 3);
+    failures += checkOptimize("shuffled", shuffled);
+
+    std::cout << (failures == 0 ? "all checks passed" : "checks failed") << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+// (grid + 1) x (grid + 1) vertices on the xz plane, two triangles per cell written row by row
+// --------------------------------------------------------------------------------------------
+Grid buildGrid(int grid)
+{
+    Grid mesh;
+    for (int z = 0; z <= grid; z++)
+    {
+        for (int x = 0; x <= grid; x++)
+        {
+            Vertex vertex = {};
+            vertex.Position = glm::vec3(static_cast<float>(x), 0.0f, static_cast<float>(z));
+            vertex.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            vertex.TexCoords = glm::vec2(static_cast<float>(x) / grid, static_cast<float>(z) / grid);
+            mesh.vertices.push_back(vertex);
+        }
+    }
+    // counter-clockwise seen from above
+    for (int z = 0; z < grid; z++)
+    {
+        for (int x = 0; x < grid; x++)
+        {
+            const unsigned int a = z * (grid + 1) + x, b = a + 1, c = a + grid + 1, d = c + 1;
+            mesh.indices.insert(mesh.indices.end(), { a, c, b, b, c, d });
+        }
+    }
+    return mesh;
+}
+
+// every triangle of mesh rotated to start at its smallest corner, which keeps the winding, and sorted
+// -----------------------------------------------------------------------------------------------------
+std::vector<Triangle> triangles(const Grid& mesh)
+{
+    std::vector<Triangle> result;
+    result.reserve(mesh.indices.size() / 3);
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        std::array<std::array<float, 3>, 3> corners;
+        for (int corner = 0; corner < 3; corner++)
+        {
+            const glm::vec3& p = mesh.vertices[mesh.indices[i + corner]].Position;
+            corners[corner] = { p.x, p.y, p.z };
+        }
+        std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+        Triangle triangle;
+        for (int corner = 0; corner < 3; corner++)
+            std::copy(corners[corner].begin(), corners[corner].end(), triangle.begin() + corner * 3);
+        result.push_back(triangle);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+// optimizes a copy of input, the number of failed checks is returned and each one is printed
+// --------------------------------------------------------------------------------------------
+unsigned int checkOptimize(const char* label, const Grid& input)
+{
+    Grid optimized = input;
+    std::vector<BoneVertex> boneData;
+    VertexCacheStats before, after;
+    const auto start = std::chrono::steady_clock::now();
+    MeshOptimizer::optimizeMesh(optimized.vertices, optimized.indices, boneData, &before, &after);
+    const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    before.print(std::cout, label, after);
+    std::cout << "  " << milliseconds << " ms" << std::endl;
+
+    unsigned int failures = 0;
+    if (after.acmr() >= before.acmr() || after.atvr() >= before.atvr())
+    {
+        std::cout << "FAILED: the vertex cache ratios did not improve" << std::endl;
+        failures++;
+    }
+    if (optimized.indices.size() != input.indices.size() || optimized.vertices.size() != input.vertices.size())
+    {
+        std::cout << "FAILED: " << optimized.indices.size() / 3 << " triangles and " << optimized.vertices.size()
+                  << " vertices, expected " << input.indices.size() / 3 << " and " << input.vertices.size() << std::endl;
+        failures++;
+    }
+    else if (triangles(optimized) != triangles(input))
+    {
+        std::cout << "FAILED: triangles were lost, added or flipped" << std::endl;
+        failures++;
+    }
+    return failures;
+}
@@ -79,6 +79,7 @@ int main()
 
   std::vector<float> vertices;
   int depth = 0;
+  int uploadedDepth = -1;
 
   float size = 0.8f;
   float x1 = -size, y1 = -size / sqrt(3.0f);
@@ -104,14 +105,19 @@ int main()
   {
     // input
     processInput(window, &depth);
-    vertices.clear();
 
-    koch_snowflake(vertices, x1, y1, x2, y2, depth);
-    koch_snowflake(vertices, x2, y2, x3, y3, depth);
-    koch_snowflake(vertices, x3, y3, x1, y1, depth);
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    // the snowflake only changes with depth, rebuild and upload it then instead of every frame
+    if (depth != uploadedDepth)
+    {
+      vertices.clear();
+      koch_snowflake(vertices, x1, y1, x2, y2, depth);
+      koch_snowflake(vertices, x2, y2, x3, y3, depth);
+      koch_snowflake(vertices, x3, y3, x1, y1, depth);
+
+      glBindBuffer(GL_ARRAY_BUFFER, VBO);
+      glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+      uploadedDepth = depth;
+    }
 
     glClearColor(0.07f, 0.13f, 0.17f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
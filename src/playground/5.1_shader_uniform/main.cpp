@@ -1,5 +1,6 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
 #include <learnopengl/shader_s.h>
 #include <iostream>
 
@@ -63,6 +64,8 @@ int main()
 
     glUniform1i(glGetUniformLocation(ourShader.ID, "isDynamicColor"), GL_FALSE);
     glUniform1i(glGetUniformLocation(ourShader.ID, "isUpside"), GL_FALSE);
+    // set every frame, hashed at compile time instead of a location query per frame
+    static constexpr UniformName colorUniform("ourUniformColor");
 
 
     while (!glfwWindowShouldClose(window))
@@ -76,7 +79,7 @@ int main()
         float redValue = (cos(timeValue) + 1.0f) / 2.0f;
         float greenValue = (sin(timeValue) + 1.0f) / 2.0f;
         float blueValue = ((sin(timeValue) * -1) + 1.0f) / 2.0f;
-        glUniform4f(glGetUniformLocation(ourShader.ID, "ourUniformColor"), redValue, greenValue, blueValue, 1.0f);
+        ourShader.setVec4(colorUniform, glm::vec4(redValue, greenValue, blueValue, 1.0f));
         glBindVertexArray(VAO);
         glDrawArrays(GL_TRIANGLES, 0, 3);
         glfwSwapBuffers(window);
@@ -1,6 +1,8 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
 #include <learnopengl/shader_s.h>
+#include <learnopengl/stream_buffer.h>
 #include <iostream>
 #include <array>
 
@@ -51,25 +53,37 @@ int main()
     std::array<float, 6> v2 = {0.0f, 0.9f, 0.0f, 0.0f, 0.0f, 1.0f};
     std::vector<float> vertices;
 
-    unsigned int VBO, VAO;
+    // the resting triangle only changes with depth, it is uploaded once per depth into a static buffer
+    unsigned int VAO, VBO;
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glBindVertexArray(VAO);
-
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-
     // position attribute layout (location = 0)
     //(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer) *pointer is offset
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
-    
     // color attribute layout (location = 1)
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
+    int uploadedDepth = 0;
+    size_t uploadedCount = 0;
+
+    // while rotating the vertices are rewritten every frame, they go through a ring of per-frame regions
+    // instead of respecifying one buffer (which reallocates and may wait for the previous frame's draw)
+    StreamBuffer stream(GL_ARRAY_BUFFER);
+    unsigned int streamVAO;
+    glGenVertexArrays(1, &streamVAO);
+    glBindVertexArray(streamVAO);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+
+    double statsTime = glfwGetTime();
 
     glUniform1i(glGetUniformLocation(ourShader.ID, "isDynamicColor"), GL_FALSE);
     glUniform1i(glGetUniformLocation(ourShader.ID, "isUpside"), GL_FALSE);
+    // set every frame, hashed at compile time instead of a location query per frame
+    static constexpr UniformName colorUniform("ourUniformColor");
 
 
     while (!glfwWindowShouldClose(window))
@@ -77,33 +91,54 @@ int main()
         float timeValue = glfwGetTime();
         ourShader.use();
         processInput(window, ourShader.ID);
-        vertices.clear();
-        // Prepare triangle vertices, apply rotation if needed
-        std::array<float, 6> rv0 = v0, rv1 = v1, rv2 = v2;
+        size_t vertexCount;
         if (isRotate) {
+            // Prepare triangle vertices with the rotation of this frame
+            vertices.clear();
             float angle = timeValue; // radians
-            rv0 = rotate_vertex(v0, angle);
-            rv1 = rotate_vertex(v1, angle);
-            rv2 = rotate_vertex(v2, angle);
+            sierpinski(vertices, rotate_vertex(v0, angle), rotate_vertex(v1, angle), rotate_vertex(v2, angle), depth);
+            vertexCount = vertices.size() / 6;
+
+            // stream data only lives for one frame, write it and point the attributes at where it landed
+            const size_t offset = stream.write(vertices.data(), vertices.size() * sizeof(float));
+            glBindVertexArray(streamVAO);
+            glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)offset);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(offset + 3 * sizeof(float)));
+        } else {
+            if (depth != uploadedDepth) {
+                vertices.clear();
+                sierpinski(vertices, v0, v1, v2, depth);
+                glBindBuffer(GL_ARRAY_BUFFER, VBO);
+                glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+                uploadedDepth = depth;
+                uploadedCount = vertices.size() / 6;
+            }
+            vertexCount = uploadedCount;
+            glBindVertexArray(VAO);
         }
-
-        sierpinski(vertices, rv0, rv1, rv2, depth);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_DYNAMIC_DRAW);
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
         glUseProgram(ourShader.ID);
         float redValue = (cos(depth * timeValue) + 1.0f) / 2.0f;
         float greenValue = (sin(depth * timeValue) + 1.0f) / 2.0f;
         float blueValue = ((sin(depth * timeValue) * -1) + 1.0f) / 2.0f;
-        glUniform4f(glGetUniformLocation(ourShader.ID, "ourUniformColor"), redValue, greenValue, blueValue, 1.0f);
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 6);
+        ourShader.setVec4(colorUniform, glm::vec4(redValue, greenValue, blueValue, 1.0f));
+        glDrawArrays(GL_TRIANGLES, 0, vertexCount);
+        stream.nextFrame();
+
+        if (glfwGetTime() - statsTime >= 1.0) {
+            stream.stats.print(std::cout, stream.isPersistent() ? "persistent stream" : "orphaning stream");
+            stream.stats.reset();
+            statsTime = glfwGetTime();
+        }
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
     glDeleteVertexArrays(1, &VAO);
+    glDeleteVertexArrays(1, &streamVAO);
     glDeleteBuffers(1, &VBO);
+    stream.release();
     glfwTerminate();
     return 0;
 }
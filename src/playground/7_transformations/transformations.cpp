@@ -180,10 +180,10 @@ int main()
         float angleZ = atan2(dy, dx); // radians
         transform = glm::rotate(transform, angleZ, glm::vec3(0.0f, 0.0f, 1.0f));
 
-        // get matrix's uniform location and set matrix
+        // set the matrix through the shader's uniform table, the name is hashed at compile time
+        static constexpr UniformName transformUniform("transform");
         ourShader.use();
-        unsigned int transformLoc = glGetUniformLocation(ourShader.ID, "transform");
-        glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(transform));
+        ourShader.setMat4(transformUniform, transform);
 
         // render container
         glBindVertexArray(VAO);
@@ -9,6 +9,7 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/frame_uniforms.h>
 
 #include <iostream>
 
@@ -76,6 +77,7 @@ int main()
     // build and compile our shader zprogram
     // ------------------------------------
     Shader ourShader("camera.vs", "camera.fs");
+    FrameUniforms frame;
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
     // ------------------------------------------------------------------
@@ -210,6 +212,9 @@ int main()
     ourShader.setInt("texture2", 1);
 
 
+    // names set every frame, hashed at compile time
+    static constexpr UniformName modelUniform("model");
+
     // render loop
     // -----------
     while (!glfwWindowShouldClose(window))
@@ -238,13 +243,12 @@ int main()
         // activate shader
         ourShader.use();
 
-        // pass projection matrix to shader (note that in this case it could change every frame)
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        ourShader.setMat4("projection", projection);
-
-        // camera/view transformation
-        glm::mat4 view = camera.GetViewMatrix();
-        ourShader.setMat4("view", view);
+        // projection (note that in this case it could change every frame) and camera/view transformation,
+        // uploaded once for the FrameData block of every program
+        frame.data.projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        frame.data.view = camera.GetViewMatrix();
+        frame.data.viewPos = camera.Position;
+        frame.upload();
 
         // render boxes
         glBindVertexArray(VAO);
@@ -255,7 +259,7 @@ int main()
             model = glm::translate(model, cubePositions[i]);
             float angle = 20.0f * i;
             model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            ourShader.setMat4("model", model);
+            ourShader.setMat4(modelUniform, model);
 
             glDrawArrays(GL_TRIANGLES, 0, 36);
         }
@@ -271,6 +275,7 @@ int main()
     glDeleteVertexArrays(1, &VAO);
     glDeleteBuffers(1, &VBO);
 
+    frame.release();
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
@@ -8,6 +8,7 @@
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/frame_uniforms.h>
 #include <learnopengl/animator.h>
 #include <learnopengl/model_animation.h>
 
@@ -81,6 +82,8 @@ int main()
 	// build and compile shaders
 	// -------------------------
 	Shader ourShader("anim_model.vs", "anim_model.fs");
+	FrameUniforms frame;
+	ProgramCache::stats.print(std::cout, "program cache");
 
 	
 	// load models
@@ -93,6 +96,14 @@ int main()
 	// draw in wireframe
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
+	// table positions of the bone matrices, resolved once instead of building every element name each frame
+	std::vector<int> boneUniforms;
+	for (size_t i = 0; i < animator.GetFinalBoneMatrices().size(); ++i)
+		boneUniforms.push_back(ourShader.uniforms.indexOf("finalBonesMatrices[" + std::to_string(i) + "]"));
+
+	// names set every frame, hashed at compile time
+	static constexpr UniformName modelUniform("model");
+
 	// render loop
 	// -----------
 	while (!glfwWindowShouldClose(window))
@@ -116,22 +127,22 @@ int main()
 		// don't forget to enable shader before setting uniforms
 		ourShader.use();
 
-		// view/projection transformations
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-		glm::mat4 view = camera.GetViewMatrix();
-		ourShader.setMat4("projection", projection);
-		ourShader.setMat4("view", view);
+		// view/projection transformations, uploaded once for the FrameData block
+		frame.data.projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+		frame.data.view = camera.GetViewMatrix();
+		frame.data.viewPos = camera.Position;
+		frame.upload();
 
-        auto transforms = animator.GetFinalBoneMatrices();
-		for (int i = 0; i < transforms.size(); ++i)
-			ourShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
+		const std::vector<glm::mat4>& transforms = animator.GetFinalBoneMatrices();
+		for (size_t i = 0; i < transforms.size(); ++i)
+			ourShader.setMat4(boneUniforms[i], transforms[i]);
 
 
 		// render the loaded model
 		glm::mat4 model = glm::mat4(1.0f);
 		model = glm::translate(model, glm::vec3(0.0f, -0.4f, 0.0f)); // translate it down so it's at the center of the scene
 		model = glm::scale(model, glm::vec3(.5f, .5f, .5f));	// it's a bit too big for our scene, so scale it down
-		ourShader.setMat4("model", model);
+		ourShader.setMat4(modelUniform, model);
 		ourModel.Draw(ourShader);
 
 
@@ -141,6 +152,7 @@ int main()
 		glfwPollEvents();
 	}
 
+	frame.release();
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();